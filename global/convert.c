@@ -65,15 +65,15 @@ extern int use_color, fflag, gflag, Gflag, iflag, Iflag, Pflag;
 static REWRITE *rewrite;
 static char last_pattern[IDENTLEN];
 static int locked;
-static int (*code_fputs)(const char *s, FILE *op) = fputs;
+static void (*code_puts)(STRBUF *, const char *) = strbuf_puts;
 
 /**
- * fputs with coloring.
+ * strbuf_puts with coloring.
  */
-static int
-color_code_fputs(const char *string, FILE *op)
+static void
+color_code_puts(STRBUF *sb, const char *string)
 {
-	return fputs(rewrite_string(rewrite, string, 0), op);
+	strbuf_puts(sb, rewrite_string(rewrite, string, 0));
 }
 /**
  * set_color_method: setup ANSI escape sequence (SGR).
@@ -240,6 +240,56 @@ set_print0(void)
 {
 	newline = '\0';
 }
+/**
+ * Stuff for the --offset and --limit options.
+ * Lines are counted through all convert filters in a process,
+ * since a command may print through more than one filter (GTAGSLIBPATH).
+ */
+static int skip_count;			/**< lines to be skipped */
+static int rest_count = -1;		/**< lines to be printed, -1: unlimited */
+
+/**
+ * set_limit: set the range of lines to be printed.
+ *
+ *	@param[in]	offset	number of lines to be skipped
+ *	@param[in]	limit	max number of lines to be printed, 0: unlimited
+ */
+void
+set_limit(int offset, int limit)
+{
+	skip_count = offset;
+	rest_count = limit > 0 ? limit : -1;
+}
+/**
+ * limit_reached: whether no more line will be printed.
+ *
+ *	@return		1: reached the limit, 0: not yet
+ */
+int
+limit_reached(void)
+{
+	return rest_count == 0;
+}
+/**
+ * out_of_range: count a line and decide whether it should be printed.
+ * The completion command uses it directly, since it doesn't print through
+ * the convert filter.
+ *
+ *	@return		1: don't print the line, 0: print it
+ */
+int
+out_of_range(void)
+{
+	if (skip_count > 0) {
+		skip_count--;
+		return 1;
+	}
+	if (rest_count == 0)
+		return 1;
+	if (rest_count > 0)
+		rest_count--;
+	return 0;
+}
 /**
  * Path filter for the output of global(1).
  * The path name starts with "./" which is the project root directory.
@@ -343,6 +393,100 @@ convert_pathname(CONVERT *cv, const char *path)
 	}
 	return (const char *)path;
 }
+/**
+ * get_pathname: convert path name using the cache.
+ *
+ *	@param[in]	cv	CONVERT structure
+ *	@param[in]	path	path name
+ *	@return		converted path name
+ *
+ * Since records come grouped by file, the same path name is converted
+ * many times. The result is cached by path name, and the last one is
+ * checked first.
+ */
+static const char *
+get_pathname(CONVERT *cv, const char *path)
+{
+	struct sh_entry *sh = cv->last_path;
+
+	/* the coloring depends on the pattern */
+	if (use_color && Pflag)
+		return convert_pathname(cv, path);
+	if (sh == NULL || strcmp(sh->name, path)) {
+		sh = strhash_assign(cv->path_cache, path, 1);
+		if (sh->value == NULL)
+			sh->value = strhash_strdup(cv->path_cache, convert_pathname(cv, path), 0);
+		cv->last_path = sh;
+	}
+	return sh->value;
+}
+/**
+ * Output buffer.
+ * Records are formatted in a buffer, which is written in large blocks.
+ */
+#define CONVERT_BUFSIZE	65536
+
+/**
+ * flush_output: write the output buffer.
+ */
+static void
+flush_output(CONVERT *cv)
+{
+	if (strbuf_getlen(cv->ob) > 0) {
+		fwrite(strbuf_value(cv->ob), 1, strbuf_getlen(cv->ob), cv->op);
+		strbuf_reset(cv->ob);
+	}
+}
+/**
+ * put_newline: terminate a record.
+ */
+static void
+put_newline(CONVERT *cv)
+{
+	strbuf_putc(cv->ob, newline);
+	if (strbuf_getlen(cv->ob) >= CONVERT_BUFSIZE)
+		flush_output(cv);
+}
+/**
+ * put_number: put a number like printf("%*d").
+ *
+ *	@param[in]	sb	output buffer
+ *	@param[in]	n	number
+ *	@param[in]	width	minimum width (padded with blanks on the left)
+ */
+static void
+put_number(STRBUF *sb, int n, int width)
+{
+	char num[16];
+	char *p = num + sizeof(num);
+	unsigned int u = n < 0 ? -(unsigned int)n : (unsigned int)n;
+
+	do {
+		*--p = u % 10 + '0';
+		u /= 10;
+	} while (u);
+	if (n < 0)
+		*--p = '-';
+	for (width -= num + sizeof(num) - p; width > 0; width--)
+		strbuf_putc(sb, ' ');
+	strbuf_nputs(sb, p, num + sizeof(num) - p);
+}
+/**
+ * put_string: put a string like printf("%-*s").
+ *
+ *	@param[in]	sb	output buffer
+ *	@param[in]	s	string
+ *	@param[in]	width	minimum width (padded with blanks on the right)
+ */
+static void
+put_string(STRBUF *sb, const char *s, int width)
+{
+	int len = strlen(s);
+
+	strbuf_nputs(sb, s, len);
+	for (; len < width; len++)
+		strbuf_putc(sb, ' ');
+}
 /**
  * convert_open: open convert filter
  *
@@ -375,6 +519,8 @@ convert_open(int type, int format, const char *root, const char *cwd, const char
 	cv->format = format;
 	cv->op = op;
 	cv->db = db;
+	cv->ob = strbuf_open(CONVERT_BUFSIZE);
+	cv->path_cache = strhash_open(2048);
 	/*
 	 * open GPATH.
 	 */
@@ -383,11 +529,11 @@ convert_open(int type, int format, const char *root, const char *cwd, const char
 	/*
 	 * setup coloring.
 	 */
-	code_fputs = fputs;
+	code_puts = strbuf_puts;
 	if (use_color) {
 		set_color_method();
 		if (!Pflag)
-			code_fputs = color_code_fputs;
+			code_puts = color_code_puts;
 	}
 	return cv;
 }
@@ -409,6 +555,8 @@ convert_put(CONVERT *cv, const char *ctags_x)
 
 	if (cv->format == FORMAT_PATH)
 		die("convert_put: internal error.");	/* Use convert_put_path() */
+	if (out_of_range())
+		return;
 	/*
 	 * parse tag line.
 	 * Don't use split() function not to destroy line image.
@@ -462,65 +610,65 @@ convert_put(CONVERT *cv, const char *ctags_x)
 	path = decode_path(path);
 	switch (cv->format) {
 	case FORMAT_CTAGS:
-		fputs(tag, cv->op);
-		fputc('\t', cv->op);
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc('\t', cv->op);
-		fputs(lineno, cv->op);
+		strbuf_puts(cv->ob, tag);
+		strbuf_putc(cv->ob, '\t');
+		strbuf_puts(cv->ob, get_pathname(cv, path));
+		strbuf_putc(cv->ob, '\t');
+		strbuf_puts(cv->ob, lineno);
 		break;
 	case FORMAT_CTAGS_XID:
 		fid = gpath_path2fid(path, NULL);
 		if (fid == NULL)
 			die("convert_put: unknown file. '%s'", path);
-		fputs(fid, cv->op);
-		fputc(' ', cv->op);
+		strbuf_puts(cv->ob, fid);
+		strbuf_putc(cv->ob, ' ');
 		/* PASS THROUGH */
 	case FORMAT_CTAGS_X:
 		/*
 		 * print until path name.
 		 */
 		*tagnextp = tagnextc;
-		fputs(ctags_x, cv->op);
-		fputc(' ', cv->op);
+		strbuf_puts(cv->ob, ctags_x);
+		strbuf_putc(cv->ob, ' ');
 		/*
 		 * print path name and the rest.
 		 */
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc(' ', cv->op);
-		fputs(rest, cv->op);
+		strbuf_puts(cv->ob, get_pathname(cv, path));
+		strbuf_putc(cv->ob, ' ');
+		strbuf_puts(cv->ob, rest);
 		break;
 	case FORMAT_CTAGS_MOD:
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc('\t', cv->op);
-		fputs(lineno, cv->op);
-		fputc('\t', cv->op);
-		fputs(rest, cv->op);
+		strbuf_puts(cv->ob, get_pathname(cv, path));
+		strbuf_putc(cv->ob, '\t');
+		strbuf_puts(cv->ob, lineno);
+		strbuf_putc(cv->ob, '\t');
+		strbuf_puts(cv->ob, rest);
 		break;
 	case FORMAT_GREP:
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc(':', cv->op);
-		fputs(lineno, cv->op);
-		fputc(':', cv->op);
-		fputs(rest, cv->op);
+		strbuf_puts(cv->ob, get_pathname(cv, path));
+		strbuf_putc(cv->ob, ':');
+		strbuf_puts(cv->ob, lineno);
+		strbuf_putc(cv->ob, ':');
+		strbuf_puts(cv->ob, rest);
 		break;
 	case FORMAT_CSCOPE:
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc(' ', cv->op);
-		fputs(tag, cv->op);
-		fputc(' ', cv->op);
-		fputs(lineno, cv->op);
-		fputc(' ', cv->op);
+		strbuf_puts(cv->ob, get_pathname(cv, path));
+		strbuf_putc(cv->ob, ' ');
+		strbuf_puts(cv->ob, tag);
+		strbuf_putc(cv->ob, ' ');
+		strbuf_puts(cv->ob, lineno);
+		strbuf_putc(cv->ob, ' ');
 		for (; *rest && isspace(*rest); rest++)
 			;
 		if (*rest)
-			fputs(rest, cv->op);
+			strbuf_puts(cv->ob, rest);
 		else
-			fputs("<unknown>", cv->op);
+			strbuf_puts(cv->ob, "<unknown>");
 		break;
 	default:
 		die("unknown format type.");
 	}
-	(void)fputc(newline, cv->op);
+	put_newline(cv);
 }
 /**
  * convert_put_path: convert path into relative or absolute and print.
@@ -536,8 +684,10 @@ convert_put_path(CONVERT *cv, const char *pattern, const char *path)
 		set_color_tag(pattern);
 	if (cv->format != FORMAT_PATH)
 		die("convert_put_path: internal error.");
-	fputs(convert_pathname(cv, path), cv->op);
-	(void)fputc(newline, cv->op);
+	if (out_of_range())
+		return;
+	strbuf_puts(cv->ob, get_pathname(cv, path));
+	put_newline(cv);
 }
 /**
  * convert_put_using: convert path into relative or absolute and print.
@@ -552,6 +702,8 @@ convert_put_path(CONVERT *cv, const char *pattern, const char *path)
 void
 convert_put_using(CONVERT *cv, const char *tag, const char *path, int lineno, const char *rest, const char *fid)
 {
+	if (out_of_range())
+		return;
 	if (rest == NULL)
 		rest = "";	/* for safety */
 	if (use_color && !locked)
@@ -560,14 +712,14 @@ convert_put_using(CONVERT *cv, const char *tag, const char *path, int lineno, co
 		tag = cv->tag_for_display;
 	switch (cv->format) {
 	case FORMAT_PATH:
-		fputs(convert_pathname(cv, path), cv->op);
+		strbuf_puts(cv->ob, get_pathname(cv, path));
 		break;
 	case FORMAT_CTAGS:
-		fputs(tag, cv->op);
-		fputc('\t', cv->op);
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc('\t', cv->op);
-		fprintf(cv->op, "%d", lineno);
+		strbuf_puts(cv->ob, tag);
+		strbuf_putc(cv->ob, '\t');
+		strbuf_puts(cv->ob, get_pathname(cv, path));
+		strbuf_putc(cv->ob, '\t');
+		put_number(cv->ob, lineno, 0);
 		break;
 	case FORMAT_CTAGS_XID:
 		if (fid == NULL) {
@@ -575,50 +727,57 @@ convert_put_using(CONVERT *cv, const char *tag, const char *path, int lineno, co
 			if (fid == NULL)
 				die("convert_put_using: unknown file. '%s'", path);
 		}
-		fputs(fid, cv->op);
-		fputc(' ', cv->op);
+		strbuf_puts(cv->ob, fid);
+		strbuf_putc(cv->ob, ' ');
 		/* PASS THROUGH */
 	case FORMAT_CTAGS_X:
-		fprintf(cv->op, "%-16s %4d %-16s ",
-			tag, lineno, convert_pathname(cv, path));
-		code_fputs(rest, cv->op);
+		put_string(cv->ob, tag, 16);
+		strbuf_putc(cv->ob, ' ');
+		put_number(cv->ob, lineno, 4);
+		strbuf_putc(cv->ob, ' ');
+		put_string(cv->ob, get_pathname(cv, path), 16);
+		strbuf_putc(cv->ob, ' ');
+		code_puts(cv->ob, rest);
 		break;
 	case FORMAT_CTAGS_MOD:
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc('\t', cv->op);
-		fprintf(cv->op, "%d", lineno);
-		fputc('\t', cv->op);
-		code_fputs(rest, cv->op);
+		strbuf_puts(cv->ob, get_pathname(cv, path));
+		strbuf_putc(cv->ob, '\t');
+		put_number(cv->ob, lineno, 0);
+		strbuf_putc(cv->ob, '\t');
+		code_puts(cv->ob, rest);
 		break;
 	case FORMAT_GREP:
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc(':', cv->op);
-		fprintf(cv->op, "%d", lineno);
-		fputc(':', cv->op);
-		code_fputs(rest, cv->op);
+		strbuf_puts(cv->ob, get_pathname(cv, path));
+		strbuf_putc(cv->ob, ':');
+		put_number(cv->ob, lineno, 0);
+		strbuf_putc(cv->ob, ':');
+		code_puts(cv->ob, rest);
 		break;
 	case FORMAT_CSCOPE:
-		fputs(convert_pathname(cv, path), cv->op);
-		fputc(' ', cv->op);
-		fputs(tag, cv->op);
-		fputc(' ', cv->op);
-		fprintf(cv->op, "%d", lineno);
-		fputc(' ', cv->op);
+		strbuf_puts(cv->ob, get_pathname(cv, path));
+		strbuf_putc(cv->ob, ' ');
+		strbuf_puts(cv->ob, tag);
+		strbuf_putc(cv->ob, ' ');
+		put_number(cv->ob, lineno, 0);
+		strbuf_putc(cv->ob, ' ');
 		for (; *rest && isspace(*rest); rest++)
 			;
 		if (*rest)
-			code_fputs(rest, cv->op);
+			code_puts(cv->ob, rest);
 		else
-			fputs("<unknown>", cv->op);
+			strbuf_puts(cv->ob, "<unknown>");
 		break;
 	default:
 		die("unknown format type.");
 	}
-	(void)fputc(newline, cv->op);
+	put_newline(cv);
 }
 void
 convert_close(CONVERT *cv)
 {
+	flush_output(cv);
+	strbuf_close(cv->ob);
+	strhash_close(cv->path_cache);
 	strbuf_close(cv->abspath);
 	gpath_close();
 	free(cv);
@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include "gparam.h"
 #include "strbuf.h"
+#include "strhash.h"
 
 typedef struct {
 	FILE *op;
@@ -32,9 +33,15 @@ typedef struct {
 	int start_point;
 	int db;			/**< for gtags-cscope */
 	char *tag_for_display;
+	STRBUF *ob;		/**< output buffer */
+	STRHASH *path_cache;	/**< converted path names */
+	struct sh_entry *last_path;	/**< the last entry of path_cache */
 } CONVERT;
 
 void set_print0(void);
+void set_limit(int, int);
+int limit_reached(void);
+int out_of_range(void);
 CONVERT *convert_open(int, int, const char *, const char *, const char *, FILE *, int);
 void convert_put(CONVERT *, const char *);
 void convert_put_path(CONVERT *, const char *, const char *);
@@ -51,7 +51,9 @@
 #include "const.h"
 #include "output.h"
 #include "literal.h"
+#include "regexsearch.h"
 #include "convert.h"
+#include "srccache.h"
 
 /*
  * ensure GTAGSLIBPATH compares correctly
@@ -91,6 +93,7 @@ void completion_path(const char *, const char *);
 void idutils(const char *, const char *);
 void grep(const char *, char *const *, const char *);
 void pathlist(const char *, const char *);
+void includedby(const char *, const char *);
 void parsefile(char *const *, const char *, const char *, const char *, int);
 int search(const char *, const char *, const char *, const char *, int);
 void tagsearch(const char *, const char *, const char *, const char *, int);
@@ -129,7 +132,10 @@ int nofilter;
 int nosource;				/**< undocumented command */
 int debug;
 int literal;				/**< 1: literal search	*/
+int subword;				/**< 1: subword search	*/
 int print0;				/**< --print0 option	*/
+int limit;				/**< --limit option	*/
+int offset;				/**< --offset option	*/
 int format;
 int type;				/**< path conversion type */
 int match_part;				/**< match part only	*/
@@ -180,6 +186,9 @@ help(void)
 #define OPT_GTAGSCONF		136
 #define OPT_GTAGSLABEL		137
 #define OPT_PRINT		138
+#define OPT_INCLUDED_BY		139
+#define OPT_LIMIT		140
+#define OPT_OFFSET		141
 #define SORT_FILTER     1
 #define PATH_FILTER     2
 #define BOTH_FILTER     (SORT_FILTER|PATH_FILTER)
@@ -225,11 +234,14 @@ static struct option const long_options[] = {
 	{"color", optional_argument, NULL, OPT_USE_COLOR},
 	{"encode-path", required_argument, NULL, OPT_ENCODE_PATH},
 	{"from-here", required_argument, NULL, OPT_FROM_HERE},
+	{"included-by", no_argument, NULL, OPT_INCLUDED_BY},
 	{"debug", no_argument, &debug, 1},
 	{"gtagsconf", required_argument, NULL, OPT_GTAGSCONF},
 	{"gtagslabel", required_argument, NULL, OPT_GTAGSLABEL},
+	{"limit", required_argument, NULL, OPT_LIMIT},
 	{"literal", no_argument, &literal, 1},
 	{"match-part", required_argument, NULL, OPT_MATCH_PART},
+	{"offset", required_argument, NULL, OPT_OFFSET},
 	{"path-style", required_argument, NULL, OPT_PATH_STYLE},
 	{"path-convert", required_argument, NULL, OPT_PATH_CONVERT},
 	{"print", required_argument, NULL, OPT_PRINT},
@@ -239,6 +251,7 @@ static struct option const long_options[] = {
 	{"result", required_argument, NULL, OPT_RESULT},
 	{"nosource", no_argument, &nosource, 1},
 	{"single-update", required_argument, NULL, OPT_SINGLE_UPDATE},
+	{"subword", no_argument, &subword, 1},
 	{ 0 }
 };
 
@@ -316,6 +329,7 @@ decide_tag_by_context(const char *tag, const char *file, int lineno)
 				/*
 				 * Standard format	n <blank> <image>$
 				 * Compact format	d,d,d,d$
+				 *			d,d,d,d <blank> <offset>,...$
 				 */
 				if (!(gtop->format & GTAGS_COMPACT)) {	/* Standard format */
 					if (atoi(p) == lineno) {
@@ -346,13 +360,13 @@ decide_tag_by_context(const char *tag, const char *file, int lineno)
 							}
 							last = cur;
 						}
-						if (*p) {
+						if (*p && *p != ' ') {
 							if (*p == ',')
 								p++;
 							else
 								die("Impossible! decide_tag_by_context(4)");
 						}
-					} while (*p);
+					} while (*p && *p != ' ');
 				}
 			}
 		}
@@ -597,6 +611,18 @@ main(int argc, char **argv)
 		case OPT_PRINT:
 			print_target = optarg;
 			break;
+		case OPT_INCLUDED_BY:
+			setcom(optchar);
+			break;
+		case OPT_LIMIT:
+			if (!isdigit((unsigned char)*optarg) || (limit = atoi(optarg)) <= 0)
+				die_with_code(2, "invalid number for the --limit option.");
+			break;
+		case OPT_OFFSET:
+			if (!isdigit((unsigned char)*optarg))
+				die_with_code(2, "invalid number for the --offset option.");
+			offset = atoi(optarg);
+			break;
 		case OPT_RESULT:
 			if (!strcmp(optarg, "ctags-x"))
 				format = FORMAT_CTAGS_X;
@@ -790,6 +816,8 @@ main(int argc, char **argv)
 		nosource = 1;	/* to keep compatibility */
 	if (print0)
 		set_print0();
+	if (limit || offset)
+		set_limit(offset, limit);
 	if (cflag && match_part == 0)
 		match_part = MATCH_PART_ALL;
 	/*
@@ -969,6 +997,13 @@ main(int argc, char **argv)
 		chdir(root);
 		pathlist(av, dbpath);
 	}
+	/*
+	 * locate files including the file.
+	 */
+	else if (command == OPT_INCLUDED_BY) {
+		chdir(root);
+		includedby(av, dbpath);
+	}
 	/*
 	 * parse source files.
 	 */
@@ -997,16 +1032,37 @@ int
 completion_tags(const char *dbpath, const char *root, const char *prefix, int db)
 {
 	int flags = GTOP_KEY | GTOP_NOREGEX | GTOP_PREFIX;
-	GTOP *gtop = gtags_open(dbpath, root, db, GTAGS_READ, 0);
+	NAMEINDEX *ni;
+	GTOP *gtop;
 	GTP *gtp;
+	const char *name;
 	int count = 0;
 
+	/*
+	 * Use the name index (GNAMES) if it is available and up to date.
+	 */
+	if ((ni = nameindex_open(dbpath)) != NULL) {
+		for (name = nameindex_first(ni, prefix, db, iflag ? NAMEINDEX_IGNORECASE : 0);
+		     name && !limit_reached();
+		     name = nameindex_next(ni)) {
+			count++;
+			if (out_of_range())
+				continue;
+			fputs(name, stdout);
+			fputc('\n', stdout);
+		}
+		nameindex_close(ni);
+		return count;
+	}
+	gtop = gtags_open(dbpath, root, db, GTAGS_READ, 0);
 	if (iflag)
 		flags |= GTOP_IGNORECASE;
-	for (gtp = gtags_first(gtop, prefix, flags); gtp; gtp = gtags_next(gtop)) {
+	for (gtp = gtags_first(gtop, prefix, flags); gtp && !limit_reached(); gtp = gtags_next(gtop)) {
+		count++;
+		if (out_of_range())
+			continue;
 		fputs(gtp->tag, stdout);
 		fputc('\n', stdout);
-		count++;
 	}
 	if (debug)
 		gtags_show_statistics(gtop);
@@ -1042,7 +1098,7 @@ completion(const char *dbpath, const char *root, const char *prefix, int db)
 		/*
 		 * search for each tree in the library path.
 		 */
-		for (libdir = strbuf_value(sb); libdir; libdir = nextp) {
+		for (libdir = strbuf_value(sb); libdir && !limit_reached(); libdir = nextp) {
 			if ((nextp = locatestring(libdir, PATHSEP, MATCH_FIRST)) != NULL)
 				*nextp++ = 0;
 			if (!gtagsexist(libdir, libdbpath, sizeof(libdbpath), 0))
@@ -1151,6 +1207,8 @@ completion_idutils(const char *dbpath, const char *root, const char *prefix)
 			continue;
 		}
 		*p = '\0';
+		if (out_of_range())
+			continue;
 		puts(line);
 	}
 #if (defined(_WIN32) && !defined(__CYGWIN__)) || defined(__DJGPP__)
@@ -1214,7 +1272,9 @@ completion_path(const char *dbpath, const char *prefix)
 		}
 	}
 	gfind_close(gp);
-	for (path = dbop_first(dbop, NULL, NULL, DBOP_KEY); path != NULL; path = dbop_next(dbop)) {
+	for (path = dbop_first(dbop, NULL, NULL, DBOP_KEY); path != NULL && !limit_reached(); path = dbop_next(dbop)) {
+		if (out_of_range())
+			continue;
 		fputs(path, stdout);
 		fputc('\n', stdout);
 	}
@@ -1426,6 +1486,39 @@ idutils(const char *pattern, const char *dbpath)
 		fprintf(stderr, " (using idutils index in '%s').\n", dbpath);
 	}
 }
+/**
+ * gfind_readahead: read a path name through the read-ahead queue.
+ *
+ *	@param[in]	gp	GFIND structure
+ *	@param[out]	fid	file id
+ *	@return		path name, NULL: end of list
+ *
+ * The following SRCCACHE_READAHEAD files are read in advance,
+ * so that the I/O overlaps with the search of the preceding files.
+ */
+static const char *
+gfind_readahead(GFIND *gp, const char **fid)
+{
+	static struct {
+		char path[MAXPATHLEN];
+		char fid[MAXFIDLEN];
+	} queue[SRCCACHE_READAHEAD];
+	static int head, tail;
+	const char *path;
+	int i;
+
+	while (tail - head < SRCCACHE_READAHEAD && (path = args_read()) != NULL) {
+		i = tail++ % SRCCACHE_READAHEAD;
+		strlimcpy(queue[i].path, path, sizeof(queue[i].path));
+		strlimcpy(queue[i].fid, gp->dbop->lastdat, sizeof(queue[i].fid));
+		srccache_prefetch(path);
+	}
+	if (head == tail)
+		return NULL;
+	i = head++ % SRCCACHE_READAHEAD;
+	*fid = queue[i].fid;
+	return queue[i].path;
+}
 /**
  * grep: grep pattern
  *
@@ -1436,17 +1529,12 @@ idutils(const char *pattern, const char *dbpath)
 void
 grep(const char *pattern, char *const *argv, const char *dbpath)
 {
-	FILE *fp;
 	CONVERT *cv;
 	GFIND *gp = NULL;
-	STRBUF *ib = strbuf_open(MAXBUFLEN);
-	const char *path;
+	const char *path, *fid = NULL;
 	char encoded_pattern[IDENTLEN];
-	const char *buffer;
-	int linenum, count;
-	int flags = 0;
+	int count;
 	int target = GPATH_SOURCE;
-	regex_t	preg;
 	int user_specified = 1;
 	int gfind_flags = 0;
 
@@ -1476,16 +1564,10 @@ grep(const char *pattern, char *const *argv, const char *dbpath)
 		target = GPATH_OTHER;
 	if (Nflag)
 		gfind_flags |= GPATH_NEARSORT;
-	if (literal) {
+	if (literal)
 		literal_comple(pattern);
-	} else {
-		if (!Gflag)
-			flags |= REG_EXTENDED;
-		if (iflag)
-			flags |= REG_ICASE;
-		if (regcomp(&preg, pattern, flags) != 0)
-			die("invalid regular expression.");
-	}
+	else
+		regex_comple(pattern, Gflag, iflag);
 	cv = convert_open(type, format, root, cwd, dbpath, stdout, NOTAGS);
 	cv->tag_for_display = encoded_pattern;
 	count = 0;
@@ -1500,7 +1582,7 @@ grep(const char *pattern, char *const *argv, const char *dbpath)
 		args_open_gfind(gp = gfind_open(dbpath, localprefix, target, gfind_flags));
 		user_specified = 0;
 	}
-	while ((path = args_read()) != NULL) {
+	while ((path = user_specified ? args_read() : gfind_readahead(gp, &fid)) != NULL && !limit_reached()) {
 		if (user_specified) {
 			static char buf[MAXPATHLEN];
 
@@ -1525,31 +1607,16 @@ grep(const char *pattern, char *const *argv, const char *dbpath)
 			if (n > 0)
 				count += n;
 		} else {
-			if (!(fp = fopen(path, "r")))
-				die("cannot open file '%s'.", path);
-			linenum = 0;
-			while ((buffer = strbuf_fgets(ib, fp, STRBUF_NOCRLF)) != NULL) {
-				int result = regexec(&preg, buffer, 0, 0, 0);
-				linenum++;
-				if ((!Vflag && result == 0) || (Vflag && result != 0)) {
-					count++;
-					if (format == FORMAT_PATH) {
-						convert_put_path(cv, NULL, path);
-						break;
-					} else {
-						convert_put_using(cv, pattern, path, linenum, buffer,
-							(user_specified) ? NULL : gp->dbop->lastdat);
-					}
-				}
-			}
-			fclose(fp);
+			int n = regex_search(cv, path, fid);
+			if (n > 0)
+				count += n;
 		}
 	}
 	args_close();
 	convert_close(cv);
-	strbuf_close(ib);
+	srccache_close();
 	if (literal == 0)
-		regfree(&preg);
+		regex_close();
 	if (vflag) {
 		print_count(count);
 		fprintf(stderr, " (no index used).\n");
@@ -1610,7 +1677,7 @@ pathlist(const char *pattern, const char *dbpath)
 	count = 0;
 
 	gp = gfind_open(dbpath, localprefix, target, gfind_flags);
-	while ((path = gfind_read(gp)) != NULL) {
+	while ((path = gfind_read(gp)) != NULL && !limit_reached()) {
 		/*
 		 * skip localprefix because end-user doesn't see it.
 		 */
@@ -1647,6 +1714,102 @@ pathlist(const char *pattern, const char *dbpath)
 		fprintf(stderr, " (using '%s').\n", makepath(dbpath, dbname(GPATH), NULL));
 	}
 }
+/*
+ * Include reference read from GINCLUDE.
+ */
+struct incref {
+	char *path;
+	int lineno;
+	char *image;
+	char fid[MAXFIDLEN];
+};
+static int
+compare_incref(const void *v1, const void *v2)
+{
+	const struct incref *r1 = v1, *r2 = v2;
+	int ret;
+
+	if ((ret = strcmp(r1->path, r2->path)) != 0)
+		return ret;
+	return r1->lineno - r2->lineno;
+}
+/**
+ * includedby: print files which include the specified file.
+ *
+ *	@param[in]	name	file name (only the last name is used)
+ *	@param[in]	dbpath
+ *
+ * This command reads the include graph (GINCLUDE) made by gtags(1).
+ */
+void
+includedby(const char *name, const char *dbpath)
+{
+	VARRAY *vb = varray_open(sizeof(struct incref), 32);
+	GINCLUDE *ginc;
+	GINCREC *rec;
+	CONVERT *cv;
+	struct incref *ref;
+	const char *last = include_lastname(name);
+	const char *path, *prev = NULL;
+	int i, count = 0;
+
+	if ((ginc = ginclude_open(dbpath, GTAGS_READ)) == NULL)
+		die("%s not found. Please remake tag files by invoking gtags(1).", GINCLUDE_NAME);
+	if (gpath_open(dbpath, 0) < 0)
+		die("GPATH not found.");
+	if (!localprefix)
+		localprefix = "./";
+	for (rec = ginclude_first(ginc, last); rec; rec = ginclude_next(ginc)) {
+		if ((path = gpath_fid2path(rec->fid, NULL)) == NULL)
+			continue;
+		if (strncmp(path, localprefix, strlen(localprefix)))
+			continue;
+		ref = varray_append(vb);
+		ref->path = check_strdup(path);
+		ref->lineno = rec->lineno;
+		ref->image = check_strdup(rec->image);
+		strlimcpy(ref->fid, rec->fid, sizeof(ref->fid));
+	}
+	gpath_close();
+	ginclude_close(ginc);
+	if (vb->length > 0)
+		qsort(varray_assign(vb, 0, 0), vb->length, sizeof(struct incref), compare_incref);
+	cv = convert_open(type, format, root, cwd, dbpath, stdout, NOTAGS);
+	for (i = 0; i < vb->length; i++) {
+		ref = varray_assign(vb, i, 0);
+		if (format == FORMAT_PATH) {
+			if (prev == NULL || strcmp(prev, ref->path)) {
+				convert_put_path(cv, NULL, ref->path);
+				count++;
+			}
+		} else {
+			convert_put_using(cv, last, ref->path, ref->lineno, ref->image, ref->fid);
+			count++;
+		}
+		prev = ref->path;
+	}
+	convert_close(cv);
+	for (i = 0; i < vb->length; i++) {
+		ref = varray_assign(vb, i, 0);
+		free(ref->path);
+		free(ref->image);
+	}
+	varray_close(vb);
+	if (vflag) {
+		switch (count) {
+		case 0:
+			fprintf(stderr, "object not found");
+			break;
+		case 1:
+			fprintf(stderr, "1 object located");
+			break;
+		default:
+			fprintf(stderr, "%d objects located", count);
+			break;
+		}
+		fprintf(stderr, " (using '%s').\n", makepath(dbpath, GINCLUDE_NAME, NULL));
+	}
+}
 /**
  * void parsefile(char *const *argv, const char *cwd, const char *root, const char *dbpath, int db)
  *
@@ -1833,6 +1996,29 @@ parsefile(char *const *argv, const char *cwd, const char *root, const char *dbpa
 		fprintf(stderr, " (no index used).\n");
 	}
 }
+/**
+ * get_scope: get file ids of the source files in the scope (-S, -l).
+ *
+ *	@param[in]	dbpath		database directory
+ *	@return			set of file ids
+ *
+ * [Note] GPATH should be opened by gtags_open().
+ */
+static IDSET *
+get_scope(const char *dbpath)
+{
+	IDSET *fidset = idset_open(gpath_nextkey());
+	GFIND *gp = gfind_open(dbpath, localprefix, GPATH_SOURCE, 0);
+	const char *path, *fid;
+
+	while ((path = gfind_read(gp)) != NULL) {
+		fid = gpath_path2fid(path, NULL);
+		if (fid != NULL)
+			idset_add(fidset, atoi(fid));
+	}
+	gfind_close(gp);
+	return fidset;
+}
 /**
  * search: search specified function 
  *
@@ -1850,6 +2036,7 @@ search(const char *pattern, const char *root, const char *cwd, const char *dbpat
 	int count = 0;
 	GTOP *gtop;
 	GTP *gtp;
+	IDSET *scope_fidset = NULL;
 	int flags = 0;
 
 	start_output();
@@ -1865,7 +2052,9 @@ search(const char *pattern, const char *root, const char *cwd, const char *dbpat
 		flags |= GTOP_NOSORT;
 	else if (Nflag)
 		flags |= GTOP_NEARSORT;
-	if (literal)
+	if (subword)
+		flags |= GTOP_SUBWORD;
+	else if (literal)
 		flags |= GTOP_NOREGEX;
 	else if (Gflag)
 		flags |= GTOP_BASICREGEX;
@@ -1873,15 +2062,31 @@ search(const char *pattern, const char *root, const char *cwd, const char *dbpat
 		flags |= GTOP_PATH;
 	if (iflag)
 		flags |= GTOP_IGNORECASE;
+	/*
+	 * Records out of the scope are filtered by file id while reading,
+	 * so that blocks of posting lists out of the scope are skipped.
+	 */
+	if (Sflag) {
+		scope_fidset = get_scope(dbpath);
+		gtags_setfidset(gtop, scope_fidset);
+	}
+	/*
+	 * Each record makes one line at least.
+	 */
+	if (limit)
+		gtags_setlimit(gtop, offset + limit);
 	for (gtp = gtags_first(gtop, pattern, flags); gtp; gtp = gtags_next(gtop)) {
-		if (Sflag && !locatestring(gtp->path, localprefix, MATCH_AT_FIRST))
-			continue;
+		readahead_output(gtop, root);
 		count += output_with_formatting(cv, gtp, root, gtop->format);
+		if (limit_reached())
+			break;
 	}
 	convert_close(cv);
 	if (debug)
 		gtags_show_statistics(gtop);
 	gtags_close(gtop);
+	if (scope_fidset)
+		idset_close(scope_fidset);
 	end_output();
 	return count;
 }
@@ -1904,7 +2109,7 @@ tagsearch(const char *pattern, const char *cwd, const char *root, const char *db
 	/*
 	 * trim pattern (^<no regex>$ => <no regex>)
 	 */
-	if (!literal && pattern) {
+	if (!literal && !subword && pattern) {
 		strlimcpy(p, pattern, sizeof(buffer));
 		if (*p++ == '^') {
 			char *q = p + strlen(p);
@@ -1934,7 +2139,7 @@ tagsearch(const char *pattern, const char *cwd, const char *root, const char *db
 		/*
 		 * search for each tree in the library path.
 		 */
-		for (libdir = strbuf_value(sb); libdir; libdir = nextp) {
+		for (libdir = strbuf_value(sb); libdir && !limit_reached(); libdir = nextp) {
 			if ((nextp = locatestring(libdir, PATHSEP, MATCH_FIRST)) != NULL)
 				*nextp++ = 0;
 			if (!gtagsexist(libdir, libdbpath, sizeof(libdbpath), 0))
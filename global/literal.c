@@ -30,32 +30,16 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <sys/param.h>
-#include <sys/stat.h>
 #include <errno.h>
 #ifdef STDC_HEADERS
 #include <stdlib.h>
 #endif
-#ifdef HAVE_MMAP
-#include <sys/mman.h>
-#elif _WIN32
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-#endif
-#ifdef HAVE_FCNTL_H
-#include <fcntl.h>
-#endif
-#ifdef HAVE_UNISTD_H
-#include <unistd.h>
-#endif
 #include "format.h"
 #include "convert.h"
 #include "die.h"
+#include "srccache.h"
 #include "strlimcpy.h"
 
-#ifndef O_BINARY
-#define O_BINARY 0
-#endif
-
 void overflo(void);
 void cgotofn(const char *);
 void cfail(void);
@@ -115,49 +99,22 @@ literal_search(CONVERT *cv, const char *file)
 # define lca(x) (isupper(x) ? tolower(x) : x)
 	struct words *c;
 	int ccount;
-	char *p;
-	char *buf;
-	struct stat stb;
-	char *linep;
+	const char *p;
+	const char *buf;
+	const char *linep;
 	long lineno;
-	int f;
+	SRCFILE *sf;
 	int count = 0;
 
-	if ((f = open(file, O_BINARY)) < 0) {
+	if ((sf = srccache_open(file)) == NULL) {
 		warning("cannot open '%s'.", file);
 		return -1;
 	}
-	if (fstat(f, &stb) < 0) {
-		warning("cannot fstat '%s'.", file);
-		goto skip_empty_file;
-	}
-	if (stb.st_size == 0)
-		goto skip_empty_file;
-#ifdef HAVE_MMAP
-	buf = mmap(0, stb.st_size, PROT_READ, MAP_SHARED, f, 0);
-	if (buf == MAP_FAILED)
-		die("mmap failed (%s).", file);
-#elif _WIN32
-	{
-	HANDLE hMap = CreateFileMapping((HANDLE)_get_osfhandle(f), NULL, PAGE_READONLY, 0, stb.st_size, NULL);
-	if (hMap == NULL)
-		die("CreateFileMapping failed (%s).", file);
-	buf = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
-	if (buf == NULL)
-		die("MapViewOfFile failed (%s).", file);
-#else
-#ifdef HAVE_ALLOCA
-	buf = (char *)alloca(stb.st_size);
-#else
-	buf = (char *)malloc(stb.st_size);
-#endif
-	if (buf == NULL)
-		die("short of memory.");
-	if (read(f, buf, stb.st_size) < stb.st_size)
-		die("read failed (%s).", file);
-#endif
+	if (sf->size == 0)
+		return 0;
+	buf = sf->buf;
 	linep = p = buf;
-	ccount = stb.st_size;
+	ccount = sf->size;
 	lineno = 1;
 	c = w;
 	for (;;) {
@@ -223,18 +180,6 @@ literal_search(CONVERT *cv, const char *file)
 		}
 	}
 finish:
-#ifdef HAVE_MMAP
-	munmap(buf, stb.st_size);
-#elif _WIN32
-	UnmapViewOfFile(buf);
-	CloseHandle(hMap);
-	}
-#elif HAVE_ALLOCA
-#else
-	free(buf);
-#endif
-skip_empty_file:
-	close(f);
 	return count;
 }
 /**
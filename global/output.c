@@ -26,19 +26,19 @@
 #include <stdio.h>
 #include "global.h"
 #include "convert.h"
+#include "srccache.h"
 
 /**
  * Stuff for the compact format
  */
 static char curpath[MAXPATHLEN];	/**< current path */
-static char curtag[IDENTLEN];		/**< current tag */
-static int cur_lineno;			/**< current line number */
 static int last_lineno;			/**< last line number */
-static FILE *fp;			/**< file descripter */
+static SRCFILE *sf;			/**< source file in the cache */
 static const char *src;			/**< source code */
 
 static int put_compact_format(CONVERT *, GTP *, const char *, int);
 static void put_standard_format(CONVERT *, GTP *, int);
+static const char *get_line(int, int);
 extern const char *root;
 extern int nosource;
 extern int format;
@@ -56,9 +56,9 @@ static STRBUF *sb_uncompress;
 void
 start_output(void)
 {
-	curpath[0] = curtag[0] = '\0';
-	cur_lineno = last_lineno = 0;
-	fp = NULL;
+	curpath[0] = '\0';
+	last_lineno = 0;
+	sf = NULL;
 	src = "";
 	sb_uncompress = strbuf_open(0);
 }
@@ -67,8 +67,8 @@ end_output(void)
 {
 	if (sb_uncompress)
 		strbuf_close(sb_uncompress);
-	if (fp)
-		fclose(fp);
+	srccache_close();
+	sf = NULL;
 }
 /**
  * output_with_formatting: pass records to the convert filter.
@@ -95,19 +95,59 @@ output_with_formatting(CONVERT *cv, GTP *gtp, const char *root, int flags)
 	}
 	return count;
 }
+/**
+ * readahead_output: read ahead the source files of the following records.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	root	project root directory
+ *
+ * The records of the current segment are already in memory.
+ * The source files of the next SRCCACHE_READAHEAD records are read
+ * in advance, while the preceding records are printed.
+ */
+void
+readahead_output(GTOP *gtop, const char *root)
+{
+	static GTOP *cur;		/**< GTOP of the segment */
+	static char tag[IDENTLEN];	/**< tag name of the segment */
+	static int next;		/**< next record to be read ahead */
+	static const char *last;	/**< path of the last file read ahead */
+	int end;
+
+	if (nosource || format == FORMAT_PATH || !(gtop->format & GTAGS_COMPACT))
+		return;
+	if (cur != gtop || strcmp(tag, gtop->cur_tagname) != 0 || next < gtop->gtp_index) {
+		cur = gtop;
+		strlimcpy(tag, gtop->cur_tagname, sizeof(tag));
+		next = gtop->gtp_index;
+		last = NULL;
+	}
+	end = gtop->gtp_index + SRCCACHE_READAHEAD;
+	if (end > gtop->gtp_count)
+		end = gtop->gtp_count;
+	for (; next < end; next++) {
+		const char *path = gtop->gtp_array[next].path;
+
+		/*
+		 * Records of a file are successive, and have the same
+		 * path pointer which segment_read() cached.
+		 */
+		if (path != last)
+			srccache_prefetch(makepath(root, path, NULL));
+		last = path;
+	}
+}
 /*
  * Compact format:
  */
 static int
 put_compact_format(CONVERT *cv, GTP *gtp, const char *root, int flags)
 {
-	STATIC_STRBUF(ib);
 	int count = 0;
 	char *p = (char *)gtp->tagline;
 	const char *fid, *tagname;
 	int n = 0;
 
-	strbuf_clear(ib);
 	/*                    a          b
 	 * tagline = <file id> <tag name> <line no>,...
 	 */
@@ -120,30 +160,22 @@ put_compact_format(CONVERT *cv, GTP *gtp, const char *root, int flags)
 		p++;
 	*p++ = '\0';			/* b */
 	/*
-	 * Reopen or rewind source file.
+	 * Take source file from the cache.
 	 */
 	if (!nosource) {
 		if (strcmp(gtp->path, curpath) != 0) {
-			if (curpath[0] != '\0' && fp != NULL)
-				fclose(fp);
-			strlimcpy(curtag, tagname, sizeof(curtag));
 			strlimcpy(curpath, gtp->path, sizeof(curpath));
 			/*
 			 * Use absolute path name to support GTAGSROOT
 			 * environment variable.
 			 */
-			fp = fopen(makepath(root, curpath, NULL), "r");
-			if (fp == NULL)
+			sf = srccache_open(makepath(root, curpath, NULL));
+			if (sf == NULL) {
 				warning("source file '%s' is not available.", curpath);
-			last_lineno = cur_lineno = 0;
-		} else if (strcmp(gtp->tag, curtag) != 0) {
-			strlimcpy(curtag, gtp->tag, sizeof(curtag));
-			if (atoi(p) < last_lineno && fp != NULL) {
-				rewind(fp);
-				cur_lineno = 0;
+				src = "";
 			}
-			last_lineno = 0;
 		}
+		last_lineno = 0;
 	}
 	/*
 	 * Unfold compact format.
@@ -157,9 +189,18 @@ put_compact_format(CONVERT *cv, GTP *gtp, const char *root, int flags)
 		 * If GTAGS_COMPLINE flag is set, each line number is expressed as
 		 * the difference from the previous line number except for the head.
 		 * Please see flush_pool() in libutil/gtagsop.c for the details.
+		 * If GTAGS_COMPOFFSET flag is set, the byte offsets of the lines
+		 * follow in the same way.
 		 */
-		int last = 0, cont = 0;
+		int last = 0, cont = 0, offset = -1;
+		char *q = NULL;
 
+		if (flags & GTAGS_COMPOFFSET) {
+			if ((q = strchr(p, ' ')) == NULL)
+				die("invalid compact format.");
+			*q++ = '\0';
+			offset = 0;
+		}
 		while (*p || cont > 0) {
 			if (cont > 0) {
 				n = last + 1;
@@ -177,17 +218,17 @@ put_compact_format(CONVERT *cv, GTP *gtp, const char *root, int flags)
 				GET_NEXT_NUMBER(p);
 				n += last;
 			}
-			if (last_lineno != n && fp) {
-				while (cur_lineno < n) {
-					if (!(src = strbuf_fgets(ib, fp, STRBUF_NOCRLF))) {
-						src = "";
-						fclose(fp);
-						fp = NULL;
-						break;
-					}
-					cur_lineno++;
-				}
+			if (q) {
+				int d;
+
+				if (*q == ',')
+					q++;
+				for (d = 0; isdigit(*q); q++)
+					d = d * 10 + (*q - '0');
+				offset += d;
 			}
+			if (last_lineno != n && sf)
+				src = get_line(n, offset);
 			convert_put_using(cv, tagname, gtp->path, n, src, fid);
 			count++;
 			last_lineno = last = n;
@@ -205,17 +246,8 @@ put_compact_format(CONVERT *cv, GTP *gtp, const char *root, int flags)
 				p++;
 			if (last_lineno == n)
 				continue;
-			if (last_lineno != n && fp) {
-				while (cur_lineno < n) {
-					if (!(src = strbuf_fgets(ib, fp, STRBUF_NOCRLF))) {
-						src = "";
-						fclose(fp);
-						fp = NULL;
-						break;
-					}
-					cur_lineno++;
-				}
-			}
+			if (last_lineno != n && sf)
+				src = get_line(n, -1);
 			convert_put_using(cv, tagname, gtp->path, n, src, fid);
 			count++;
 			last_lineno = n;
@@ -223,6 +255,30 @@ put_compact_format(CONVERT *cv, GTP *gtp, const char *root, int flags)
 	}
 	return count;
 }
+/**
+ * get_line: get a line image of the current source file.
+ *
+ *	@param[in]	lineno	line number
+ *	@param[in]	offset	byte offset of the line, -1: unknown
+ *	@return		line image, "" if not available
+ */
+static const char *
+get_line(int lineno, int offset)
+{
+	STATIC_STRBUF(ib);
+	const char *line;
+	size_t len;
+
+	if (offset >= 0)
+		line = srccache_line_at(sf, offset, &len);
+	else
+		line = srccache_line(sf, lineno, &len);
+	if (line == NULL)
+		return "";
+	strbuf_clear(ib);
+	strbuf_nputs(ib, line, len);
+	return strbuf_value(ib);
+}
 /*
  * Standard format:
  */
@@ -26,6 +26,7 @@
 void start_output(void);
 void end_output(void);
 int output_with_formatting(CONVERT *, GTP *, const char *, int);
+void readahead_output(GTOP *, const char *);
 
 #endif /* ! _OUTPUT_H_ */
 
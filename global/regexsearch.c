@@ -0,0 +1,269 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#include <ctype.h>
+#include <sys/types.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#include "global.h"
+#include "regex.h"
+#include "convert.h"
+#include "regexsearch.h"
+#include "srccache.h"
+
+extern int Vflag;
+
+/*
+ * Regular expression search for the grep command (global -g).
+ *
+ * Reading a file line by line and calling regexec() for every line
+ * costs much even if the pattern rarely matches. Instead, each file is
+ * taken from the source cache at a time, and the longest literal which every match includes
+ * is searched in the whole buffer. Only the lines which include the
+ * literal are checked by the regular expression.
+ * The lines are made in the same way as strbuf_fgets(STRBUF_NOCRLF),
+ * except that a NUL character terminates the line image.
+ */
+static regex_t preg;
+static DFA *dfa;			/**< used instead of regexec() if not NULL */
+static char literal[IDENTLEN];		/**< required literal */
+static int literal_len;			/**< 0: no literal available */
+static int skip[256];			/**< skip table of Horspool algorithm */
+static int icase;
+static const char *pattern;
+
+#define FOLD(c)	(icase ? tolower((unsigned char)(c)) : (unsigned char)(c))
+
+/**
+ * regex_comple: compile regular expression for search.
+ *
+ *	@param[in]	pat	regular expression
+ *	@param[in]	basic	1: basic regular expression, 0: extended
+ *	@param[in]	ignorecase	1: ignore case distinctions
+ */
+void
+regex_comple(const char *pat, int basic, int ignorecase)
+{
+	STRBUF *sb = strbuf_open(0);
+	const char *p, *end;
+	int flags = 0, i;
+
+	pattern = pat;
+	icase = ignorecase;
+	if (!basic)
+		flags |= REG_EXTENDED;
+	if (icase)
+		flags |= REG_ICASE;
+	if (regcomp(&preg, pattern, flags) != 0)
+		die("invalid regular expression.");
+	dfa = dfa_compile(pattern, (basic ? DFA_BASIC : 0) | (icase ? DFA_ICASE : 0));
+	/*
+	 * Pick up the longest required literal.
+	 */
+	literal_len = 0;
+	if (required_literals(pattern, basic, sb) == 0) {
+		p = strbuf_value(sb);
+		end = p + strbuf_getlen(sb);
+		for (; p < end; p += strlen(p) + 1) {
+			int len = strlen(p);
+
+			if (len > literal_len && !strchr(p, '\n')) {
+				strlimcpy(literal, p, sizeof(literal));
+				literal_len = strlen(literal);
+			}
+		}
+	}
+	strbuf_close(sb);
+	for (i = 0; i < 256; i++)
+		skip[i] = literal_len;
+	for (i = 0; i < literal_len - 1; i++) {
+		int c = (unsigned char)literal[i];
+
+		skip[c] = literal_len - 1 - i;
+		if (icase) {
+			skip[tolower(c)] = literal_len - 1 - i;
+			skip[toupper(c)] = literal_len - 1 - i;
+		}
+	}
+}
+/**
+ * find_literal: find the required literal.
+ *
+ *	@param[in]	p	start of the area
+ *	@param[in]	end	end of the area
+ *	@return		position of the literal or NULL
+ */
+static const char *
+find_literal(const char *p, const char *end)
+{
+	const int last = literal_len - 1;
+
+	while (end - p >= literal_len) {
+		int i = last;
+
+		while (FOLD(p[i]) == FOLD(literal[i])) {
+			if (i-- == 0)
+				return p;
+		}
+		p += skip[(unsigned char)p[last]];
+	}
+	return NULL;
+}
+/**
+ * line_end: get the end of the line image.
+ *
+ *	@param[in]	p	start of the line
+ *	@param[in]	end	end of the buffer
+ *	@param[out]	next	start of the next line
+ *	@return		end of the line image
+ *
+ * The line image is made in the same way as strbuf_fgets(STRBUF_NOCRLF).
+ */
+static const char *
+line_end(const char *p, const char *end, const char **next)
+{
+	const char *nl = memchr(p, '\n', end - p);
+
+	if (nl == NULL) {
+		/* strbuf_fgets() doesn't remove CR at the end of file */
+		*next = end;
+		return end;
+	}
+	*next = nl + 1;
+	if (nl > p && nl[-1] == '\r')
+		nl--;
+	return nl;
+}
+/**
+ * line_match: whether the line matches the regular expression.
+ *
+ *	@param[out]	sb	line image (only when regexec() is used)
+ *	@param[in]	p	start of the line
+ *	@param[in]	last	end of the line image
+ *	@return		1: match, 0: not match
+ */
+static int
+line_match(STRBUF *sb, const char *p, const char *last)
+{
+	if (dfa)
+		return dfa_nmatch(dfa, p, last - p);
+	strbuf_clear(sb);
+	strbuf_nputs(sb, p, last - p);
+	return regexec(&preg, strbuf_value(sb), 0, 0, 0) == 0;
+}
+/**
+ * put_line: print a line.
+ */
+static void
+put_line(CONVERT *cv, STRBUF *sb, const char *file, int lineno, const char *p, const char *last, const char *fid)
+{
+	strbuf_clear(sb);
+	strbuf_nputs(sb, p, last - p);
+	convert_put_using(cv, pattern, file, lineno, strbuf_value(sb), fid);
+}
+/**
+ * regex_search: execute regular expression search
+ *
+ *	@param[in]	cv	CONVERT structure
+ *	@param[in]	file	file to search
+ *	@param[in]	fid	file id or NULL
+ *	@return		number of lines printed, -1: error
+ */
+int
+regex_search(CONVERT *cv, const char *file, const char *fid)
+{
+	STATIC_STRBUF(sb);
+	SRCFILE *sf;
+	const char *p, *end;
+	int lineno, count = 0;
+
+	if ((sf = srccache_open(file)) == NULL)
+		die("cannot open file '%s'.", file);
+	p = sf->buf;
+	end = sf->buf + sf->size;
+	lineno = 1;
+	while (p < end) {
+		const char *last, *next;
+
+		if (literal_len > 0) {
+			const char *cand, *start;
+
+			/*
+			 * The lines before the candidate line never match.
+			 */
+			cand = find_literal(p, end);
+			if (cand == NULL)
+				cand = end;
+			for (start = cand; start > p && start[-1] != '\n'; start--)
+				;
+			while (p < start) {
+				if (Vflag) {
+					last = line_end(p, end, &next);
+					count++;
+					if (cv->format == FORMAT_PATH) {
+						convert_put_path(cv, NULL, file);
+						goto finish;
+					}
+					put_line(cv, sb, file, lineno, p, last, fid);
+				} else {
+					next = memchr(p, '\n', start - p);
+					next = next ? next + 1 : start;
+				}
+				lineno++;
+				p = next;
+			}
+			if (p >= end)
+				break;
+		}
+		last = line_end(p, end, &next);
+		if (Vflag ? !line_match(sb, p, last) : line_match(sb, p, last)) {
+			count++;
+			if (cv->format == FORMAT_PATH) {
+				convert_put_path(cv, NULL, file);
+				break;
+			}
+			put_line(cv, sb, file, lineno, p, last, fid);
+		}
+		lineno++;
+		p = next;
+	}
+finish:
+	return count;
+}
+/**
+ * regex_close: free the compiled regular expression.
+ */
+void
+regex_close(void)
+{
+	regfree(&preg);
+	if (dfa) {
+		dfa_free(dfa);
+		dfa = NULL;
+	}
+}
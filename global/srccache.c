@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include "global.h"
+#include "srccache.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/*
+ * Cache of source files.
+ *
+ * The source files are mapped into memory and kept in a small cache,
+ * which is shared by the output of tag records and the grep command.
+ * When the cache is full, the least recently used file is removed.
+ * The offsets of lines are recorded while the file is read, so that
+ * the lines once passed can be taken without reading the file again.
+ */
+#define SRCHASH		128		/**< buckets of the path hash */
+
+static SRCFILE cache[SRCCACHE_FILES];
+static SRCFILE *bucket[SRCHASH];
+static unsigned long usecount;
+
+/**
+ * hashpath: hash value of a path name.
+ */
+static unsigned int
+hashpath(const char *path)
+{
+	unsigned int h = 0;
+
+	while (*path)
+		h = h * 31 + (unsigned char)*path++;
+	return h % SRCHASH;
+}
+/**
+ * lookup: find a file in the cache.
+ *
+ *	@param[in]	path	path name
+ *	@return		SRCFILE structure, NULL: not found
+ */
+static SRCFILE *
+lookup(const char *path)
+{
+	SRCFILE *sf;
+
+	for (sf = bucket[hashpath(path)]; sf != NULL; sf = sf->chain)
+		if (!strcmp(sf->path, path))
+			return sf;
+	return NULL;
+}
+/**
+ * release: remove a file from the cache.
+ *
+ *	@param[in]	sf	SRCFILE structure
+ */
+static void
+release(SRCFILE *sf)
+{
+	SRCFILE **prev;
+
+	if (sf->path[0] == '\0')
+		return;
+	for (prev = &bucket[hashpath(sf->path)]; *prev != sf; prev = &(*prev)->chain)
+		;
+	*prev = sf->chain;
+	if (sf->buf) {
+#ifdef HAVE_MMAP
+		munmap(sf->buf, sf->size);
+#else
+		free(sf->buf);
+#endif
+	}
+	sf->path[0] = '\0';
+	sf->buf = NULL;
+	sf->size = sf->scan = 0;
+	sf->used = 0;
+	sf->chain = NULL;
+}
+/**
+ * srccache_open: get a source file from the cache.
+ *
+ *	@param[in]	path	path name
+ *	@return		SRCFILE structure, NULL: cannot open or fstat
+ *
+ * The returned structure is valid until srccache_open() is called
+ * for another file or srccache_close() is called.
+ */
+SRCFILE *
+srccache_open(const char *path)
+{
+	SRCFILE *sf;
+	struct stat st;
+	unsigned int h = hashpath(path);
+	int i, fd;
+
+	if ((sf = lookup(path)) != NULL) {
+		sf->used = ++usecount;
+		return sf;
+	}
+	if ((fd = open(path, O_RDONLY|O_BINARY)) < 0)
+		return NULL;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return NULL;
+	}
+	/*
+	 * An empty entry or the least recently used one is replaced.
+	 */
+	for (i = 0; i < SRCCACHE_FILES; i++)
+		if (sf == NULL || cache[i].used < sf->used)
+			sf = &cache[i];
+	release(sf);
+	sf->size = st.st_size;
+	if (sf->size > 0) {
+#ifdef HAVE_MMAP
+		sf->buf = mmap(0, sf->size, PROT_READ, MAP_SHARED, fd, 0);
+		if (sf->buf == MAP_FAILED)
+			die("mmap failed (%s).", path);
+#else
+		sf->buf = (char *)check_malloc(sf->size);
+		if (read(fd, sf->buf, sf->size) != sf->size)
+			die("read failed (%s).", path);
+#endif
+	}
+	close(fd);
+	if (sf->lines == NULL)
+		sf->lines = varray_open(sizeof(size_t), 1024);
+	else
+		varray_reset(sf->lines);
+	strlimcpy(sf->path, path, sizeof(sf->path));
+	sf->used = ++usecount;
+	sf->chain = bucket[h];
+	bucket[h] = sf;
+	return sf;
+}
+/**
+ * line_image: make a line image.
+ *
+ *	@param[in]	sf	SRCFILE structure
+ *	@param[in]	start	start of the line
+ *	@param[in]	end	start of the next line
+ *	@param[out]	len	length of the line image
+ *	@return		line image
+ */
+static const char *
+line_image(SRCFILE *sf, size_t start, size_t end, size_t *len)
+{
+	if (end > start && sf->buf[end - 1] == '\n') {
+		end--;
+		/* like strbuf_fgets(), CR is removed only before LF */
+		if (end > start && sf->buf[end - 1] == '\r')
+			end--;
+	}
+	*len = end - start;
+	return sf->buf + start;
+}
+/**
+ * srccache_prefetch: start reading a source file in the background.
+ *
+ *	@param[in]	path	path name
+ *
+ * The file will be opened by srccache_open() soon. The kernel is asked
+ * to read it in advance, so that the I/O overlaps with the work on the
+ * preceding files. Nothing is done without posix_fadvise().
+ */
+void
+srccache_prefetch(const char *path)
+{
+#if defined(HAVE_POSIX_FADVISE) && defined(POSIX_FADV_WILLNEED)
+	int fd;
+
+	if (lookup(path) != NULL)
+		return;
+	if ((fd = open(path, O_RDONLY|O_BINARY)) < 0)
+		return;
+	(void)posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+	close(fd);
+#endif
+}
+/**
+ * srccache_line: get a line of the source file.
+ *
+ *	@param[in]	sf	SRCFILE structure
+ *	@param[in]	lineno	line number
+ *	@param[out]	len	length of the line image
+ *	@return		line image (not terminated by NUL), NULL: out of range
+ *
+ * The line image is made in the same way as strbuf_fgets(STRBUF_NOCRLF).
+ */
+const char *
+srccache_line(SRCFILE *sf, int lineno, size_t *len)
+{
+	size_t start, end;
+
+	if (lineno < 1)
+		return NULL;
+	while (sf->lines->length < lineno) {
+		const char *nl;
+
+		if (sf->scan >= sf->size)
+			return NULL;
+		*(size_t *)varray_append(sf->lines) = sf->scan;
+		nl = memchr(sf->buf + sf->scan, '\n', sf->size - sf->scan);
+		sf->scan = nl ? nl - sf->buf + 1 : sf->size;
+	}
+	start = *(size_t *)varray_assign(sf->lines, lineno - 1, 0);
+	end = lineno < sf->lines->length ?
+		*(size_t *)varray_assign(sf->lines, lineno, 0) : sf->scan;
+	return line_image(sf, start, end, len);
+}
+/**
+ * srccache_line_at: get a line of the source file by byte offset.
+ *
+ *	@param[in]	sf	SRCFILE structure
+ *	@param[in]	offset	byte offset of the line
+ *	@param[out]	len	length of the line image
+ *	@return		line image (not terminated by NUL), NULL: out of range
+ *
+ * Only the line is read. The line table is not used.
+ */
+const char *
+srccache_line_at(SRCFILE *sf, size_t offset, size_t *len)
+{
+	const char *nl;
+
+	if (offset >= sf->size)
+		return NULL;
+	nl = memchr(sf->buf + offset, '\n', sf->size - offset);
+	return line_image(sf, offset, nl ? nl - sf->buf + 1 : sf->size, len);
+}
+/**
+ * srccache_close: remove all files from the cache.
+ */
+void
+srccache_close(void)
+{
+	int i;
+
+	for (i = 0; i < SRCCACHE_FILES; i++) {
+		release(&cache[i]);
+		if (cache[i].lines) {
+			varray_close(cache[i].lines);
+			cache[i].lines = NULL;
+		}
+	}
+	usecount = 0;
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SRCCACHE_H_
+#define _SRCCACHE_H_
+
+#include <sys/types.h>
+#include "gparam.h"
+#include "varray.h"
+
+/** number of source files kept in the cache */
+#define SRCCACHE_FILES	64
+/** number of source files read ahead */
+#define SRCCACHE_READAHEAD	16
+
+typedef struct srcfile {
+	char path[MAXPATHLEN];		/**< path name */
+	char *buf;			/**< contents of the file */
+	size_t size;			/**< size of the file */
+	VARRAY *lines;			/**< offset of each line read so far */
+	size_t scan;			/**< end of the lines read so far */
+	unsigned long used;		/**< time of the last use */
+	struct srcfile *chain;		/**< next file in the hash bucket */
+} SRCFILE;
+
+SRCFILE *srccache_open(const char *);
+void srccache_prefetch(const char *);
+const char *srccache_line(SRCFILE *, int, size_t *);
+const char *srccache_line_at(SRCFILE *, size_t, size_t *);
+void srccache_close(void);
+
+#endif /* ! _SRCCACHE_H_ */
@@ -72,8 +72,9 @@ static void help(void);
 int printconf(const char *);
 int main(int, char **);
 int incremental(const char *, const char *);
-void updatetags(const char *, const char *, IDSET *, STRBUF *);
+void updatetags(const char *, const char *, IDSET *, STRBUF *, STRHASH *);
 void createtags(const char *, const char *);
+void makenameindex(const char *, NAMEINDEX *, STRHASH *);
 
 int cflag;					/**< compact format */
 int iflag;					/**< incremental update */
@@ -88,6 +89,9 @@ int show_config;
 int skip_unreadable;
 int skip_symlink;
 int accept_dotfiles;
+int byte_offset;				/**< byte offset in compact format */
+int compress_keys;				/**< prefix compressed tag names */
+int posting_list;				/**< posting lists in GRTAGS */
 char *gtagsconf;
 char *gtagslabel;
 int debug;
@@ -181,8 +185,11 @@ static struct option const long_options[] = {
 #define OPT_GTAGSSKIP_SYMLINK	135
 	/* flag value */
 	{"accept-dotfiles", no_argument, NULL, OPT_ACCEPT_DOTFILES},
+	{"byte-offset", no_argument, &byte_offset, 1},
+	{"compress-keys", no_argument, &compress_keys, 1},
 	{"debug", no_argument, &debug, 1},
 	{"explain", no_argument, &explain, 1},
+	{"posting-list", no_argument, &posting_list, 1},
 #ifdef USE_SQLITE3
 	{"sqlite3", no_argument, &use_sqlite3, 1},
 #endif
@@ -634,6 +641,8 @@ incremental(const char *dbpath, const char *root)
 	STRBUF *deletelist = strbuf_open(0);
 	STRBUF *addlist_other = strbuf_open(0);
 	IDSET *deleteset, *findset;
+	NAMEINDEX *ni = NULL;
+	STRHASH *touched = NULL;
 	int updated = 0;
 	const char *path;
 	unsigned int id, limit;
@@ -778,9 +787,15 @@ incremental(const char *dbpath, const char *root)
 	{
 		int db;
 		updated = 1;
+		/*
+		 * GNAMES is remade from the current one and the names touched
+		 * by this update, if the current one is up to date.
+		 */
+		if ((ni = nameindex_open(dbpath)) != NULL)
+			touched = strhash_open(1024);
 		tim = statistics_time_start("Time of updating %s and %s.", dbname(GTAGS), dbname(GRTAGS));
 		if (!idset_empty(deleteset) || strbuf_getlen(addlist) > 0)
-			updatetags(dbpath, root, deleteset, addlist);
+			updatetags(dbpath, root, deleteset, addlist, touched);
 		if (strbuf_getlen(deletelist) + strbuf_getlen(addlist_other) > 0) {
 			const char *start, *end, *p;
 
@@ -812,6 +827,15 @@ incremental(const char *dbpath, const char *root)
 			utime(makepath(dbpath, dbname(db), NULL), NULL);
 		statistics_time_end(tim);
 	}
+	/*
+	 * GNAMES is remade also when it is missing or out of date.
+	 */
+	if (updated || (ni = nameindex_open(dbpath)) == NULL)
+		makenameindex(dbpath, ni, touched);
+	if (ni)
+		nameindex_close(ni);
+	if (touched)
+		strhash_close(touched);
 exit:
 	if (vflag) {
 		if (updated)
@@ -836,6 +860,7 @@ exit:
  */
 struct put_func_data {
 	GTOP *gtop[GTAGLIM];
+	GINCLUDE *ginc;
 	const char *fid;
 };
 static void
@@ -845,6 +870,15 @@ put_syms(int type, const char *tag, int lno, const char *path, const char *line_
 	GTOP *gtop;
 	const char *p;
 
+	/*
+	 * Include directives are recorded into GINCLUDE.
+	 * The file name may include space characters.
+	 */
+	if (type == PARSER_INCLUDE) {
+		if (data->ginc != NULL)
+			ginclude_put(data->ginc, tag, lno, data->fid, line_image);
+		return;
+	}
 	/*
 	 * sanity checks
 	 * These checks are required, because there is no telling what kind of string
@@ -888,9 +922,11 @@ put_syms(int type, const char *tag, int lno, const char *path, const char *line_
  *	@param[in]	root		root directory of source tree
  *	@param[in]	deleteset	bit array of fid of deleted or modified files 
  *	@param[in]	addlist		'\0' separated list of added or modified files
+ *	@param[out]	touched		names of added or deleted records are put,
+ *					if not NULL
  */
 void
-updatetags(const char *dbpath, const char *root, IDSET *deleteset, STRBUF *addlist)
+updatetags(const char *dbpath, const char *root, IDSET *deleteset, STRBUF *addlist, STRHASH *touched)
 {
 	struct put_func_data data;
 	int seqno, flags;
@@ -911,6 +947,13 @@ updatetags(const char *dbpath, const char *root, IDSET *deleteset, STRBUF *addli
 		 */
 		data.gtop[GRTAGS] = NULL;
 	}
+	data.gtop[GTAGS]->touched = touched;
+	if (data.gtop[GRTAGS] != NULL)
+		data.gtop[GRTAGS]->touched = touched;
+	/*
+	 * GINCLUDE doesn't exist if the tag files were made by older gtags.
+	 */
+	data.ginc = ginclude_open(dbpath, GTAGS_MODIFY);
 	/*
 	 * Delete tags from GTAGS.
 	 */
@@ -932,6 +975,8 @@ updatetags(const char *dbpath, const char *root, IDSET *deleteset, STRBUF *addli
 		gtags_delete(data.gtop[GTAGS], deleteset);
 		if (data.gtop[GRTAGS] != NULL)
 			gtags_delete(data.gtop[GRTAGS], deleteset);
+		if (data.ginc != NULL)
+			ginclude_delete(data.ginc, deleteset);
 	}
 	/*
 	 * Set flags.
@@ -973,6 +1018,37 @@ updatetags(const char *dbpath, const char *root, IDSET *deleteset, STRBUF *addli
 	gtags_close(data.gtop[GTAGS]);
 	if (data.gtop[GRTAGS] != NULL)
 		gtags_close(data.gtop[GRTAGS]);
+	if (data.ginc != NULL)
+		ginclude_close(data.ginc);
+}
+/**
+ * estimate_tagsize: estimate the size of the largest tag file.
+ *
+ *	@param[in]	root	root directory of source tree
+ *	@return		estimated size of GRTAGS
+ *
+ * GRTAGS is usually less than half of the source files in size.
+ */
+static off_t
+estimate_tagsize(const char *root)
+{
+	struct stat st;
+	const char *path;
+	off_t total = 0;
+
+	if (file_list)
+		find_open_filelist(file_list, root, 0);
+	else
+		find_open(NULL, 0);
+	while ((path = find_read()) != NULL) {
+		/* a blank at the head of path means 'NOT SOURCE'. */
+		if (*path == ' ')
+			continue;
+		if (stat(path, &st) == 0)
+			total += st.st_size;
+	}
+	find_close();
+	return total / 2;
 }
 /**
  * createtags: create tags file
@@ -992,7 +1068,24 @@ createtags(const char *dbpath, const char *root)
 	tim = statistics_time_start("Time of creating %s and %s.", dbname(GTAGS), dbname(GRTAGS));
 	if (vflag)
 		fprintf(stderr, "[%s] Creating '%s' and '%s'.\n", now(), dbname(GTAGS), dbname(GRTAGS));
+	/*
+	 * GTAGSPAGESIZE=auto: choose the page size for the size of the source tree.
+	 */
+	if ((path = getenv("GTAGSPAGESIZE")) != NULL && !strcmp(path, "auto")) {
+		char number[32];
+
+		snprintf(number, sizeof(number), "%d", dbop_auto_pagesize(estimate_tagsize(root)));
+		set_env("GTAGSPAGESIZE", number);
+		if (vflag)
+			fprintf(stderr, " Page size of the tag files is %s bytes.\n", number);
+	}
 	openflags = cflag ? GTAGS_COMPACT : 0;
+	if (byte_offset)
+		openflags |= GTAGS_COMPOFFSET;
+	if (compress_keys)
+		openflags |= GTAGS_PFXKEY;
+	if (posting_list)
+		openflags |= GTAGS_POSTLIST;
 #ifdef USE_SQLITE3
 	if (use_sqlite3)
 		openflags |= GTAGS_SQLITE3;
@@ -1003,6 +1096,7 @@ createtags(const char *dbpath, const char *root)
 		data.gtop[GTAGS]->flags |= GTAGS_EXTRACTMETHOD;
 	data.gtop[GRTAGS] = gtags_open(dbpath, root, GRTAGS, GTAGS_CREATE, openflags);
 	data.gtop[GRTAGS]->flags = data.gtop[GTAGS]->flags;
+	data.ginc = ginclude_open(dbpath, GTAGS_CREATE);
 	flags = 0;
 	if (vflag)
 		flags |= PARSER_VERBOSE;
@@ -1047,6 +1141,7 @@ createtags(const char *dbpath, const char *root)
 	tim = statistics_time_start("Time of flushing B-tree cache");
 	gtags_close(data.gtop[GTAGS]);
 	gtags_close(data.gtop[GRTAGS]);
+	ginclude_close(data.ginc);
 	statistics_time_end(tim);
 	strbuf_reset(sb);
 	if (getconfs("GTAGS_extra", sb)) {
@@ -1063,4 +1158,31 @@ createtags(const char *dbpath, const char *root)
 		statistics_time_end(tim);
 	}
 	strbuf_close(sb);
+	makenameindex(dbpath, NULL, NULL);
+}
+/**
+ * makenameindex: make name index (GNAMES) for completion.
+ *
+ *	@param[in]	dbpath	dbpath directory
+ *	@param[in]	ni	GNAMES before the update or NULL
+ *	@param[in]	touched	names touched by the update or NULL
+ *
+ * Without the old GNAMES, it is made from GTAGS and GRTAGS.
+ */
+void
+makenameindex(const char *dbpath, NAMEINDEX *ni, STRHASH *touched)
+{
+	STATISTICS_TIME *tim;
+
+	tim = statistics_time_start("Time of making %s", GNAMES_NAME);
+	if (ni && touched) {
+		if (vflag)
+			fprintf(stderr, "[%s] Updating '%s' (%lu names touched).\n", now(), GNAMES_NAME, touched->entries);
+		nameindex_update(dbpath, ni, touched);
+	} else {
+		if (vflag)
+			fprintf(stderr, "[%s] Making '%s'.\n", now(), GNAMES_NAME);
+		nameindex_create(dbpath);
+	}
+	statistics_time_end(tim);
 }
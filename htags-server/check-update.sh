@@ -0,0 +1,115 @@
+#!/bin/sh
+#
+# Copyright (c) 2026 Tama Communications Corporation
+#
+# This file is part of GNU GLOBAL.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# check-update.sh: send invalid requests and update the tag files while
+# htags-server is running.
+#
+# Exit status: 0 (pass), 1 (fail), 77 (skipped)
+#
+command -v curl >/dev/null 2>&1 || exit 77
+top=`cd .. && pwd`
+PATH=$top/global:$top/gtags:$top/htags:$top/htags-server:$PATH
+export PATH
+unset GTAGSROOT GTAGSDBPATH GTAGSCONF GTAGSLABEL
+
+dir=`pwd`/check-update.$$
+pid=
+cleanup() {
+	test -n "$pid" && kill $pid 2>/dev/null
+	rm -rf $dir
+}
+trap cleanup 0
+trap 'exit 1' 1 2 15
+fail() {
+	echo "FAIL: $1"
+	test -f $dir/log && cat $dir/log
+	exit 1
+}
+mkdir $dir && cd $dir || exit 1
+cat >a.c <<!
+int func_a(void) { return 0; }
+int main(void) { return func_a(); }
+!
+gtags || fail "gtags"
+htags -q || fail "htags"
+#
+# global -g takes 3 seconds in the server.
+#
+mkdir bin
+cat >bin/global <<!
+#!/bin/sh
+case "\$*" in *-g*) sleep 3;; esac
+exec $top/global/global "\$@"
+!
+chmod +x bin/global
+PATH=$dir/bin:$PATH htags-server --retry `expr 18000 + $$ % 1000` >log 2>&1 &
+pid=$!
+port=
+for i in 1 2 3 4 5 6 7 8 9 10; do
+	port=`sed -n 's/^Serving HTTP on .* port \([0-9]*\) .*/\1/p' log 2>/dev/null`
+	test -n "$port" && break
+	sleep 1
+done
+test -n "$port" || fail "htags-server didn't start"
+url=http://127.0.0.1:$port/cgi-bin
+
+# status <query>: print the status code of a request to global.cgi.
+status() {
+	curl -s -o /dev/null -w '%{http_code}' "$url/global.cgi?$1"
+}
+test "`status 'pattern=func_a&type=definition'`" = 302 || fail "func_a not found"
+#
+# Invalid requests must not stop the server.
+#
+long=`awk 'BEGIN { for (i = 0; i < 1500; i++) printf "a" }'`
+test "`status "pattern=$long&type=definition"`" = 400 || fail "long pattern accepted"
+test "`status 'pattern=func%0Aa&type=definition'`" = 400 || fail "control character accepted"
+test "`status 'pattern=func(&type=reference'`" = 400 || fail "invalid regex accepted"
+test "`curl -s -o /dev/null -w '%{http_code}' "$url/completion.cgi?q=$long&type=definition"`" = 400 || fail "long prefix accepted"
+longpath=`awk 'BEGIN { for (i = 0; i < 1364; i++) printf "ab/" }'`
+test "`curl -s -o /dev/null -w '%{http_code}' "http://127.0.0.1:$port/$longpath"`" = 404 || fail "long path accepted"
+kill -0 $pid 2>/dev/null || fail "htags-server died"
+test "`status 'pattern=func_a&type=definition'`" = 302 || fail "func_a not found in the cache"
+#
+# A grep search must not block the other requests.
+#
+curl -s -o grep.out -w '%{http_code}' "$url/global.cgi?pattern=func_a&type=grep" >grep.status &
+grep_pid=$!
+sleep 1
+test "`curl -m 2 -s -o /dev/null -w '%{http_code}' http://127.0.0.1:$port/index.html`" = 200 || fail "static file blocked by grep"
+test "`curl -m 2 -s -o /dev/null -w '%{http_code}' "$url/global.cgi?pattern=main&type=definition"`" = 302 || fail "search blocked by grep"
+wait $grep_pid
+test "`cat grep.status`" = 200 || fail "grep failed"
+grep "func_a" grep.out >/dev/null || fail "grep result not found"
+#
+# A file added by gtags -i has a new file id, which is known only to
+# the updated GPATH. The cached page of func_a is out of date.
+#
+cat >b.c <<!
+int func_b(void) { return 1; }
+static int func_a(void) { return func_b(); }
+!
+sleep 1
+gtags -i || fail "gtags -i"
+sleep 2
+test "`status 'pattern=func_b&type=definition'`" = 302 || fail "func_b not found after update"
+test "`status 'pattern=func_a&type=definition'`" = 200 || fail "stale page of func_a served from the cache"
+test "`status 'pattern=func_a&type=reference'`" = 302 || fail "func_a not referred after update"
+kill -0 $pid 2>/dev/null || fail "htags-server died"
+exit 0
@@ -0,0 +1,1716 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <ctype.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <time.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#endif
+#if defined(HAVE_SYS_SENDFILE_H) && defined(HAVE_SENDFILE)
+#include <sys/sendfile.h>
+#define USE_SENDFILE 1
+#endif
+
+#include "getopt.h"
+#include "regex.h"
+#include "global.h"
+#include "const.h"
+#include "hash-string.h"
+
+/**
+ htags-server - a private Web server for the hypertext generated by htags(1).
+
+ Static files in the HTML directory are sent as they are (using sendfile(2)
+ if available). The two CGI programs of htags, cgi-bin/global.cgi and
+ cgi-bin/completion.cgi, are not executed; their jobs are done in this
+ process using tag files which are kept open. Requests are processed by
+ a single process with an event loop based on poll(2), except for grep
+ and idutils searches, which take long and are done in child processes.
+
+ Rendered result pages of global.cgi are kept in a cache (with LRU
+ replacement) until the tag files are updated by gtags(1), so that
+ popular symbols are served without reading the tag files at all.
+*/
+
+#define MAXCONN		64		/**< max number of connections */
+#define MAXREQUEST	8192		/**< max length of request header */
+#define TIMEOUT		60		/**< idle timeout (sec) */
+#define CACHEBUCKETS	1024		/**< number of hash buckets of the cache */
+#define MAXCHILD	8		/**< max number of search processes */
+#define MAXRESULT	10000		/**< max number of records in a result */
+
+static void usage(void);
+static void help(void);
+static void cache_flush(void);
+int main(int, char **);
+
+int qflag;
+int vflag;
+int show_version;
+int show_help;
+int debug;
+
+static const char *bind_address = "127.0.0.1";
+static int port = 8000;
+static int retry;
+
+static char root[MAXPATHLEN];		/**< root of the source tree */
+static char dbpath[MAXPATHLEN];		/**< directory of tag files */
+static GTOP *gtop[GTAGLIM];		/**< tag files kept open */
+static NAMEINDEX *nameindex;		/**< name index kept open */
+static int gpath_opened;		/**< 1: GPATH is open */
+static unsigned long generation;	/**< generation of the tag files */
+static char stamp[128];			/**< time stamp of the tag files */
+static time_t last_check;		/**< last time when the stamp was checked */
+static long cache_limit = 4096 * 1024;	/**< max size of the render cache (bytes) */
+
+static const char *short_options = "b:u:";
+static struct option const long_options[] = {
+	{"bind", required_argument, NULL, 'b'},
+	{"cache", required_argument, NULL, 'c'},
+	{"use", required_argument, NULL, 'u'},
+	{"retry", optional_argument, NULL, 'r'},
+	{"debug", no_argument, &debug, 1},
+	{"verbose", no_argument, &vflag, 1},
+	{"version", no_argument, &show_version, 1},
+	{"help", no_argument, &show_help, 1},
+	{ 0 }
+};
+
+static void
+usage(void)
+{
+	fputs(usage_const, stderr);
+	exit(2);
+}
+static void
+help(void)
+{
+	fputs(usage_const, stdout);
+	fputs(help_const, stdout);
+	exit(0);
+}
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+int
+main(int argc, char **argv)
+{
+	die("htags-server is not supported on this platform.");
+}
+#else
+/*----------------------------------------------------------------------*/
+/* Tag files								*/
+/*----------------------------------------------------------------------*/
+/**
+ * reopen_tags: close all tag files, reopen GPATH and flush the cache.
+ *
+ * Everything made from the tag files is reset here at once.
+ * GPATH is shared by all the tag files (gtags_open() only counts up the
+ * reference), so closing them leaves it open. It must be reopened here,
+ * or the file ids added by gtags -i would not be found.
+ * The other tag files and GNAMES are reopened lazily by get_tags() and
+ * get_nameindex().
+ */
+static void
+reopen_tags(void)
+{
+	int db;
+
+	for (db = GTAGS; db < GTAGLIM; db++) {
+		if (gtop[db]) {
+			gtags_close(gtop[db]);
+			gtop[db] = NULL;
+		}
+	}
+	if (nameindex) {
+		nameindex_close(nameindex);
+		nameindex = NULL;
+	}
+	if (gpath_opened) {
+		gpath_close();
+		gpath_opened = 0;
+	}
+	if (gpath_open(dbpath, 0) == 0)
+		gpath_opened = 1;
+	else if (vflag)
+		fprintf(stderr, "htags-server: GPATH not found in '%s'.\n", dbpath);
+	cache_flush();
+}
+/**
+ * check_generation: check whether the tag files were updated or not.
+ *
+ *	@return		generation of the tag files
+ *
+ * The generation is incremented when the modification time or the size
+ * of any tag file changes. It is checked at most once a second.
+ */
+static unsigned long
+check_generation(void)
+{
+	STRBUF *sb;
+	struct stat st;
+	time_t now = time(NULL);
+	int db;
+
+	if (now == last_check && generation > 0)
+		return generation;
+	last_check = now;
+	sb = strbuf_open(0);
+	for (db = GPATH; db < GSYMS; db++) {
+		char buf[64];
+
+		if (stat(makepath(dbpath, dbname(db), NULL), &st) < 0)
+			continue;
+		snprintf(buf, sizeof(buf), "%d:%ld:%ld ", db, (long)st.st_mtime, (long)st.st_size);
+		strbuf_puts(sb, buf);
+	}
+	if (generation == 0 || strcmp(stamp, strbuf_value(sb))) {
+		strlimcpy(stamp, strbuf_value(sb), sizeof(stamp));
+		reopen_tags();
+		generation++;
+		if (vflag && generation > 1)
+			fprintf(stderr, "htags-server: tag files in '%s' were updated.\n", dbpath);
+	}
+	strbuf_close(sb);
+	return generation;
+}
+/**
+ * get_tags: get the descripter of a tag file.
+ *
+ *	@param[in]	db	GTAGS, GRTAGS or GSYMS
+ *	@return		GTOP or NULL (not exist)
+ *
+ * Tag files are opened at the first request, and kept open.
+ * If they were updated by gtags(1), they are reopened.
+ */
+static GTOP *
+get_tags(int db)
+{
+	check_generation();
+	if (!gpath_opened)
+		return NULL;
+	if (gtop[db] == NULL) {
+		/* GSYMS is included in GRTAGS */
+		if (!test("f", makepath(dbpath, dbname(db == GSYMS ? GRTAGS : db), NULL)))
+			return NULL;
+		if (vflag)
+			fprintf(stderr, "htags-server: opening %s in '%s'.\n", dbname(db), dbpath);
+		gtop[db] = gtags_open(dbpath, root, db, GTAGS_READ, 0);
+	}
+	return gtop[db];
+}
+/**
+ * get_nameindex: get the descripter of the name index.
+ *
+ *	@return		NAMEINDEX or NULL (not exist or out of date)
+ *
+ * Gtags(1) writes GNAMES after the tag files, so an index which was
+ * out of date is retried at the next request.
+ */
+static NAMEINDEX *
+get_nameindex(void)
+{
+	check_generation();
+	if (nameindex == NULL)
+		nameindex = nameindex_open(dbpath);
+	return nameindex;
+}
+
+/*----------------------------------------------------------------------*/
+/* HTML and URL utilities						*/
+/*----------------------------------------------------------------------*/
+/**
+ * url_decode: decode %xx and '+'.
+ *
+ *	@param[out]	sb	result
+ *	@param[in]	s	string
+ *	@param[in]	len	length of the string
+ *	@param[in]	plus	1: '+' means ' '
+ */
+static void
+url_decode(STRBUF *sb, const char *s, int len, int plus)
+{
+	const char *end = s + len;
+
+	for (; s < end; s++) {
+		if (*s == '%' && end - s >= 3 && isxdigit((unsigned char)s[1]) && isxdigit((unsigned char)s[2])) {
+			char hex[3];
+
+			hex[0] = s[1];
+			hex[1] = s[2];
+			hex[2] = '\0';
+			strbuf_putc(sb, (int)strtol(hex, NULL, 16));
+			s += 2;
+		} else if (*s == '+' && plus) {
+			strbuf_putc(sb, ' ');
+		} else {
+			strbuf_putc(sb, *s);
+		}
+	}
+}
+/**
+ * get_param: get the value of a parameter in a query string.
+ *
+ *	@param[in]	query	query string (name=value&name=value...)
+ *	@param[in]	name	parameter name
+ *	@return		decoded value or NULL (not found)
+ */
+static const char *
+get_param(const char *query, const char *name)
+{
+	STATIC_STRBUF(sb);
+	int len = strlen(name);
+	const char *p, *end;
+
+	for (p = query; p && *p; p = (*end) ? end + 1 : end) {
+		for (end = p; *end && *end != '&'; end++)
+			;
+		if (!strncmp(p, name, len) && p[len] == '=') {
+			strbuf_clear(sb);
+			p += len + 1;
+			url_decode(sb, p, end - p, 1);
+			return strbuf_value(sb);
+		}
+	}
+	return NULL;
+}
+/**
+ * put_html: put a string with escaping HTML special characters.
+ */
+static void
+put_html(STRBUF *sb, const char *s)
+{
+	for (; *s; s++) {
+		switch (*s) {
+		case '&':	strbuf_puts(sb, "&amp;"); break;
+		case '<':	strbuf_puts(sb, "&lt;"); break;
+		case '>':	strbuf_puts(sb, "&gt;"); break;
+		case '\'':	strbuf_puts(sb, "&#39;"); break;
+		default:	strbuf_putc(sb, *s); break;
+		}
+	}
+}
+/*
+ * The following functions generate the same output as global.cgi.
+ */
+static const char *basedir = "..";
+
+static void
+put_header(STRBUF *sb)
+{
+	strbuf_puts(sb, "<!DOCTYPE html PUBLIC '-//W3C//DTD XHTML 1.0 Transitional//EN' 'http://www.w3.org/TR/xhtml1/DTD/xhtml1-transitional.dtd'>\n");
+	strbuf_puts(sb, "<html xmlns='http://www.w3.org/1999/xhtml'>\n");
+	strbuf_puts(sb, "<head>\n<title>Result</title>\n");
+	strbuf_puts(sb, "<meta name='robots' content='noindex,nofollow' />\n");
+	strbuf_puts(sb, "<meta name='generator' content='" PACKAGE_STRING "' />\n");
+	strbuf_puts(sb, "<meta http-equiv='Content-Style-Type' content='text/css' />\n");
+	strbuf_sprintf(sb, "<link rel='stylesheet' type='text/css' href='%s/style.css' />\n", basedir);
+	strbuf_puts(sb, "</head>\n<body>\n");
+}
+static void
+put_tailer(STRBUF *sb)
+{
+	strbuf_puts(sb, "</body>\n</html>\n");
+}
+static void
+put_error(STRBUF *sb, const char *message)
+{
+	put_header(sb);
+	strbuf_puts(sb, "<h2 class='error'>Error</h2>\n");
+	strbuf_sprintf(sb, "<h3 class='message'>%s<a href='%s/mains.html'>[return]</a></h3>\n", message, basedir);
+	put_tailer(sb);
+}
+/**
+ * check_pattern: check a pattern given by a request.
+ *
+ *	@param[in]	pattern	pattern
+ *	@return		NULL: valid, otherwise: error message
+ *
+ * Libutil dies for a name longer than the limit, and that would stop the
+ * whole server. So a pattern must be checked before it is passed to libutil.
+ */
+static const char *
+check_pattern(const char *pattern)
+{
+	const char *p;
+
+	if (strlen(pattern) >= IDENTLEN)
+		return "Pattern too long.";
+	for (p = pattern; *p; p++)
+		if (iscntrl((unsigned char)*p))
+			return "Invalid character in pattern.";
+	return NULL;
+}
+
+/*----------------------------------------------------------------------*/
+/* Search (global.cgi)							*/
+/*----------------------------------------------------------------------*/
+/*
+ * Result of a search.
+ */
+struct result {
+	STRBUF *list;			/**< formatted tag list */
+	int count;			/**< number of records */
+	int truncated;			/**< 1: more than MAXRESULT records */
+	char first_fid[MAXFIDLEN];	/**< fid of the first record */
+	int first_lno;			/**< line number of the first record */
+};
+
+/**
+ * put_record: add a record to the result.
+ *
+ *	@param[in]	r	result
+ *	@param[in]	fid	file id
+ *	@param[in]	tag	tag name
+ *	@param[in]	lno	line number
+ *	@param[in]	path	path name
+ *	@param[in]	image	line image
+ *
+ * Only the first MAXRESULT records are kept, so that the size of
+ * a result page is limited.
+ */
+static void
+put_record(struct result *r, const char *fid, const char *tag, int lno, const char *path, const char *image)
+{
+	char buf[MAXBUFLEN];
+	int len = strlen(tag);
+
+	if (r->count >= MAXRESULT) {
+		r->truncated = 1;
+		return;
+	}
+	if (r->count++ == 0) {
+		strlimcpy(r->first_fid, fid, sizeof(r->first_fid));
+		r->first_lno = lno;
+	}
+	if (path[0] == '.' && path[1] == '/')
+		path += 2;
+	/*
+	 * ctags -x format with a link.
+	 */
+	strbuf_sprintf(r->list, "<span class='curline'><a href='%s/S/%s.html#L%d'>", basedir, fid, lno);
+	put_html(r->list, tag);
+	strbuf_puts(r->list, "</a>");
+	if (len < 16)
+		strbuf_nputc(r->list, ' ', 16 - len);
+	snprintf(buf, sizeof(buf), " %4d %-16s ", lno, path);
+	put_html(r->list, buf);
+	put_html(r->list, image);
+	strbuf_puts(r->list, "</span>\n");
+}
+/*
+ * Reading lines of source files for compact format.
+ */
+static FILE *src_fp;
+static char src_path[MAXPATHLEN];
+static int src_lineno;
+
+/**
+ * get_source_line: get a line of a source file.
+ *
+ *	@param[in]	path	path name
+ *	@param[in]	lno	line number
+ *	@return		line image
+ */
+static const char *
+get_source_line(const char *path, int lno)
+{
+	STATIC_STRBUF(ib);
+	const char *line = "";
+
+	if (strcmp(path, src_path) != 0 || lno <= src_lineno) {
+		if (src_fp)
+			fclose(src_fp);
+		strlimcpy(src_path, path, sizeof(src_path));
+		src_fp = fopen(makepath(root, path, NULL), "r");
+		src_lineno = 0;
+		strbuf_clear(ib);
+	}
+	if (src_fp == NULL)
+		return "";
+	while (src_lineno < lno) {
+		if ((line = strbuf_fgets(ib, src_fp, STRBUF_NOCRLF)) == NULL) {
+			fclose(src_fp);
+			src_fp = NULL;
+			return "";
+		}
+		src_lineno++;
+	}
+	return strbuf_value(ib);
+}
+#define GET_NEXT_NUMBER(p) do {                                                \
+                if (!isdigit(*p))                                              \
+                        p++;                                                   \
+                for (n = 0; isdigit(*p); p++)                                  \
+                        n = n * 10 + (*p - '0');                               \
+        } while (0)
+
+/**
+ * put_tagline: add records of a tag line to the result.
+ *
+ *	@param[in]	r	result
+ *	@param[in]	gtp	record descripter
+ *	@param[in]	format	format of the tag file
+ *
+ * This function unfolds both standard format and compact format
+ * like global/output.c does.
+ */
+static void
+put_tagline(struct result *r, GTP *gtp, int format)
+{
+	STATIC_STRBUF(line);
+	STATIC_STRBUF(sb_uncompress);
+	char tagname[IDENTLEN];
+	char *p, *fid, *name;
+	int n = 0;
+
+	strbuf_clear(line);
+	strbuf_puts(line, gtp->tagline);
+	p = strbuf_value(line);
+	/*
+	 * tagline = <file id> <tag name> <line no>[ <line image>]
+	 */
+	fid = p;
+	while (*p && *p != ' ')
+		p++;
+	if (*p == '\0')
+		return;
+	*p++ = '\0';
+	name = p;
+	while (*p && *p != ' ')
+		p++;
+	if (*p == '\0')
+		return;
+	*p++ = '\0';
+	if (format & GTAGS_COMPNAME)
+		name = uncompress(name, gtp->tag, sb_uncompress);
+	strlimcpy(tagname, name, sizeof(tagname));
+	if (!(format & GTAGS_COMPACT)) {
+		const char *image;
+
+		while (*p && *p != ' ')
+			p++;
+		image = (*p) ? p + 1 : "";
+		if (format & GTAGS_COMPRESS)
+			image = uncompress(image, gtp->tag, sb_uncompress);
+		put_record(r, fid, tagname, gtp->lineno, gtp->path, image);
+	} else if (format & GTAGS_COMPLINE) {
+		/*
+		 * Each line number is expressed as the difference from
+		 * the previous one except for the head.
+		 * (See flush_pool() in libutil/gtagsop.c)
+		 */
+		int last = 0, cont = 0;
+
+		while (*p || cont > 0) {
+			if (cont > 0) {
+				n = last + 1;
+				if (n > cont) {
+					cont = 0;
+					continue;
+				}
+			} else if (isdigit((unsigned char)*p)) {
+				GET_NEXT_NUMBER(p);
+			} else if (*p == '-') {
+				GET_NEXT_NUMBER(p);
+				cont = n + last;
+				n = last + 1;
+			} else if (*p == ',') {
+				GET_NEXT_NUMBER(p);
+				n += last;
+			} else {
+				break;
+			}
+			put_record(r, fid, tagname, n, gtp->path, get_source_line(gtp->path, n));
+			last = n;
+		}
+	} else {
+		int last = 0;
+
+		while (*p) {
+			for (n = 0; isdigit((unsigned char)*p); p++)
+				n = n * 10 + *p - '0';
+			if (*p == ',')
+				p++;
+			else if (*p && !isdigit((unsigned char)*p))
+				break;
+			if (n == last)
+				continue;
+			put_record(r, fid, tagname, n, gtp->path, get_source_line(gtp->path, n));
+			last = n;
+		}
+	}
+}
+/**
+ * search_tags: search tag files.
+ *
+ *	@param[in]	r	result
+ *	@param[in]	pattern	pattern
+ *	@param[in]	db	GTAGS, GRTAGS or GSYMS
+ *	@param[in]	icase	1: ignore case
+ *	@return		0: normal, -1: tag file not found
+ */
+static int
+search_tags(struct result *r, const char *pattern, int db, int icase)
+{
+	char buffer[IDENTLEN];
+	GTOP *gt = get_tags(db);
+	GTP *gtp;
+	int flags = icase ? GTOP_IGNORECASE : 0;
+
+	if (gt == NULL)
+		return -1;
+	/*
+	 * trim pattern (^<no regex>$ => <no regex>) like global(1).
+	 */
+	if (*pattern == '^') {
+		char *p = buffer;
+
+		strlimcpy(buffer, pattern + 1, sizeof(buffer));
+		if (*p && p[strlen(p) - 1] == '$') {
+			p[strlen(p) - 1] = '\0';
+			if (*p == '\0' || !isregex(p))
+				pattern = p;
+		}
+	}
+	/*
+	 * One more record than shown tells that the result was truncated.
+	 */
+	gtags_setlimit(gt, MAXRESULT + 1);
+	for (gtp = gtags_first(gt, pattern, flags); gtp && !r->truncated; gtp = gtags_next(gt))
+		put_tagline(r, gtp, gt->format);
+	if (src_fp) {
+		fclose(src_fp);
+		src_fp = NULL;
+	}
+	src_path[0] = '\0';
+	return 0;
+}
+/**
+ * search_path: search path names in GPATH.
+ *
+ *	@param[in]	r	result
+ *	@param[in]	preg	compiled pattern
+ *	@param[in]	other	1: include other files
+ *	@return		0: normal, -1: GPATH not found
+ */
+static int
+search_path(struct result *r, regex_t *preg, int other)
+{
+	GFIND *gp;
+	const char *path;
+
+	check_generation();
+	if (!gpath_opened)
+		return -1;
+	gp = gfind_open(dbpath, NULL, other ? GPATH_BOTH : GPATH_SOURCE, 0);
+	while ((path = gfind_read(gp)) != NULL && !r->truncated) {
+		if (regexec(preg, path + 2, 0, 0, 0) != 0)
+			continue;
+		put_record(r, gpath_path2fid(path, NULL), path + 2, 1, path, "");
+	}
+	gfind_close(gp);
+	return 0;
+}
+/**
+ * search_command: search using global(1).
+ *
+ *	@param[in]	r	result
+ *	@param[in]	flags	option flags of global(1)
+ *	@param[in]	pattern	pattern
+ *	@return		0: normal, -1: error
+ *
+ * Grep and idutils are not handled in this process, since they don't
+ * use tag files. This is called in a child process (See fork_search()).
+ */
+static int
+search_command(struct result *r, const char *flags, const char *pattern)
+{
+	STRBUF *command = strbuf_open(0);
+	STRBUF *ib = strbuf_open(0);
+	const char *global = usable("global");
+	const char *line;
+	FILE *ip;
+	int status = 0;
+
+	if (global == NULL) {
+		status = -1;
+		goto finish;
+	}
+	strbuf_puts(command, "cd ");
+	strbuf_puts(command, quote_shell(root));
+	strbuf_puts(command, " && ");
+	strbuf_puts(command, quote_shell(global));
+	strbuf_puts(command, " --result=ctags-xid -");
+	strbuf_puts(command, flags);
+	strbuf_puts(command, "e ");
+	strbuf_puts(command, quote_shell(pattern));
+	if ((ip = popen(strbuf_value(command), "r")) == NULL) {
+		status = -1;
+		goto finish;
+	}
+	while ((line = strbuf_fgets(ib, ip, STRBUF_NOCRLF)) != NULL && !r->truncated) {
+		SPLIT ptable;
+
+		/* <fid> <tag> <lno> <path> <image> */
+		if (split(line, 5, &ptable) < 5) {
+			recover(&ptable);
+			continue;
+		}
+		put_record(r, ptable.part[0].start, ptable.part[1].start,
+			atoi(ptable.part[2].start), ptable.part[3].start, ptable.part[4].start);
+		recover(&ptable);
+	}
+	if (pclose(ip) != 0 && r->count == 0)
+		status = -1;
+finish:
+	strbuf_close(command);
+	strbuf_close(ib);
+	return status;
+}
+/**
+ * do_search: process a request to global.cgi.
+ *
+ *	@param[in]	query	query string
+ *	@param[out]	body	response body
+ *	@param[out]	location	location of redirection or empty
+ *	@param[in]	size	size of location
+ *	@return		0: normal, -1: invalid request (body has the error page)
+ */
+static int
+do_search(const char *query, STRBUF *body, char *location, int size)
+{
+	struct result r;
+	char pattern[IDENTLEN];
+	const char *type, *p, *message, *words = "definitions";
+	int icase, other;
+	int db = GTAGS;
+	int status = 0, invalid = 0;
+
+	location[0] = '\0';
+	if ((p = get_param(query, "pattern")) == NULL || *p == '\0') {
+		put_error(body, "Pattern not specified.");
+		return -1;
+	}
+	if ((message = check_pattern(p)) != NULL) {
+		put_error(body, message);
+		return -1;
+	}
+	strlimcpy(pattern, p, sizeof(pattern));
+	type = get_param(query, "type");
+	type = type ? check_strdup(type) : check_strdup("");
+	icase = (p = get_param(query, "icase")) != NULL && *p && strcmp(p, "0");
+	other = (p = get_param(query, "other")) != NULL && *p && strcmp(p, "0");
+
+	memset(&r, 0, sizeof(r));
+	r.list = strbuf_open(0);
+	if (!strcmp(type, "reference")) {
+		db = GRTAGS;
+		words = "references";
+	} else if (!strcmp(type, "symbol")) {
+		db = GSYMS;
+		words = "symbols";
+	} else if (!strcmp(type, "path")) {
+		db = GPATH;
+		words = "paths";
+	} else if (!strcmp(type, "grep") || !strcmp(type, "idutils")) {
+		db = NOTAGS;
+		words = "patterns";
+	}
+	if (db == NOTAGS) {
+		char flags[8], *f = flags;
+
+		*f++ = !strcmp(type, "grep") ? 'g' : 'I';
+		if (icase)
+			*f++ = 'i';
+		if (other && flags[0] == 'g')
+			*f++ = 'o';
+		*f = '\0';
+		status = search_command(&r, flags, pattern);
+	} else {
+		regex_t reg;
+
+		/*
+		 * gtags_first() dies for an invalid regular expression,
+		 * so it is checked here.
+		 */
+		if (regcomp(&reg, pattern, REG_EXTENDED | (icase ? REG_ICASE : 0)) != 0) {
+			put_error(body, "Invalid regular expression.");
+			invalid = 1;
+			goto finish;
+		}
+		if (db == GPATH)
+			status = search_path(&r, &reg, other);
+		else
+			status = search_tags(&r, pattern, db, icase);
+		regfree(&reg);
+	}
+	if (status < 0) {
+		put_error(body, "Cannot execute global.");
+	} else if (r.count == 0) {
+		put_header(body);
+		strbuf_puts(body, "<h1 class='title'>");
+		put_html(body, pattern);
+		strbuf_puts(body, "</h1>\n");
+		strbuf_sprintf(body, "<h3 class='message'>Pattern not found. <a href='%s/mains.html'>[return]</a></h3>\n", basedir);
+		put_tailer(body);
+	} else if (r.count == 1) {
+		/* direct jump */
+		snprintf(location, size, "%s/S/%s.html#L%d", basedir, r.first_fid, r.first_lno);
+		strbuf_puts(body, "<html>\n");
+		strbuf_sprintf(body, "<head><meta http-equiv=\"Refresh\" content=\"0; url=%s\" /></head>\n", location);
+		strbuf_puts(body, "<body>");
+		put_tailer(body);
+	} else {
+		put_header(body);
+		strbuf_puts(body, "<h1 class='title'>");
+		put_html(body, pattern);
+		strbuf_puts(body, "</h1>\n");
+		strbuf_sprintf(body, "Following %s are matched to above pattern.<hr />\n", words);
+		strbuf_puts(body, "<pre>\n");
+		strbuf_puts(body, strbuf_value(r.list));
+		strbuf_puts(body, "</pre>\n");
+		if (r.truncated)
+			strbuf_sprintf(body, "<hr />Only the first %d objects are shown.\n", r.count);
+		else
+			strbuf_sprintf(body, "<hr />%d objects located.\n", r.count);
+		put_tailer(body);
+	}
+finish:
+	strbuf_close(r.list);
+	free((char *)type);
+	return invalid ? -1 : 0;
+}
+
+/*----------------------------------------------------------------------*/
+/* Completion (completion.cgi)						*/
+/*----------------------------------------------------------------------*/
+/**
+ * do_completion: process a request to completion.cgi.
+ *
+ *	@param[in]	query	query string
+ *	@param[out]	body	response body
+ *	@return		0: normal, -1: invalid request
+ */
+static int
+do_completion(const char *query, STRBUF *body)
+{
+	char prefix[IDENTLEN];
+	const char *type, *p;
+	NAMEINDEX *ni;
+	int icase, other, limit = 0, count = 0;
+	int db;
+
+	if ((p = get_param(query, "q")) == NULL || check_pattern(p) != NULL)
+		return -1;
+	strlimcpy(prefix, p, sizeof(prefix));
+	icase = (p = get_param(query, "icase")) != NULL && *p && strcmp(p, "0");
+	other = (p = get_param(query, "other")) != NULL && *p && strcmp(p, "0");
+	if ((p = get_param(query, "limit")) != NULL)
+		limit = atoi(p);
+	if ((type = get_param(query, "type")) == NULL)
+		return -1;
+	if (!strcmp(type, "definition") || !strcmp(type, "reference"))
+		db = GTAGS;
+	else if (!strcmp(type, "symbol"))
+		db = GSYMS;
+	else if (!strcmp(type, "path"))
+		db = GPATH;
+	else if (!strcmp(type, "grep") || !strcmp(type, "idutils"))
+		return 0;	/* Ignored because completion for grep is groundless. */
+	else
+		return -1;
+	if (db == GPATH) {
+		GFIND *gp;
+		int len = strlen(prefix);
+
+		check_generation();
+		if (!gpath_opened)
+			return 0;
+		gp = gfind_open(dbpath, NULL, other ? GPATH_BOTH : GPATH_SOURCE, 0);
+		while ((p = gfind_read(gp)) != NULL) {
+			p += 2;
+			if (icase ? strncasecmp(p, prefix, len) : strncmp(p, prefix, len))
+				continue;
+			strbuf_puts_nl(body, p);
+			if (limit > 0 && ++count >= limit)
+				break;
+		}
+		gfind_close(gp);
+	} else if ((ni = get_nameindex()) != NULL) {
+		for (p = nameindex_first(ni, prefix, db, icase ? NAMEINDEX_IGNORECASE : 0); p; p = nameindex_next(ni)) {
+			strbuf_puts_nl(body, p);
+			if (limit > 0 && ++count >= limit)
+				break;
+		}
+	} else {
+		GTOP *gt = get_tags(db);
+		GTP *gtp;
+		int flags = GTOP_KEY | GTOP_NOREGEX | GTOP_PREFIX;
+
+		if (gt == NULL)
+			return 0;
+		if (icase)
+			flags |= GTOP_IGNORECASE;
+		for (gtp = gtags_first(gt, *prefix ? prefix : NULL, flags); gtp; gtp = gtags_next(gt)) {
+			strbuf_puts_nl(body, gtp->tag);
+			if (limit > 0 && ++count >= limit)
+				break;
+		}
+	}
+	return 0;
+}
+
+/*----------------------------------------------------------------------*/
+/* Render cache								*/
+/*----------------------------------------------------------------------*/
+/*
+ * Rendered page of global.cgi.
+ *
+ * Pages are looked up by the key made from the request, and ordered by
+ * the last access (the head is the most recently used one).
+ * All pages are made from the current tag files; when they are updated,
+ * the cache is flushed by reopen_tags().
+ */
+struct page {
+	TAILQ_ENTRY(page) lru;		/**< LRU list */
+	struct page *next;		/**< hash chain */
+	unsigned long hash;		/**< hash value of the key */
+	char *key;			/**< key */
+	char *body;			/**< response body */
+	int bodylen;			/**< length of the body */
+	char *location;			/**< location of redirection or NULL */
+	long size;			/**< memory used by this page */
+};
+TAILQ_HEAD(page_list, page);
+static struct page_list lru_list = TAILQ_HEAD_INITIALIZER(lru_list);
+static struct page *buckets[CACHEBUCKETS];
+static long cache_size;			/**< memory used by the cache */
+static unsigned long cache_hits, cache_misses;
+
+/**
+ * cache_key: make the key of a request to global.cgi.
+ *
+ *	@param[out]	sb	key
+ *	@param[in]	query	query string
+ *	@return		0: can be cached, -1: cannot be cached
+ *
+ * The key consists of the type (which decides the tag file), the flags
+ * and the pattern. The result of grep and idutils depends on the source
+ * files rather than the tag files, so they are not cached.
+ */
+static int
+cache_key(STRBUF *sb, const char *query)
+{
+	const char *p;
+
+	strbuf_clear(sb);
+	p = get_param(query, "type");
+	if (p == NULL)
+		p = "";
+	if (!strcmp(p, "grep") || !strcmp(p, "idutils"))
+		return -1;
+	strbuf_puts(sb, p);
+	strbuf_putc(sb, '\n');
+	p = get_param(query, "icase");
+	strbuf_putc(sb, (p && *p && strcmp(p, "0")) ? '1' : '0');
+	p = get_param(query, "other");
+	strbuf_putc(sb, (p && *p && strcmp(p, "0")) ? '1' : '0');
+	strbuf_putc(sb, '\n');
+	p = get_param(query, "pattern");
+	if (p == NULL || *p == '\0')
+		return -1;
+	strbuf_puts(sb, p);
+	return 0;
+}
+/**
+ * cache_remove: remove a page from the cache.
+ */
+static void
+cache_remove(struct page *pg)
+{
+	struct page **pp;
+
+	for (pp = &buckets[pg->hash % CACHEBUCKETS]; *pp; pp = &(*pp)->next) {
+		if (*pp == pg) {
+			*pp = pg->next;
+			break;
+		}
+	}
+	TAILQ_REMOVE(&lru_list, pg, lru);
+	cache_size -= pg->size;
+	free(pg->key);
+	free(pg->body);
+	if (pg->location)
+		free(pg->location);
+	free(pg);
+}
+/**
+ * cache_flush: remove all pages from the cache.
+ */
+static void
+cache_flush(void)
+{
+	while (!TAILQ_EMPTY(&lru_list))
+		cache_remove(TAILQ_FIRST(&lru_list));
+}
+/**
+ * cache_lookup: look up a page in the cache.
+ *
+ *	@param[in]	key	key made by cache_key()
+ *	@return		page or NULL (not found)
+ *
+ * This doesn't touch the tag files except for checking their time stamps.
+ */
+static struct page *
+cache_lookup(const char *key)
+{
+	unsigned long hash = __hash_string(key);
+	struct page *pg;
+
+	check_generation();	/* flushes the cache if the tag files were updated */
+	for (pg = buckets[hash % CACHEBUCKETS]; pg; pg = pg->next) {
+		if (pg->hash == hash && !strcmp(pg->key, key)) {
+			TAILQ_REMOVE(&lru_list, pg, lru);
+			TAILQ_INSERT_HEAD(&lru_list, pg, lru);
+			cache_hits++;
+			return pg;
+		}
+	}
+	cache_misses++;
+	return NULL;
+}
+/**
+ * cache_enter: enter a page into the cache.
+ *
+ *	@param[in]	key	key made by cache_key()
+ *	@param[in]	body	response body
+ *	@param[in]	location	location of redirection or empty
+ *
+ * Least recently used pages are evicted to keep the cache under the limit.
+ */
+static void
+cache_enter(const char *key, STRBUF *body, const char *location)
+{
+	struct page *pg;
+	long size = sizeof(struct page) + strlen(key) + 1 + strbuf_getlen(body) + strlen(location) + 1;
+
+	if (size > cache_limit)
+		return;
+	while (cache_size + size > cache_limit && !TAILQ_EMPTY(&lru_list))
+		cache_remove(TAILQ_LAST(&lru_list, page_list));
+	pg = check_calloc(sizeof(struct page), 1);
+	pg->hash = __hash_string(key);
+	pg->key = check_strdup(key);
+	pg->bodylen = strbuf_getlen(body);
+	pg->body = check_malloc(pg->bodylen + 1);
+	memcpy(pg->body, strbuf_value(body), pg->bodylen + 1);
+	pg->location = *location ? check_strdup(location) : NULL;
+	pg->size = size;
+	pg->next = buckets[pg->hash % CACHEBUCKETS];
+	buckets[pg->hash % CACHEBUCKETS] = pg;
+	TAILQ_INSERT_HEAD(&lru_list, pg, lru);
+	cache_size += size;
+}
+
+/*----------------------------------------------------------------------*/
+/* HTTP									*/
+/*----------------------------------------------------------------------*/
+/*
+ * Connection.
+ */
+struct conn {
+	int fd;				/**< socket (-1: not used) */
+	int writing;			/**< 0: reading request, 1: writing */
+	time_t last;			/**< time of the last activity */
+	STRBUF *ib;			/**< request */
+	STRBUF *ob;			/**< response header and body */
+	int ob_offset;			/**< sent bytes of ob */
+	int file;			/**< static file (-1: none) */
+	off_t file_offset;		/**< sent bytes of the file */
+	off_t file_size;		/**< size of the file */
+};
+static struct conn conns[MAXCONN];
+static int server_socket = -1;		/**< listening socket */
+static int nchild;			/**< number of search processes */
+
+static void close_conn(struct conn *);
+static int write_response(struct conn *);
+
+static const struct {
+	const char *suffix;
+	const char *type;
+} mimetypes[] = {
+	{".html",	"text/html"},
+	{".htm",	"text/html"},
+	{".css",	"text/css"},
+	{".js",		"application/javascript"},
+	{".png",	"image/png"},
+	{".gif",	"image/gif"},
+	{".jpg",	"image/jpeg"},
+	{".ico",	"image/x-icon"},
+	{".txt",	"text/plain"},
+	{".sh",		"text/plain"},
+	{NULL,		NULL}
+};
+/**
+ * mimetype: get the content type of a file.
+ */
+static const char *
+mimetype(const char *path)
+{
+	const char *suffix = locatestring(path, ".", MATCH_LAST);
+	int i;
+
+	if (suffix && strchr(suffix, '/') == NULL)
+		for (i = 0; mimetypes[i].suffix; i++)
+			if (!strcmp(suffix, mimetypes[i].suffix))
+				return mimetypes[i].type;
+	return "application/octet-stream";
+}
+/**
+ * put_response_header: put response header.
+ *
+ *	@param[out]	sb	buffer
+ *	@param[in]	status	status line (e.g. "200 OK")
+ *	@param[in]	type	content type or NULL
+ *	@param[in]	length	content length
+ *	@param[in]	location	location or NULL
+ *	@param[in]	encoding	content encoding or NULL
+ */
+static void
+put_response_header(STRBUF *sb, const char *status, const char *type, long length, const char *location, const char *encoding)
+{
+	char buf[64];
+
+	strbuf_sprintf(sb, "HTTP/1.0 %s\r\n", status);
+	strbuf_puts(sb, "Server: htags-server (" PACKAGE_STRING ")\r\n");
+	if (type)
+		strbuf_sprintf(sb, "Content-Type: %s\r\n", type);
+	if (encoding)
+		strbuf_sprintf(sb, "Content-Encoding: %s\r\n", encoding);
+	snprintf(buf, sizeof(buf), "%ld", length);
+	strbuf_sprintf(sb, "Content-Length: %s\r\n", buf);
+	if (location)
+		strbuf_sprintf(sb, "Location: %s\r\n", location);
+	strbuf_puts(sb, "Connection: close\r\n\r\n");
+}
+/**
+ * respond: make a response whose body is in memory.
+ */
+static void
+respond(struct conn *c, const char *status, const char *type, STRBUF *body, const char *location, int head)
+{
+	put_response_header(c->ob, status, type, strbuf_getlen(body), location, NULL);
+	if (!head)
+		strbuf_nputs(c->ob, strbuf_value(body), strbuf_getlen(body));
+}
+/**
+ * respond_error: make an error response.
+ */
+static void
+respond_error(struct conn *c, const char *status, int head)
+{
+	STRBUF *body = strbuf_open(0);
+
+	strbuf_sprintf(body, "<html><head><title>%s</title></head><body><h1>%s</h1></body></html>\n", status, status);
+	respond(c, status, "text/html", body, NULL, head);
+	strbuf_close(body);
+}
+/**
+ * respond_file: make a response for a static file.
+ *
+ *	@param[in]	c	connection
+ *	@param[in]	path	path name (relative to the HTML directory)
+ *	@param[in]	head	1: HEAD request
+ *
+ * If the file doesn't exist, '<path>.gz' made by htags --gzipped is sent
+ * instead with 'Content-Encoding: gzip'.
+ */
+static void
+respond_file(struct conn *c, const char *path, int head)
+{
+	char buf[MAXPATHLEN], gz[MAXPATHLEN];
+	const char *encoding = NULL;
+	struct stat st;
+	int fd;
+
+	/*
+	 * A path name which doesn't fit is not found, since the truncated
+	 * name may be another file.
+	 */
+	if (*path == '\0' || (stat(path, &st) == 0 && S_ISDIR(st.st_mode))) {
+		if (snprintf(buf, sizeof(buf), "%s%sindex.html", path,
+		    (*path && path[strlen(path) - 1] != '/') ? "/" : "") >= (int)sizeof(buf)) {
+			respond_error(c, "404 Not Found", head);
+			return;
+		}
+		path = buf;
+	}
+	if ((fd = open(path, O_RDONLY)) < 0) {
+		if (snprintf(gz, sizeof(gz), "%s.gz", path) >= (int)sizeof(gz)
+		    || (fd = open(gz, O_RDONLY)) < 0) {
+			respond_error(c, "404 Not Found", head);
+			return;
+		}
+		encoding = "gzip";
+	}
+	if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+		close(fd);
+		respond_error(c, "404 Not Found", head);
+		return;
+	}
+	put_response_header(c->ob, "200 OK", mimetype(path), (long)st.st_size, NULL, encoding);
+	if (head) {
+		close(fd);
+		return;
+	}
+	c->file = fd;
+	c->file_offset = 0;
+	c->file_size = st.st_size;
+}
+/**
+ * respond_search: make a response for global.cgi.
+ *
+ *	@param[in]	c	connection
+ *	@param[in]	query	query string
+ *	@param[in]	head	1: HEAD request
+ */
+static void
+respond_search(struct conn *c, const char *query, int head)
+{
+	STATIC_STRBUF(key);
+	STRBUF *body = strbuf_open(0);
+	struct page *pg = NULL;
+	char location[MAXPATHLEN];
+	int cacheable = cache_limit > 0 && cache_key(key, query) == 0;
+
+	if (cacheable && (pg = cache_lookup(strbuf_value(key))) != NULL) {
+		strbuf_nputs(body, pg->body, pg->bodylen);
+		strlimcpy(location, pg->location ? pg->location : "", sizeof(location));
+	} else if (do_search(query, body, location, sizeof(location)) < 0) {
+		respond(c, "400 Bad Request", "text/html", body, NULL, head);
+		goto finish;
+	} else if (cacheable) {
+		cache_enter(strbuf_value(key), body, location);
+	}
+	if (vflag && cacheable)
+		fprintf(stderr, "htags-server: cache %s (hits=%lu, misses=%lu, size=%ld)\n",
+			pg ? "hit" : "miss", cache_hits, cache_misses, cache_size);
+	if (location[0])
+		respond(c, "302 Found", "text/html", body, location, head);
+	else
+		respond(c, "200 OK", "text/html", body, NULL, head);
+finish:
+	strbuf_close(body);
+}
+/**
+ * fork_search: make a response for global.cgi in a child process.
+ *
+ *	@param[in]	c	connection
+ *	@param[in]	query	query string
+ *	@param[in]	head	1: HEAD request
+ *
+ * Grep and idutils read all source files and may take a long time.
+ * They are done in a child process, which writes the response and
+ * exits, so that the other connections are not blocked.
+ * The connection is closed in this process.
+ */
+static void
+fork_search(struct conn *c, const char *query, int head)
+{
+	pid_t pid;
+	int i, flags;
+
+	if (nchild >= MAXCHILD) {
+		respond_error(c, "503 Service Unavailable", head);
+		return;
+	}
+	fflush(stdout);
+	fflush(stderr);
+	if ((pid = fork()) < 0) {
+		respond_error(c, "500 Internal Server Error", head);
+		return;
+	}
+	if (pid > 0) {
+		nchild++;
+		close_conn(c);
+		return;
+	}
+	/*
+	 * Child process: the other connections belong to the parent.
+	 */
+	close(server_socket);
+	for (i = 0; i < MAXCONN; i++) {
+		if (&conns[i] == c || conns[i].fd < 0)
+			continue;
+		close(conns[i].fd);
+		if (conns[i].file >= 0)
+			close(conns[i].file);
+	}
+	respond_search(c, query, head);
+	if ((flags = fcntl(c->fd, F_GETFL, 0)) >= 0)
+		(void)fcntl(c->fd, F_SETFL, flags & ~O_NONBLOCK);
+	while (write_response(c) == 0)
+		;
+	close(c->fd);
+	_exit(0);
+}
+/**
+ * process_request: process a request.
+ *
+ *	@param[in]	c	connection
+ */
+static void
+process_request(struct conn *c)
+{
+	STRBUF *path = strbuf_open(0);
+	STRBUF *body = strbuf_open(0);
+	char *method, *uri, *query, *p;
+	int head = 0;
+
+	/*
+	 * Request-Line = Method SP Request-URI SP HTTP-Version CRLF
+	 */
+	method = strbuf_value(c->ib);
+	if ((p = strchr(method, '\r')) != NULL || (p = strchr(method, '\n')) != NULL)
+		*p = '\0';
+	if ((uri = strchr(method, ' ')) == NULL) {
+		respond_error(c, "400 Bad Request", 0);
+		goto finish;
+	}
+	*uri++ = '\0';
+	if ((p = strchr(uri, ' ')) != NULL)
+		*p = '\0';
+	if (!strcmp(method, "HEAD"))
+		head = 1;
+	else if (strcmp(method, "GET")) {
+		respond_error(c, "501 Not Implemented", 0);
+		goto finish;
+	}
+	if (vflag)
+		fprintf(stderr, "%s %s\n", method, uri);
+	if ((query = strchr(uri, '?')) != NULL)
+		*query++ = '\0';
+	else
+		query = "";
+	if ((p = strchr(uri, '#')) != NULL)
+		*p = '\0';
+	url_decode(path, uri, strlen(uri), 0);
+	p = strbuf_value(path);
+	/*
+	 * Reject anything outside of the HTML directory.
+	 */
+	if (*p != '/' || strlen(p) != (size_t)strbuf_getlen(path)
+	    || locatestring(p, "/../", MATCH_FIRST) || locatestring(p, "/..", MATCH_AT_LAST)) {
+		respond_error(c, "403 Forbidden", head);
+		goto finish;
+	}
+	while (*p == '/')
+		p++;
+	if (!strcmp(p, "cgi-bin/global.cgi")) {
+		const char *type = get_param(query, "type");
+
+		if (type && (!strcmp(type, "grep") || !strcmp(type, "idutils")))
+			fork_search(c, query, head);
+		else
+			respond_search(c, query, head);
+	} else if (!strcmp(p, "cgi-bin/completion.cgi")) {
+		if (do_completion(query, body) < 0)
+			respond_error(c, "400 Bad Request", head);
+		else
+			respond(c, "200 OK", "text/html", body, NULL, head);
+	} else if (!strncmp(p, "cgi-bin/", 8)) {
+		respond_error(c, "404 Not Found", head);
+	} else {
+		respond_file(c, p, head);
+	}
+finish:
+	strbuf_close(path);
+	strbuf_close(body);
+}
+/**
+ * close_conn: close a connection.
+ */
+static void
+close_conn(struct conn *c)
+{
+	close(c->fd);
+	if (c->file >= 0)
+		close(c->file);
+	c->fd = c->file = -1;
+	strbuf_reset(c->ib);
+	strbuf_reset(c->ob);
+}
+/**
+ * read_request: read a request from the socket.
+ *
+ *	@return		0: continue, -1: close connection
+ */
+static int
+read_request(struct conn *c)
+{
+	char buf[MAXREQUEST];
+	ssize_t n;
+
+	n = read(c->fd, buf, sizeof(buf));
+	if (n < 0)
+		return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+	if (n == 0)
+		return -1;
+	strbuf_nputs(c->ib, buf, n);
+	if (strbuf_getlen(c->ib) > MAXREQUEST) {
+		strbuf_reset(c->ib);
+		respond_error(c, "413 Request Entity Too Large", 0);
+		c->writing = 1;
+		return 0;
+	}
+	/*
+	 * The request header ends with an empty line.
+	 * The request body (if any) is ignored.
+	 */
+	if (locatestring(strbuf_value(c->ib), "\r\n\r\n", MATCH_FIRST)
+	    || locatestring(strbuf_value(c->ib), "\n\n", MATCH_FIRST)) {
+		process_request(c);
+		c->writing = 1;
+	}
+	return 0;
+}
+/**
+ * write_response: write the response to the socket.
+ *
+ *	@return		0: continue, 1: completed, -1: error
+ */
+static int
+write_response(struct conn *c)
+{
+	ssize_t n;
+
+	if (c->ob_offset < strbuf_getlen(c->ob)) {
+		n = write(c->fd, strbuf_value(c->ob) + c->ob_offset, strbuf_getlen(c->ob) - c->ob_offset);
+		if (n < 0)
+			return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+		c->ob_offset += n;
+		return 0;
+	}
+	if (c->file >= 0 && c->file_offset < c->file_size) {
+#ifdef USE_SENDFILE
+		n = sendfile(c->fd, c->file, &c->file_offset, c->file_size - c->file_offset);
+		if (n < 0)
+			return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+		if (n == 0)
+			return -1;
+#else
+		char buf[8192];
+		ssize_t m;
+
+		if (lseek(c->file, c->file_offset, SEEK_SET) < 0)
+			return -1;
+		if ((m = read(c->file, buf, sizeof(buf))) <= 0)
+			return -1;
+		n = write(c->fd, buf, m);
+		if (n < 0)
+			return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+		c->file_offset += n;
+#endif
+		return 0;
+	}
+	return 1;
+}
+/**
+ * set_nonblock: set the non-blocking mode to a descripter.
+ */
+static void
+set_nonblock(int fd)
+{
+	int flags = fcntl(fd, F_GETFL, 0);
+
+	if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+		die("cannot set non-blocking mode.");
+}
+/**
+ * open_server: open the server socket.
+ *
+ *	@return		socket
+ */
+static int
+open_server(void)
+{
+	struct sockaddr_in addr;
+	int limit = port + retry;
+	int s, on = 1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	if (inet_pton(AF_INET, bind_address, &addr.sin_addr) != 1)
+		die("invalid IP address '%s'.", bind_address);
+	for (;;) {
+		if ((s = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+			die("cannot make socket.");
+		setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (void *)&on, sizeof(on));
+		addr.sin_port = htons(port);
+		if (bind(s, (struct sockaddr *)&addr, sizeof(addr)) == 0)
+			break;
+		if (errno != EADDRINUSE)
+			die("cannot bind to %s:%d (errno = %d).", bind_address, port, errno);
+		close(s);
+		if (retry == 0)
+			die("port %d already in use.", port);
+		fprintf(stdout, "Warning: port %d already in use (skipped)\n", port);
+		if (++port > limit)
+			die("gave up.");
+	}
+	if (listen(s, SOMAXCONN) < 0)
+		die("cannot listen on port %d.", port);
+	set_nonblock(s);
+	return s;
+}
+/**
+ * serve: main loop.
+ *
+ *	@param[in]	s	server socket
+ */
+static void
+serve(int s)
+{
+	struct pollfd fds[MAXCONN + 1];
+	int map[MAXCONN + 1];
+	int i, n;
+
+	for (i = 0; i < MAXCONN; i++) {
+		conns[i].fd = conns[i].file = -1;
+		conns[i].ib = strbuf_open(0);
+		conns[i].ob = strbuf_open(0);
+	}
+	server_socket = s;
+	for (;;) {
+		time_t now = time(NULL);
+		int used = 0;
+
+		/* reap the search processes */
+		while (nchild > 0 && waitpid(-1, NULL, WNOHANG) > 0)
+			nchild--;
+		n = 0;
+		for (i = 0; i < MAXCONN; i++) {
+			struct conn *c = &conns[i];
+
+			if (c->fd < 0)
+				continue;
+			if (now - c->last > TIMEOUT) {
+				close_conn(c);
+				continue;
+			}
+			fds[n].fd = c->fd;
+			fds[n].events = c->writing ? POLLOUT : POLLIN;
+			fds[n].revents = 0;
+			map[n++] = i;
+			used++;
+		}
+		/* accept new connections only when there is room */
+		if (used < MAXCONN) {
+			fds[n].fd = s;
+			fds[n].events = POLLIN;
+			fds[n].revents = 0;
+			map[n++] = -1;
+		}
+		if (poll(fds, n, 1000) < 0) {
+			if (errno == EINTR)
+				continue;
+			die("poll failed (errno = %d).", errno);
+		}
+		now = time(NULL);
+		for (i = 0; i < n; i++) {
+			struct conn *c;
+			int status;
+
+			if (fds[i].revents == 0)
+				continue;
+			if (map[i] < 0) {
+				int fd, j;
+
+				while ((fd = accept(s, NULL, NULL)) >= 0) {
+					for (j = 0; j < MAXCONN; j++)
+						if (conns[j].fd < 0)
+							break;
+					if (j == MAXCONN) {
+						close(fd);
+						break;
+					}
+					set_nonblock(fd);
+					c = &conns[j];
+					c->fd = fd;
+					c->writing = 0;
+					c->last = now;
+					c->ob_offset = 0;
+					c->file = -1;
+					strbuf_reset(c->ib);
+					strbuf_reset(c->ob);
+				}
+				continue;
+			}
+			c = &conns[map[i]];
+			c->last = now;
+			if (fds[i].revents & (POLLERR | POLLNVAL)) {
+				close_conn(c);
+				continue;
+			}
+			if (!c->writing) {
+				if (read_request(c) < 0)
+					close_conn(c);
+			} else {
+				status = write_response(c);
+				if (status != 0)
+					close_conn(c);
+			}
+		}
+	}
+}
+/**
+ * locate_root: locate the root of the source tree and tag files.
+ *
+ * The current directory must be the HTML directory.
+ */
+static void
+locate_root(void)
+{
+	char buf[MAXPATHLEN];
+	const char *p;
+	FILE *ip;
+
+	/*
+	 * Same as the CGI programs: HTML/GTAGSROOT or the parent directory.
+	 */
+	if ((ip = fopen("GTAGSROOT", "r")) != NULL) {
+		STRBUF *sb = strbuf_open(0);
+
+		if ((p = strbuf_fgets(sb, ip, STRBUF_NOCRLF)) != NULL)
+			strlimcpy(buf, p, sizeof(buf));
+		else
+			strlimcpy(buf, "..", sizeof(buf));
+		strbuf_close(sb);
+		fclose(ip);
+	} else {
+		strlimcpy(buf, "..", sizeof(buf));
+	}
+	if (realpath(buf, root) == NULL)
+		die("GTAGSROOT directory '%s' not found.", buf);
+	if ((p = getenv("GTAGSDBPATH")) != NULL && *p)
+		strlimcpy(dbpath, p, sizeof(dbpath));
+	else if (!gtagsexist(root, dbpath, sizeof(dbpath), vflag))
+		die("GTAGS not found in '%s'.", root);
+	if (!test("f", makepath(dbpath, dbname(GPATH), NULL)))
+		die("GPATH not found in '%s'.", dbpath);
+	check_generation();
+}
+int
+main(int argc, char **argv)
+{
+	int optchar;
+	int option_index = 0;
+	int s;
+
+	logging_arguments(argc, argv);
+	while ((optchar = getopt_long(argc, argv, short_options, long_options, &option_index)) != EOF) {
+		switch (optchar) {
+		case 0:
+			break;
+		case 'b':
+			bind_address = optarg;
+			break;
+		case 'c':
+			{
+				const char *p;
+
+				for (p = optarg; *p; p++)
+					if (!isdigit((unsigned char)*p))
+						die("Invalid cache size '%s'.", optarg);
+				cache_limit = atol(optarg) * 1024;
+			}
+			break;
+		case 'u':
+			/* Ignored. Python or Ruby is no longer required. */
+			break;
+		case 'r':
+			retry = optarg ? atoi(optarg) : 20;
+			break;
+		default:
+			usage();
+			break;
+		}
+	}
+	if (show_version)
+		version(NULL, vflag);
+	if (show_help)
+		help();
+	argc -= optind;
+	argv += optind;
+	if (argc > 0) {
+		const char *p;
+
+		for (p = argv[0]; *p; p++)
+			if (!isdigit((unsigned char)*p))
+				die("Invalid port number '%s'.", argv[0]);
+		port = atoi(argv[0]);
+		if (port <= 0 || port > 65535)
+			die("Invalid port number '%s'.", argv[0]);
+	}
+	/*
+	 * sanity check
+	 */
+	if (!test("d", "HTML"))
+		die("Please invoke this command at the project root directory.");
+	if (chdir("HTML") < 0)
+		die("Cannot change directory.");
+	if (!(test("f", "index.html") && test("f", "help.html") && test("d", "files") && test("d", "defines")))
+		die("It seems that this hyper-text is broken.");
+	locate_root();
+	signal(SIGPIPE, SIG_IGN);
+	s = open_server();
+	fprintf(stdout, "Please access at http://%s:%d\n", bind_address, port);
+	fprintf(stdout, "Serving HTTP on %s port %d ...\n", bind_address, port);
+	fflush(stdout);
+	serve(s);
+	return 0;
+}
+#endif
@@ -31,6 +31,7 @@
 #include "common.h"
 #include "global.h"
 #include "htags.h"
+#include "incremental.h"
 
 /*
  * Data for each tag file.
@@ -41,6 +42,58 @@ static const char *dirs[]    = {NULL, DEFS,         REFS,        SYMS};
 static const char *kinds[]   = {NULL, "definition", "reference", "symbol"};
 static const char *options[] = {NULL, "",           "r",         "s"};
 
+/**
+ * put_cache: put a cache record, and record it for incremental updating.
+ */
+static void
+put_cache(int db, const char *tag, const char *record, int len)
+{
+	cache_put(db, tag, record, len);
+	if (incremental)
+		incremental_tag(db, tag, record, len);
+}
+/**
+ * put_page: write a tag list page from the saved lines.
+ *
+ *	@param[in]	db	GTAGS, GRTAGS or GSYMS
+ *	@param[in]	tag	tag name
+ *	@param[in]	pageno	page number
+ *	@param[in]	lines	lines of the tag list (ctags-xid format)
+ *	@param[in]	srcdir	relative path to the source pages
+ *
+ * In incremental mode, the lines of a tag list are saved instead of being
+ * written, and the page is written only when they changed since the last run.
+ */
+static void
+put_page(int db, const char *tag, int pageno, STRBUF *lines, const char *srcdir)
+{
+	char path[MAXPATHLEN];
+	const char *p, *end;
+	FILEOP *fileop;
+	FILE *op;
+
+	if (snprintf(path, sizeof(path), "%s/%s/%d.%s", distpath, dirs[db], pageno, HTML) >= (int)sizeof(path))
+		die("path name too long. '%s'", distpath);
+	if (!incremental_page(db, tag, strbuf_value(lines), strbuf_getlen(lines), path))
+		return;
+	fileop = open_output_file(path, 0);
+	op = get_descripter(fileop);
+	fputs_nl(gen_page_begin(tag, SUBDIR), op);
+	fputs_nl(body_begin, op);
+	fputs_nl(gen_list_begin(), op);
+	end = strbuf_value(lines) + strbuf_getlen(lines);
+	for (p = strbuf_value(lines); p < end; p += strlen(p) + 1) {
+		char fid[MAXFIDLEN];
+		const char *ctags_x = parse_xid(p, fid, NULL);
+
+		fputs_nl(gen_list_body(srcdir, ctags_x, fid), op);
+	}
+	fputs_nl(gen_list_end(), op);
+	fputs_nl(body_end, op);
+	fputs_nl(gen_page_end(), op);
+	close_file(fileop);
+	html_count++;
+}
 /**
  * Make duplicate object index.
  *
@@ -54,6 +107,7 @@ makedupindex(void)
 	STRBUF *sb = strbuf_open(0);
 	STRBUF *tmp = strbuf_open(0);
 	STRBUF *command = strbuf_open(0);
+	STRBUF *lines = strbuf_open(0);
 	int definition_count = 0;
 	char srcdir[MAXPATHLEN];
 	int db;
@@ -67,6 +121,7 @@ makedupindex(void)
 		const char *option = options[db];
 		int writing = 0;
 		int count = 0;
+		int pageno = 0;
 		int entry_count = 0;
 		const char *ctags_xid, *ctags_x;
 		char tag[IDENTLEN], prev[IDENTLEN], first_line[MAXBUFLEN];
@@ -108,7 +163,9 @@ makedupindex(void)
 				if (vflag)
 					fprintf(stderr, " [%d] adding %s %s\n", count, kind, tag);
 				if (writing) {
-					if (!dynamic) {
+					if (incremental && !dynamic) {
+						put_page(db, prev, pageno, lines, srcdir);
+					} else if (!dynamic) {
 						fputs_nl(gen_list_end(), op);
 						fputs_nl(body_end, op);
 						fputs_nl(gen_page_end(), op);
@@ -121,10 +178,10 @@ makedupindex(void)
 					 */
 					strbuf_reset(tmp);
 					strbuf_putc(tmp, ' ');
-					strbuf_putn(tmp, count - 1);
+					strbuf_putn(tmp, pageno);
 					strbuf_putc(tmp, '\0');
 					strbuf_putn(tmp, entry_count);
-					cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
+					put_cache(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
 				}				
 				/* single entry */
 				if (first_line[0]) {
@@ -136,7 +193,7 @@ makedupindex(void)
 					strbuf_puts_withterm(tmp, lno, ' ');
 					strbuf_putc(tmp, '\0');
 					strbuf_puts(tmp, fid);
-					cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
+					put_cache(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
 				}
 				/*
 				 * Chop the tail of the line. It is not important.
@@ -152,10 +209,18 @@ makedupindex(void)
 					char fid[MAXFIDLEN];
 					const char *ctags_x = parse_xid(first_line, fid, NULL);
 
-					if (!dynamic) {
+					/*
+					 * In incremental mode, the page number of the tag
+					 * is kept across runs.
+					 */
+					pageno = incremental ? incremental_pageno(db, tag) : count;
+					if (incremental && !dynamic) {
+						strbuf_reset(lines);
+						strbuf_puts0(lines, first_line);
+					} else if (!dynamic) {
 						char path[MAXPATHLEN];
 
-						snprintf(path, sizeof(path), "%s/%s/%d.%s", distpath, dirs[db], count, HTML);
+						snprintf(path, sizeof(path), "%s/%s/%d.%s", distpath, dirs[db], pageno, HTML);
 						fileop = open_output_file(path, 0);
 						op = get_descripter(fileop);
 						fputs_nl(gen_page_begin(tag, SUBDIR), op);
@@ -167,7 +232,9 @@ makedupindex(void)
 					entry_count++;
 					first_line[0] = 0;
 				}
-				if (!dynamic) {
+				if (incremental && !dynamic) {
+					strbuf_puts0(lines, ctags_xid);
+				} else if (!dynamic) {
 					fputs_nl(gen_list_body(srcdir, ctags_x, fid), op);
 				}
 				entry_count++;
@@ -178,7 +245,9 @@ makedupindex(void)
 		if (pclose(ip) != 0)
 			die("terminated abnormally '%s' (errno = %d).", strbuf_value(command), errno);
 		if (writing) {
-			if (!dynamic) {
+			if (incremental && !dynamic) {
+				put_page(db, prev, pageno, lines, srcdir);
+			} else if (!dynamic) {
 				fputs_nl(gen_list_end(), op);
 				fputs_nl(body_end, op);
 				fputs_nl(gen_page_end(), op);
@@ -190,10 +259,10 @@ makedupindex(void)
 			 */
 			strbuf_reset(tmp);
 			strbuf_putc(tmp, ' ');
-			strbuf_putn(tmp, count);
+			strbuf_putn(tmp, pageno);
 			strbuf_putc(tmp, '\0');
 			strbuf_putn(tmp, entry_count);
-			cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
+			put_cache(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
 		}
 		if (first_line[0]) {
 			char fid[MAXFIDLEN];
@@ -204,11 +273,14 @@ makedupindex(void)
 			strbuf_puts_withterm(tmp, lno, ' ');
 			strbuf_putc(tmp, '\0');
 			strbuf_puts(tmp, fid);
-			cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
+			put_cache(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
 		}
+		if (incremental)
+			incremental_tag_sweep(db);
 	}
 	strbuf_close(sb);
 	strbuf_close(tmp);
 	strbuf_close(command);
+	strbuf_close(lines);
 	return definition_count;
 }
@@ -35,6 +35,7 @@
 
 #include "global.h"
 #include "incop.h"
+#include "incremental.h"
 #include "htags.h"
 #include "path2url.h"
 #include "common.h"
@@ -601,8 +602,12 @@ print_file_name(int level, const char *path)
 	 * C++: .hxx, .hpp, .H, .hh
 	 * PHP: .inc.php
 	 */
+	/*
+	 * The file id is used as the id of the include file index,
+	 * since it is stable across runs (See incremental.c).
+	 */
 	if (regexec(&is_include_file, path, 0, 0, 0) == 0)
-		put_inc(lastpart(path), path, src_count);
+		put_inc(lastpart(path), path, atoi(path2fid(path)));
 	strbuf_clear(sb);
 	if (table_flist)
 		strbuf_puts(sb, fitem_begin);
@@ -788,14 +793,104 @@ makefileindex(const char *file, STRBUF *a_files)
 /*----------------------------------------------------------------------*/
 /* Main body of generating include file index				*/
 /*----------------------------------------------------------------------*/
-void
-makeincludeindex(void)
+/*
+ * Include reference picked up from GINCLUDE.
+ */
+struct incref {
+	char *path;			/**< path of the including file */
+	int lineno;			/**< line number of the directive */
+	char *line;			/**< ctags-x format line */
+};
+static int
+compare_incref(const void *v1, const void *v2)
+{
+	const struct incref *r1 = v1, *r2 = v2;
+	int ret;
+
+	if ((ret = strcmp(r1->path, r2->path)) != 0)
+		return ret;
+	return r1->lineno - r2->lineno;
+}
+/**
+ * load_included: load include references from GINCLUDE.
+ *
+ *	@param[in]	ginc	GINCLUDE
+ *
+ * Gtags(1) recorded include directives while parsing, so we need not
+ * grep all source files. References are sorted by path and line number
+ * to keep the same order as 'global -gnx'.
+ */
+static void
+load_included(GINCLUDE *ginc)
+{
+	VARRAY *vb = varray_open(sizeof(struct incref), 100);
+	STRBUF *sb = strbuf_open(0);
+	struct incref *ref;
+	struct data *inc;
+	GINCREC *rec;
+	const char *path, *p;
+	char buf[32];
+	int i, start;
+
+	if (gpath_open(dbpath, 0) < 0)
+		die("GPATH not found.");
+	for (rec = ginclude_first(ginc, NULL); rec; rec = ginclude_next(ginc)) {
+		if ((inc = get_inc(rec->name)) == NULL)
+			continue;
+		if ((path = gpath_fid2path(rec->fid, NULL)) == NULL)
+			continue;
+		/*
+		 * Same as 'global -gnx --encode-path=" \t"' except for the tag.
+		 */
+		strbuf_reset(sb);
+		strbuf_puts(sb, rec->name);
+		snprintf(buf, sizeof(buf), " %4d ", rec->lineno);
+		strbuf_puts(sb, buf);
+		start = strbuf_getlen(sb);
+		for (p = path; *p; p++) {
+			if (*p == ' ' || *p == '\t' || *p == '%') {
+				snprintf(buf, sizeof(buf), "%%%02x", (unsigned char)*p);
+				strbuf_puts(sb, buf);
+			} else
+				strbuf_putc(sb, *p);
+		}
+		while (strbuf_getlen(sb) - start < 16)
+			strbuf_putc(sb, ' ');
+		strbuf_putc(sb, ' ');
+		strbuf_puts(sb, rec->image);
+		ref = varray_append(vb);
+		ref->path = check_strdup(path);
+		ref->lineno = rec->lineno;
+		ref->line = check_strdup(strbuf_value(sb));
+	}
+	gpath_close();
+	if (vb->length > 0)
+		qsort(varray_assign(vb, 0, 0), vb->length, sizeof(struct incref), compare_incref);
+	for (i = 0; i < vb->length; i++) {
+		ref = varray_assign(vb, i, 0);
+		/* the first part of the line is the last name */
+		p = strchr(ref->line, ' ');
+		strbuf_reset(sb);
+		strbuf_nputs(sb, ref->line, p - ref->line);
+		put_included(get_inc(strbuf_value(sb)), ref->line);
+		free(ref->path);
+		free(ref->line);
+	}
+	varray_close(vb);
+	strbuf_close(sb);
+}
+/**
+ * grep_included: pick up include references using 'global -gnx'.
+ *
+ * This is used when GINCLUDE doesn't exist (tag files made by older gtags).
+ */
+static void
+grep_included(void)
 {
 	FILE *PIPE;
 	STRBUF *input = strbuf_open(0);
 	char *ctags_x;
 	struct data *inc;
-	char *target = (Fflag) ? "mains" : "_top";
 	char command[MAXFILLEN];
 
 	/*
@@ -849,13 +944,29 @@ makeincludeindex(void)
 	}
 	if (pclose(PIPE) != 0)
 		die("terminated abnormally '%s' (errno = %d).", command, errno);
+	strbuf_close(input);
+}
+void
+makeincludeindex(void)
+{
+	GINCLUDE *ginc;
+	struct data *inc;
+	char *target = (Fflag) ? "mains" : "_top";
 
+	if ((ginc = ginclude_open(dbpath, GTAGS_READ)) != NULL) {
+		load_included(ginc);
+		ginclude_close(ginc);
+	} else {
+		grep_included();
+	}
 	for (inc = first_inc(); inc; inc = next_inc()) {
 		const char *last = inc->name;
 		int no = inc->id;
 		FILEOP *fileop_INCLUDE;
 		FILE *INCLUDE;
 
+		if (incremental)
+			incremental_include(inc);
 		if (inc->count > 1) {
 			char path[MAXPATHLEN];
 
@@ -930,5 +1041,6 @@ makeincludeindex(void)
 			inc->ref_contents = NULL;
 		}
 	}
-	strbuf_close(input);
+	if (incremental)
+		incremental_include_sweep();
 }
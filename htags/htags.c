@@ -51,6 +51,7 @@
 #include "common.h"
 #include "htags.h"
 #include "incop.h"
+#include "incremental.h"
 #include "path2url.h"
 #include "const.h"
 
@@ -131,6 +132,8 @@ int fixed_guide;			/**< --fixed-guide		*/
 const char *tree_view_type;		/**< --type-view=[type]		*/
 char *auto_completion_limit = "0";	/**< --auto-completion=limit	*/
 int statistics = STATISTICS_STYLE_NONE;	/**< --statistics option		*/
+int incremental;			/**< --incremental option		*/
+int gzipped;				/**< --gzipped option		*/
 
 int no_order_list;			/**< 1: doesn't use order list	*/
 int other_files;			/**< 1: list other files		*/
@@ -287,6 +290,7 @@ static struct option const long_options[] = {
         {"disable-idutils", no_argument, &enable_idutils, 0},
         {"full-path", no_argument, &full_path, 1},
         {"fixed-guide",  no_argument, &fixed_guide, 1},
+        {"incremental", no_argument, &incremental, 1},
         {"map-file", no_argument, &map_file, 1},
         {"no-order-list", no_argument, &no_order_list, 1},
         {"show-position", no_argument, &show_position, 1},
@@ -313,6 +317,7 @@ static struct option const long_options[] = {
 #define OPT_HTML_HEADER		140
 #define OPT_CALL_TREE		141
 #define OPT_CALLEE_TREE		142
+#define OPT_GZIPPED		143
         {"auto-completion", optional_argument, NULL, OPT_AUTO_COMPLETION},
         {"call-tree", required_argument, NULL, OPT_CALL_TREE},
         {"callee-tree", required_argument, NULL, OPT_CALLEE_TREE},
@@ -321,6 +326,7 @@ static struct option const long_options[] = {
         {"cvsweb-cvsroot", required_argument, NULL, OPT_CVSWEB_CVSROOT},
         {"gtagsconf", required_argument, NULL, OPT_GTAGSCONF},
         {"gtagslabel", required_argument, NULL, OPT_GTAGSLABEL},
+        {"gzipped", optional_argument, NULL, OPT_GZIPPED},
         {"html-header", required_argument,NULL, OPT_HTML_HEADER},
         {"ncol", required_argument, NULL, OPT_NCOL},
         {"insert-footer", required_argument, NULL, OPT_INSERT_FOOTER},
@@ -739,12 +745,20 @@ makehtml(int total)
 #endif
 	gp = gfind_open(dbpath, NULL, other_files ? GPATH_BOTH : GPATH_SOURCE, 0);
 	while ((path = gfind_read(gp)) != NULL) {
+		/*
+		 * In incremental mode, only files to be regenerated are
+		 * given to anchor_load().
+		 */
+		if (incremental && !incremental_check_file(path))
+			continue;
 		if (gp->type == GPATH_OTHER)
 			fputc(' ', anchor_stream);
 		fputs(path, anchor_stream);
 		fputc('\n', anchor_stream);
 	}
 	gfind_close(gp);
+	if (incremental)
+		incremental_file_sweep();
 	/*
 	 * Prepare anchor stream for anchor_load().
 	 */
@@ -758,6 +772,10 @@ makehtml(int total)
 
 		if (gp->type == GPATH_OTHER && !other_files)
 			continue;
+		if (incremental && !incremental_is_dirty(path)) {
+			count++;
+			continue;
+		}
 		/*
 		 * load tags belonging to the path.
 		 * The path must be start "./".
@@ -770,8 +788,10 @@ makehtml(int total)
 		count++;
 		path += 2;		/* remove './' at the head */
 		message(" [%d/%d] converting %s", count, total, path);
-		snprintf(html, sizeof(html), "%s/%s/%s.%s", distpath, SRCS, path2fid(path), HTML);
+		snprintf(html, sizeof(html), "%s/%s/%s.%s%s", distpath, SRCS, path2fid(path), HTML, gzipped ? ".gz" : "");
 		src2html(path, html, gp->type == GPATH_OTHER);
+		if (incremental)
+			incremental_file_done(path);
 	}
 	gfind_close(gp);
 }
@@ -1142,6 +1162,14 @@ main(int argc, char **argv)
 		case OPT_GTAGSLABEL:
 			/* These options are already parsed in preparse_options() */
 			break;
+		case OPT_GZIPPED:
+			gzipped = 1;
+			if (optarg) {
+				if (optarg[0] < '0' || optarg[0] > '9' || optarg[1] != '\0')
+					die("The option value of --gzipped must be a number from 0 to 9.");
+				set_compress_level(optarg[0] - '0');
+			}
+			break;
 		case OPT_INSERT_FOOTER:
 			insert_footer = optarg;
 			break;
@@ -1520,6 +1548,8 @@ main(int argc, char **argv)
 		makehtaccess(".htaccess", 0644);
 	} else {
 		message("[%s] (1) making CGI program ...(skipped)", now());
+		if (gzipped)
+			makehtaccess(".htaccess", 0644);
 	}
 	if (av) {
 		const char *path = makepath(distpath, "GTAGSROOT", NULL);
@@ -1539,6 +1569,20 @@ main(int argc, char **argv)
 	 * (#) load GPATH
 	 */
 	load_gpath(dbpath);
+	/*
+	 * (#) load the state of the last run
+	 *
+	 * If not in incremental mode, the state is removed, because
+	 * it doesn't correspond to the hypertext any longer.
+	 */
+	if (incremental) {
+		/*
+		 * Pages whose contents are not changed are left untouched.
+		 */
+		set_update_only(1);
+		incremental_open();
+	} else
+		(void)unlink(makepath(distpath, STATEFILE, NULL));
 
 	/*
 	 * (3) make function entries (D/ and R/)
@@ -1668,6 +1712,13 @@ main(int argc, char **argv)
  		message("\n If you are using Apache, 'HTML/.htaccess' might be helpful for you.\n");
 		message(" Good luck!\n");
 	}
+	if (vflag && gzipped) {
+		message("\n[Information]\n");
+		message(" o Htags was invoked with the --gzipped option. Source pages are compressed");
+		message("   into S/*.html.gz. Your http server should send them for S/*.html with");
+		message("   'Content-Encoding: gzip'. See 'HTML/.htaccess' for Apache.");
+		message("   Htags-server(1) does it without any configuration.\n");
+	}
 	if (Iflag) {
 		char src[MAXPATHLEN];
 		char dist[MAXPATHLEN];
@@ -1676,6 +1727,8 @@ main(int argc, char **argv)
 		snprintf(dist, sizeof(dist), "%s/icons", distpath);
 		copydirectory(src, dist);
 	}
+	if (incremental)
+		incremental_close();
 	gpath_close();
 	/*
 	 * Print statistics information.
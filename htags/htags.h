@@ -95,6 +95,8 @@ extern int fixed_guide;
 extern int dynamic;
 extern int symbol;
 extern int statistics;
+extern int incremental;
+extern int gzipped;
 
 extern int no_order_list;
 extern int other_files;
@@ -0,0 +1,836 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "global.h"
+#include "cache.h"
+#include "htags.h"
+#include "incop.h"
+#include "incremental.h"
+#include "path2url.h"
+
+/*
+ * Incremental updating of the hypertext (--incremental).
+ *
+ * The state of the last run is kept in HTML/.htags_state, which is a B-tree
+ * file of the dbop layer. Keys are as follows.
+ *
+ *	key				data
+ *	-----------------------------------------------------------
+ *	F<fid>				<size> <mtime> <digest> <path>
+ *	T<db><tag>			<page number> <cache record>
+ *	P<db><tag>			digest of the tag list in D/, R/ or Y/
+ *	I<include file name>		<digest> <id> <fid> <fid> ...
+ *	D<directory name>		<id>
+ *	" __.CONTEXT"			digest of version, config and options
+ *	" __.PAGENO<db>"		last page number used in D/, R/ and Y/
+ *	" __.DIRNO"			last id used for directories
+ *	" __.COMPLETE"			exists if the last run completed
+ *
+ * A source page is regenerated if (1) the contents of the file changed,
+ * (2) the cache record of a tag which appears in the file changed, or
+ * (3) the include file index concerning the file changed.
+ * A tag list page in D/, R/ or Y/ is written only if its lines changed.
+ * Page numbers of D/, R/ and Y/ and ids of directories (files/) are kept
+ * across runs, so that links in unchanged pages stay valid.
+ *
+ * If the state is not found, or was left by an interrupted run, or was made
+ * with other options, everything is regenerated and the state is rebuilt.
+ */
+#define CONTEXTKEY	" __.CONTEXT"
+#define COMPLETEKEY	" __.COMPLETE"
+#define PAGENOKEY	" __.PAGENO"
+#define DIRNOKEY	" __.DIRNO"
+
+static const char *dirs[] = {NULL, DEFS, REFS, SYMS};
+
+static DBOP *state;
+static DBOP *tagdb[GTAGLIM];
+static POSTLIST *postlist;		/**< GRTAGS has posting lists */
+static IDSET *dirty;
+static IDSET *seen;
+static int full;
+static int lastno[GTAGLIM];
+static int lastdir;
+static STRHASH *dirs_seen;		/**< directories used in this run */
+
+/*
+ * Digest of contents.
+ *
+ * Two 32 bit hash values (FNV-1a and djb2) are used together.
+ * It is not a cryptographic digest; it is only used to detect updates.
+ */
+typedef struct {
+	unsigned long h1;
+	unsigned long h2;
+} DIGEST;
+
+static void
+digest_init(DIGEST *d)
+{
+	d->h1 = 2166136261UL;
+	d->h2 = 5381UL;
+}
+static void
+digest_update(DIGEST *d, const char *s, int len)
+{
+	const unsigned char *p = (const unsigned char *)s;
+	const unsigned char *end = p + len;
+
+	for (; p < end; p++) {
+		d->h1 = ((d->h1 ^ *p) * 16777619UL) & 0xffffffffUL;
+		d->h2 = ((d->h2 << 5) + d->h2 + *p) & 0xffffffffUL;
+	}
+}
+static void
+digest_puts(DIGEST *d, const char *s)
+{
+	digest_update(d, s, strlen(s) + 1);
+}
+static const char *
+digest_value(DIGEST *d)
+{
+	static char buf[32];
+
+	snprintf(buf, sizeof(buf), "%08lx%08lx", d->h1, d->h2);
+	return buf;
+}
+/**
+ * digest_file: compute the digest of a file.
+ *
+ *	@param[in]	path	path name
+ *	@return		digest string or NULL
+ */
+static const char *
+digest_file(const char *path)
+{
+	char buf[8192];
+	DIGEST d;
+	FILE *ip;
+	size_t n;
+
+	if ((ip = fopen(path, "rb")) == NULL)
+		return NULL;
+	digest_init(&d);
+	while ((n = fread(buf, 1, sizeof(buf), ip)) > 0)
+		digest_update(&d, buf, n);
+	fclose(ip);
+	return digest_value(&d);
+}
+/*
+ * Options which don't influence the hypertext.
+ */
+static const char *const ignored_options[] = {
+	"--incremental", "-v", "--verbose", "-q", "--quiet", "-w", "--warning",
+	"--debug", "--statistics", NULL
+};
+/**
+ * context_digest: digest of everything which influences all pages.
+ *
+ * Options listed in ignored_options[] are excluded.
+ */
+static const char *
+context_digest(void)
+{
+	STRBUF *sb = strbuf_open(0);
+	const char *env = getenv("HTAGS_OPTIONS");
+	const char *p, *q;
+	DIGEST d;
+	int i;
+
+	for (p = save_argv; *p; p = q) {
+		for (; *p == ' '; p++)
+			;
+		for (q = p; *q && *q != ' '; q++)
+			;
+		for (i = 0; ignored_options[i]; i++)
+			if ((int)strlen(ignored_options[i]) == q - p && !strncmp(p, ignored_options[i], q - p))
+				break;
+		if (ignored_options[i] == NULL) {
+			strbuf_putc(sb, ' ');
+			strbuf_nputs(sb, p, q - p);
+		}
+	}
+	digest_init(&d);
+	digest_puts(&d, get_version());
+	digest_puts(&d, save_config);
+	digest_puts(&d, strbuf_value(sb));
+	digest_puts(&d, env ? env : "");
+	digest_puts(&d, dbpath);
+	digest_puts(&d, cwdpath);
+	strbuf_close(sb);
+	return digest_value(&d);
+}
+/**
+ * add_dirty: mark the file as 'should be regenerated'.
+ */
+static void
+add_dirty(int fid)
+{
+	if (fid > 0 && (unsigned int)fid < dirty->size)
+		idset_add(dirty, fid);
+}
+/**
+ * mark_tag: mark all files which have an anchor of the tag.
+ *
+ *	@param[in]	tag	tag name
+ *
+ * Both GTAGS and the real GRTAGS (including virtual GSYMS) are looked up.
+ * A record of GRTAGS may be a block of a posting list which has some files.
+ */
+static void
+mark_tag(const char *tag)
+{
+	const char *tagline;
+	int db;
+
+	for (db = GTAGS; db <= GRTAGS; db++) {
+		if (tagdb[db] == NULL)
+			continue;
+		for (tagline = dbop_first(tagdb[db], tag, NULL, 0); tagline; tagline = dbop_next(tagdb[db])) {
+			if (db == GRTAGS && postlist) {
+				const char *p;
+
+				for (p = postlist_first(postlist, tagline, NULL); p; p = postlist_next(postlist, NULL))
+					add_dirty(atoi(p));
+			} else
+				add_dirty(atoi(tagline));
+		}
+	}
+}
+/**
+ * mark_list: mark files in a list of file ids.
+ *
+ *	@param[in]	list	"<fid> <fid> ..."
+ */
+static void
+mark_list(const char *list)
+{
+	const char *p = list;
+
+	while (*p) {
+		add_dirty(atoi(p));
+		while (*p && *p != ' ')
+			p++;
+		while (*p == ' ')
+			p++;
+	}
+}
+/**
+ * remove_page: remove an obsolete page.
+ *
+ * A path name which doesn't fit is not truncated, since the truncated
+ * name may be another file. Such a page cannot have been made.
+ */
+static void
+remove_page(const char *dir, int no)
+{
+	char path[MAXPATHLEN];
+
+	if (snprintf(path, sizeof(path), "%s/%s/%d.%s%s", distpath, dir, no, HTML,
+		(gzipped && !strcmp(dir, SRCS)) ? ".gz" : "") >= (int)sizeof(path))
+		return;
+	(void)unlink(path);
+}
+/**
+ * delete_page_digest: forget the digest of a tag list page.
+ */
+static void
+delete_page_digest(int db, const char *tag)
+{
+	STATIC_STRBUF(key);
+
+	strbuf_clear(key);
+	strbuf_putc(key, 'P');
+	strbuf_putn(key, db);
+	strbuf_puts(key, tag);
+	dbop_delete(state, strbuf_value(key));
+}
+/**
+ * incremental_open: load the state of the last run.
+ *
+ * This function should be called after GPATH is opened.
+ */
+void
+incremental_open(void)
+{
+	char path[MAXPATHLEN];
+	char context[32];
+	const char *p;
+	int db;
+
+	strlimcpy(path, makepath(distpath, STATEFILE, NULL), sizeof(path));
+	strlimcpy(context, context_digest(), sizeof(context));
+	full = 1;
+	if (test("f", path) && (state = dbop_open(path, 2, 0644, 0)) != NULL) {
+		if (dbop_get(state, COMPLETEKEY) != NULL
+		    && (p = dbop_getoption(state, CONTEXTKEY)) != NULL
+		    && !strcmp(p, context))
+			full = 0;
+		if (full) {
+			dbop_close(state);
+			state = NULL;
+		}
+	}
+	if (state == NULL) {
+		state = dbop_open(path, 1, 0644, 0);
+		if (state == NULL)
+			die("cannot make '%s'.", path);
+		dbop_putoption(state, CONTEXTKEY, context);
+	} else {
+		/*
+		 * If this run is interrupted, the next run will be a full one.
+		 */
+		dbop_delete(state, COMPLETEKEY);
+	}
+	for (db = GTAGS; db < GTAGLIM; db++) {
+		char key[32];
+
+		snprintf(key, sizeof(key), "%s%d", PAGENOKEY, db);
+		lastno[db] = (p = dbop_getoption(state, key)) ? atoi(p) : 0;
+		tagdb[db] = NULL;
+	}
+	lastdir = (p = dbop_getoption(state, DIRNOKEY)) ? atoi(p) : 0;
+	dirs_seen = strhash_open(256);
+	if (!full) {
+		for (db = GTAGS; db <= GRTAGS; db++) {
+			tagdb[db] = dbop_open(makepath(dbpath, dbname(db), NULL), 0, 0, 0);
+			if (tagdb[db] == NULL)
+				die("%s not found.", dbname(db));
+		}
+		if (dbop_getoption(tagdb[GRTAGS], POSTLISTKEY) != NULL)
+			postlist = postlist_open(NULL, 0);
+	}
+	dirty = idset_open(gpath_nextkey());
+	seen = idset_open(gpath_nextkey());
+	if (full)
+		message(" Incremental state not available. Making the whole hypertext.");
+}
+/**
+ * incremental_is_full: whether or not all pages are regenerated.
+ */
+int
+incremental_is_full(void)
+{
+	return full;
+}
+/**
+ * incremental_pageno: get the page number of a tag.
+ *
+ *	@param[in]	db	GTAGS, GRTAGS or GSYMS
+ *	@param[in]	tag	tag name
+ *	@return		page number in D/, R/ or Y/
+ *
+ * The number once assigned to a tag is kept while the tag exists.
+ */
+int
+incremental_pageno(int db, const char *tag)
+{
+	STATIC_STRBUF(key);
+	STATIC_STRBUF(sb);
+	const char *p;
+	int no;
+
+	strbuf_clear(key);
+	strbuf_putc(key, 'T');
+	strbuf_putn(key, db);
+	strbuf_puts(key, tag);
+	p = dbop_get(state, strbuf_value(key));
+	if (p != NULL && (no = atoi(p)) > 0)
+		return no;
+	no = ++lastno[db];
+	strbuf_clear(sb);
+	strbuf_putn(sb, no);
+	strbuf_putc(sb, ' ');
+	if (p != NULL && (p = strchr(p, ' ')) != NULL)
+		strbuf_puts(sb, p + 1);
+	dbop_put(state, strbuf_value(key), strbuf_value(sb));
+	return no;
+}
+/**
+ * incremental_tag: record the cache record of a tag.
+ *
+ *	@param[in]	db	GTAGS, GRTAGS or GSYMS
+ *	@param[in]	tag	tag name
+ *	@param[in]	record	cache record (See cache.c)
+ *	@param[in]	len	length of the record
+ *
+ * If the record changed, all files which have an anchor of the tag
+ * are marked to be regenerated.
+ */
+void
+incremental_tag(int db, const char *tag, const char *record, int len)
+{
+	STATIC_STRBUF(key);
+	STATIC_STRBUF(rec);
+	STATIC_STRBUF(sb);
+	const char *p;
+	int i, no = 0, was_dup = 0;
+
+	strbuf_clear(rec);
+	for (i = 0; i < len && (record[i] || i < len - 1); i++)
+		strbuf_putc(rec, record[i] ? record[i] : ' ');
+	strbuf_clear(key);
+	strbuf_putc(key, 'T');
+	strbuf_putn(key, db);
+	strbuf_puts(key, tag);
+	if ((p = dbop_get(state, strbuf_value(key))) != NULL) {
+		no = atoi(p);
+		if ((p = strchr(p, ' ')) != NULL) {
+			p++;
+			if (!strcmp(p, strbuf_value(rec)))
+				return;
+			was_dup = (*p == ' ');
+		}
+	}
+	if (!full)
+		mark_tag(tag);
+	/*
+	 * The tag which had a tag list became a single tag.
+	 */
+	if (was_dup && *strbuf_value(rec) != ' ' && no > 0 && !dynamic) {
+		remove_page(dirs[db], no);
+		delete_page_digest(db, tag);
+	}
+	strbuf_clear(sb);
+	strbuf_putn(sb, no);
+	strbuf_putc(sb, ' ');
+	strbuf_puts(sb, strbuf_value(rec));
+	dbop_put(state, strbuf_value(key), strbuf_value(sb));
+}
+/**
+ * incremental_page: check whether or not a tag list page should be written.
+ *
+ *	@param[in]	db	GTAGS, GRTAGS or GSYMS
+ *	@param[in]	tag	tag name
+ *	@param[in]	lines	contents of the tag list
+ *	@param[in]	len	length of the contents
+ *	@param[in]	path	path name of the page
+ *	@return		1: should be written, 0: unchanged
+ */
+int
+incremental_page(int db, const char *tag, const char *lines, int len, const char *path)
+{
+	STATIC_STRBUF(key);
+	const char *p, *digest;
+	DIGEST d;
+
+	digest_init(&d);
+	digest_update(&d, lines, len);
+	digest = digest_value(&d);
+	strbuf_clear(key);
+	strbuf_putc(key, 'P');
+	strbuf_putn(key, db);
+	strbuf_puts(key, tag);
+	if (!full && (p = dbop_get(state, strbuf_value(key))) != NULL
+	    && !strcmp(p, digest) && test("f", path))
+		return 0;
+	dbop_put(state, strbuf_value(key), digest);
+	return 1;
+}
+/**
+ * incremental_tag_sweep: remove tags which disappeared.
+ *
+ *	@param[in]	db	GTAGS, GRTAGS or GSYMS
+ *
+ * This function should be called after all tags of db are cached.
+ */
+void
+incremental_tag_sweep(int db)
+{
+	STRBUF *list = strbuf_open(0);
+	char prefix[8];
+	const char *key, *p, *end;
+	int no;
+
+	snprintf(prefix, sizeof(prefix), "T%d", db);
+	for (key = dbop_first(state, prefix, NULL, DBOP_KEY | DBOP_PREFIX); key; key = dbop_next(state)) {
+		if (cache_get(db, key + strlen(prefix)) == NULL) {
+			strbuf_puts0(list, key);
+			strbuf_putn(list, atoi(dbop_lastdat(state, NULL)));
+			strbuf_putc(list, '\0');
+		}
+	}
+	p = strbuf_value(list);
+	end = p + strbuf_getlen(list);
+	while (p < end) {
+		key = p;
+		p += strlen(p) + 1;
+		no = atoi(p);
+		p += strlen(p) + 1;
+		if (!full)
+			mark_tag(key + strlen(prefix));
+		if (no > 0 && !dynamic)
+			remove_page(dirs[db], no);
+		delete_page_digest(db, key + strlen(prefix));
+		dbop_delete(state, key);
+	}
+	strbuf_close(list);
+}
+/**
+ * incremental_include: record the include file index of a file name.
+ *
+ *	@param[in]	inc	inc structure
+ *
+ * This function should be called before the index pages are written,
+ * since the contents of inc are released at that time.
+ * If the index changed, both the include files and the files which
+ * include them are marked to be regenerated.
+ */
+void
+incremental_include(struct data *inc)
+{
+	STATIC_STRBUF(key);
+	STATIC_STRBUF(sb);
+	STRBUF *deps = strbuf_open(0);
+	const char *p, *fid;
+	char old_digest[32];
+	DIGEST d;
+	int i;
+
+	digest_init(&d);
+	digest_puts(&d, inc->name);
+	strbuf_clear(sb);
+	strbuf_putn(sb, inc->id);
+	strbuf_putc(sb, ' ');
+	strbuf_putn(sb, inc->count);
+	strbuf_putc(sb, ' ');
+	strbuf_putn(sb, inc->ref_count);
+	digest_puts(&d, strbuf_value(sb));
+	if (inc->contents) {
+		digest_update(&d, strbuf_value(inc->contents), strbuf_getlen(inc->contents));
+		for (p = strbuf_value(inc->contents), i = 0; i < inc->count; p += strlen(p) + 1, i++) {
+			if ((fid = path2fid_readonly(p)) != NULL) {
+				strbuf_putc(deps, ' ');
+				strbuf_puts(deps, fid);
+			}
+		}
+	}
+	if (inc->ref_contents) {
+		digest_update(&d, strbuf_value(inc->ref_contents), strbuf_getlen(inc->ref_contents));
+		for (p = strbuf_value(inc->ref_contents), i = 0; i < inc->ref_count; p += strlen(p) + 1, i++) {
+			SPLIT ptable;
+
+			if (split(p, 4, &ptable) >= 4
+			    && (fid = path2fid_readonly(decode_path(ptable.part[PART_PATH].start))) != NULL) {
+				strbuf_putc(deps, ' ');
+				strbuf_puts(deps, fid);
+			}
+			recover(&ptable);
+		}
+	}
+	strbuf_clear(key);
+	strbuf_putc(key, 'I');
+	strbuf_puts(key, inc->name);
+	old_digest[0] = '\0';
+	if ((p = dbop_get(state, strbuf_value(key))) != NULL) {
+		strlimcpy(old_digest, strmake(p, " "), sizeof(old_digest));
+		if (!strcmp(old_digest, digest_value(&d))) {
+			strbuf_close(deps);
+			return;
+		}
+		/* skip digest and id */
+		if ((p = strchr(p, ' ')) != NULL && (p = strchr(p + 1, ' ')) != NULL && !full)
+			mark_list(p + 1);
+	}
+	if (!full)
+		mark_list(strbuf_value(deps));
+	if (inc->count <= 1)
+		remove_page(INCS, inc->id);
+	if (inc->ref_count <= 1)
+		remove_page(INCREFS, inc->id);
+	strbuf_clear(sb);
+	strbuf_puts(sb, digest_value(&d));
+	strbuf_putc(sb, ' ');
+	strbuf_putn(sb, inc->id);
+	strbuf_puts(sb, strbuf_value(deps));
+	dbop_put(state, strbuf_value(key), strbuf_value(sb));
+	strbuf_close(deps);
+}
+/**
+ * incremental_include_sweep: remove include file names which disappeared.
+ */
+void
+incremental_include_sweep(void)
+{
+	STRBUF *list = strbuf_open(0);
+	const char *key, *p, *end;
+
+	for (key = dbop_first(state, "I", NULL, DBOP_KEY | DBOP_PREFIX); key; key = dbop_next(state)) {
+		if (get_inc(key + 1) == NULL) {
+			strbuf_puts0(list, key);
+			strbuf_puts0(list, dbop_lastdat(state, NULL));
+		}
+	}
+	p = strbuf_value(list);
+	end = p + strbuf_getlen(list);
+	while (p < end) {
+		const char *dat;
+		int id = 0;
+
+		key = p;
+		p += strlen(p) + 1;
+		dat = p;
+		p += strlen(p) + 1;
+		/* skip digest */
+		if ((dat = strchr(dat, ' ')) != NULL) {
+			id = atoi(++dat);
+			if (!full && (dat = strchr(dat, ' ')) != NULL)
+				mark_list(dat + 1);
+		}
+		if (id > 0) {
+			remove_page(INCS, id);
+			remove_page(INCREFS, id);
+		}
+		dbop_delete(state, key);
+	}
+	strbuf_close(list);
+}
+/**
+ * incremental_check_file: check whether or not the file was updated.
+ *
+ *	@param[in]	path	path name
+ *	@return		1: should be regenerated, 0: unchanged
+ *
+ * Size and modification time are compared at first; the contents
+ * are compared only when either of them differs.
+ */
+int
+incremental_check_file(const char *path)
+{
+	STATIC_STRBUF(key);
+	STATIC_STRBUF(sb);
+	const char *p, *digest;
+	char old_digest[32], number[64];
+	struct stat st;
+	long size, mtime;
+	int fid = atoi(path2fid(path));
+
+	if (*path == '.' && *(path + 1) == '/')
+		path += 2;
+	if (fid > 0 && (unsigned int)fid < seen->size)
+		idset_add(seen, fid);
+	if (full || idset_contains(dirty, fid))
+		goto changed;
+	if (stat(path, &st) < 0)
+		goto changed;
+	strbuf_clear(key);
+	strbuf_putc(key, 'F');
+	strbuf_putn(key, fid);
+	if ((p = dbop_get(state, strbuf_value(key))) == NULL)
+		goto changed;
+	/*
+	 * <size> <mtime> <digest> <path>
+	 */
+	size = atol(p);
+	if ((p = strchr(p, ' ')) == NULL)
+		goto changed;
+	mtime = atol(++p);
+	if ((p = strchr(p, ' ')) == NULL)
+		goto changed;
+	strlimcpy(old_digest, strmake(++p, " "), sizeof(old_digest));
+	if ((p = strchr(p, ' ')) == NULL || strcmp(p + 1, path))
+		goto changed;
+	if (size == (long)st.st_size && mtime == (long)st.st_mtime)
+		return 0;
+	if ((digest = digest_file(path)) == NULL || strcmp(digest, old_digest))
+		goto changed;
+	/*
+	 * Only the time stamp was changed.
+	 */
+	strbuf_clear(sb);
+	snprintf(number, sizeof(number), "%ld %ld ", (long)st.st_size, (long)st.st_mtime);
+	strbuf_puts(sb, number);
+	strbuf_puts(sb, digest);
+	strbuf_putc(sb, ' ');
+	strbuf_puts(sb, path);
+	dbop_put(state, strbuf_value(key), strbuf_value(sb));
+	return 0;
+changed:
+	add_dirty(fid);
+	return 1;
+}
+/**
+ * incremental_is_dirty: whether or not the file should be regenerated.
+ *
+ *	@param[in]	path	path name
+ */
+int
+incremental_is_dirty(const char *path)
+{
+	return idset_contains(dirty, atoi(path2fid(path)));
+}
+/**
+ * incremental_file_done: record the state of the converted file.
+ *
+ *	@param[in]	path	path name
+ */
+void
+incremental_file_done(const char *path)
+{
+	STATIC_STRBUF(key);
+	STATIC_STRBUF(sb);
+	const char *digest;
+	char number[64];
+	struct stat st;
+
+	if (*path == '.' && *(path + 1) == '/')
+		path += 2;
+	if (stat(path, &st) < 0 || (digest = digest_file(path)) == NULL)
+		return;
+	strbuf_clear(key);
+	strbuf_putc(key, 'F');
+	strbuf_puts(key, path2fid(path));
+	strbuf_clear(sb);
+	snprintf(number, sizeof(number), "%ld %ld ", (long)st.st_size, (long)st.st_mtime);
+	strbuf_puts(sb, number);
+	strbuf_puts(sb, digest);
+	strbuf_putc(sb, ' ');
+	strbuf_puts(sb, path);
+	dbop_put(state, strbuf_value(key), strbuf_value(sb));
+}
+/**
+ * incremental_file_sweep: remove pages of files which disappeared.
+ *
+ * This function should be called after incremental_check_file() is
+ * called for all files.
+ */
+void
+incremental_file_sweep(void)
+{
+	STRBUF *list = strbuf_open(0);
+	const char *key, *p, *end;
+
+	for (key = dbop_first(state, "F", NULL, DBOP_KEY | DBOP_PREFIX); key; key = dbop_next(state))
+		if (!idset_contains(seen, atoi(key + 1)))
+			strbuf_puts0(list, key);
+	p = strbuf_value(list);
+	end = p + strbuf_getlen(list);
+	for (; p < end; p += strlen(p) + 1) {
+		remove_page(SRCS, atoi(p + 1));
+		dbop_delete(state, p);
+	}
+	strbuf_close(list);
+}
+/**
+ * incremental_dirid: get the id of a directory.
+ *
+ *	@param[in]	path	directory name
+ *	@param[in]	base	the largest file id in GPATH
+ *	@return		id, which is used as files/<id>.html
+ *
+ * The id once assigned to a directory is kept while the directory exists.
+ * A new id is larger than any id used before.
+ */
+const char *
+incremental_dirid(const char *path, int base)
+{
+	STATIC_STRBUF(key);
+	static char number[32];
+	const char *p;
+
+	strbuf_clear(key);
+	strbuf_putc(key, 'D');
+	strbuf_puts(key, path);
+	strhash_assign(dirs_seen, path, 1);
+	if ((p = dbop_get(state, strbuf_value(key))) != NULL && atoi(p) > 0)
+		return p;
+	if (lastdir < base)
+		lastdir = base;
+	snprintf(number, sizeof(number), "%d", ++lastdir);
+	dbop_put(state, strbuf_value(key), number);
+	return number;
+}
+/**
+ * incremental_dir_sweep: remove pages of directories which disappeared.
+ */
+static void
+incremental_dir_sweep(void)
+{
+	STRBUF *list = strbuf_open(0);
+	const char *key, *p, *end;
+
+	for (key = dbop_first(state, "D", NULL, DBOP_KEY | DBOP_PREFIX); key; key = dbop_next(state)) {
+		if (strhash_assign(dirs_seen, key + 1, 0) == NULL) {
+			strbuf_puts0(list, key);
+			strbuf_puts0(list, dbop_lastdat(state, NULL));
+		}
+	}
+	p = strbuf_value(list);
+	end = p + strbuf_getlen(list);
+	while (p < end) {
+		key = p;
+		p += strlen(p) + 1;
+		remove_page("files", atoi(p));
+		p += strlen(p) + 1;
+		dbop_delete(state, key);
+	}
+	strbuf_close(list);
+}
+/**
+ * incremental_close: save the state.
+ *
+ * This function should be called after all pages are made.
+ */
+void
+incremental_close(void)
+{
+	char number[32];
+	int db;
+
+	for (db = GTAGS; db < GTAGLIM; db++) {
+		char key[32];
+
+		snprintf(key, sizeof(key), "%s%d", PAGENOKEY, db);
+		snprintf(number, sizeof(number), "%d", lastno[db]);
+		dbop_putoption(state, key, number);
+		if (tagdb[db])
+			dbop_close(tagdb[db]);
+		tagdb[db] = NULL;
+	}
+	if (postlist) {
+		postlist_close(postlist);
+		postlist = NULL;
+	}
+	incremental_dir_sweep();
+	strhash_close(dirs_seen);
+	snprintf(number, sizeof(number), "%d", lastdir);
+	dbop_putoption(state, DIRNOKEY, number);
+	dbop_putoption(state, COMPLETEKEY, NULL);
+	dbop_close(state);
+	state = NULL;
+	idset_close(dirty);
+	idset_close(seen);
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _INCREMENTAL_H_
+#define _INCREMENTAL_H_
+
+#include "incop.h"
+
+#define STATEFILE	".htags_state"
+
+void incremental_open(void);
+int incremental_is_full(void);
+int incremental_pageno(int, const char *);
+void incremental_tag(int, const char *, const char *, int);
+int incremental_page(int, const char *, const char *, int, const char *);
+void incremental_tag_sweep(int);
+void incremental_include(struct data *);
+void incremental_include_sweep(void);
+int incremental_check_file(const char *);
+int incremental_is_dirty(const char *);
+void incremental_file_done(const char *);
+void incremental_file_sweep(void);
+const char *incremental_dirid(const char *, int);
+void incremental_close(void);
+
+#endif /* ! _INCREMENTAL_H_ */
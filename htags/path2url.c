@@ -31,6 +31,7 @@
 #include "global.h"
 #include "assoc.h"
 #include "htags.h"
+#include "incremental.h"
 #include "path2url.h"
 
 static ASSOC *assoc;
@@ -95,7 +96,14 @@ path2fid(const char *path)
 		path += 2;
 	p = assoc_get(assoc, path);
 	if (!p) {
-		snprintf(number, sizeof(number), "%d", ++nextkey);
+		/*
+		 * A directory doesn't have a file id in GPATH.
+		 * In incremental mode, the id is kept across runs.
+		 */
+		if (incremental)
+			strlimcpy(number, incremental_dirid(path, nextkey), sizeof(number));
+		else
+			snprintf(number, sizeof(number), "%d", ++nextkey);
 		assoc_put(assoc, path, number);
 		p = number;
 	}
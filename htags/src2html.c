@@ -806,7 +806,7 @@ src2html(const char *src, const char *html, int notsource)
         curpfile = src;
         warned = 0;
 
-	fileop_out = open_output_file(html, 0);
+	fileop_out = open_output_file(html, gzipped);
 	out = get_descripter(fileop_out);
 	strbuf_clear(outbuf);
 
@@ -185,8 +185,11 @@ __bt_dpage(h)
 		return;
 
 	top = NEXTINDEX(h);
-	(void)fprintf(stderr, " lower %3d upper %3d nextind %d\n",
+	(void)fprintf(stderr, " lower %3d upper %3d nextind %d",
 	    h->lower, h->upper, top);
+	if (PFXLEN(h))
+		(void)fprintf(stderr, " prefix %d", PFXLEN(h));
+	(void)fprintf(stderr, "\n");
 	for (cur = 0; cur < top; cur++) {
 		(void)fprintf(stderr, "\t[%03d] %4d ", cur, h->linp[cur]);
 		switch (h->flags & P_TYPE) {
@@ -213,7 +216,9 @@ __bt_dpage(h)
 				    (long unsigned int)*(pgno_t *)bl->bytes,
 				    (unsigned int)*(u_int32_t *)(bl->bytes + sizeof(pgno_t)));
 			else if (bl->ksize)
-				(void)fprintf(stderr, "%s/", bl->bytes);
+				(void)fprintf(stderr, "%s%.*s/",
+				    bl->flags & P_PFXKEY ? "..." : "",
+				    (int)bl->ksize, bl->bytes);
 			if (bl->flags & P_BIGDATA)
 				(void)fprintf(stderr,
 				    "big data page %lu size %u",
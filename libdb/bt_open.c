@@ -126,8 +126,8 @@ __bt_open(fname, flags, mode, openinfo, dflags)
 	if (openinfo) {
 		b = *openinfo;
 
-		/* Flags: R_DUP. */
-		if (b.flags & ~(R_DUP))
+		/* Flags: R_DUP, R_PFXKEY. */
+		if (b.flags & ~(R_DUP | R_PFXKEY))
 			goto einval;
 
 		/*
@@ -147,7 +147,12 @@ __bt_open(fname, flags, mode, openinfo, dflags)
 		} else
 			b.minkeypage = DEFMINKEYPAGE;
 
-		/* If no comparison, use default comparison and prefix. */
+		/*
+		 * If no comparison, use default comparison and prefix.
+		 * Prefix compressed keys need the default comparison.
+		 */
+		if (b.flags & R_PFXKEY && b.compare != NULL)
+			goto einval;
 		if (b.compare == NULL) {
 			b.compare = __bt_defcmp;
 			if (b.prefix == NULL)
@@ -263,6 +268,8 @@ __bt_open(fname, flags, mode, openinfo, dflags)
 			goto eftype;
 		if (m.flags & ~SAVEMETA)
 			goto eftype;
+		if (m.flags & B_PFXKEY && t->bt_cmp != __bt_defcmp)
+			goto einval;
 		b.psize = m.psize;
 		F_SET(t, m.flags);
 		t->bt_free = m.free;
@@ -288,6 +295,10 @@ __bt_open(fname, flags, mode, openinfo, dflags)
 		if (!(b.flags & R_DUP))
 			F_SET(t, B_NODUPS);
 
+		/* Set flag if keys are prefix compressed. */
+		if (b.flags & R_PFXKEY)
+			F_SET(t, B_PFXKEY);
+
 		t->bt_free = P_INVALID;
 		t->bt_nrecs = 0;
 		F_SET(t, B_METADIRTY);
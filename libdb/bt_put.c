@@ -53,7 +53,7 @@ static char sccsid[] = "@(#)bt_put.c	8.8 (Berkeley) 7/26/94";
 #include "db.h"
 #include "btree.h"
 
-static EPG *bt_fast(BTREE *, const DBT *, const DBT *, int *);
+static EPG *bt_fast(BTREE *, const DBT *, const DBT *, const DBT *, int *);
 
 /**
  * __BT_PUT -- Add a btree item to the tree.
@@ -75,13 +75,13 @@ __bt_put(dbp, key, data, flags)
 	u_int flags;
 {
 	BTREE *t;
-	DBT tkey, tdata;
+	DBT skey, tkey, tdata, *ukey;
 	EPG *e = NULL;
 	PAGE *h;
 	indx_t index, nxtindex;
 	pgno_t pg;
 	u_int32_t nbytes;
-	int dflags, exact, status;
+	int dflags, exact, sflags, status;
 	char *dest, db[NOVFLSIZE], kb[NOVFLSIZE];
 
 	t = dbp->internal;
@@ -124,7 +124,11 @@ __bt_put(dbp, key, data, flags)
 	 *
 	 * XXX
 	 * If the insert fails later on, the overflow pages aren't recovered.
+	 *
+	 * The user's key is kept for searching, because the key stored on the
+	 * page is then only a reference to the overflow pages.
 	 */
+	ukey = key;
 	dflags = 0;
 	if (key->size + data->size > t->bt_ovflsize) {
 		if (key->size > t->bt_ovflsize) {
@@ -165,8 +169,9 @@ storekey:		if (__ovfl_put(t, key, &pg) == RET_ERROR)
 	 * Find the key to delete, or, the location at which to insert.
 	 * Bt_fast and __bt_search both pin the returned page.
 	 */
-	if (t->bt_order == NOT || (e = bt_fast(t, key, data, &exact)) == NULL)
-		if ((e = __bt_search(t, key, &exact)) == NULL)
+	if (t->bt_order == NOT ||
+	    (e = bt_fast(t, ukey, key, data, &exact)) == NULL)
+		if ((e = __bt_search(t, ukey, &exact)) == NULL)
 			return (RET_ERROR);
 	h = e->page;
 	index = e->index;
@@ -191,20 +196,37 @@ storekey:		if (__ovfl_put(t, key, &pg) == RET_ERROR)
 		 * Note, the delete may empty the page, so we need to put a
 		 * new entry into the page immediately.
 		 */
-delete:		if (__bt_dleaf(t, key, h, index) == RET_ERROR) {
+delete:		if (__bt_dleaf(t, ukey, h, index) == RET_ERROR) {
 			mpool_put(t->bt_mp, h, 0);
 			return (RET_ERROR);
 		}
 		break;
 	}
 
+	/*
+	 * If the page has a key prefix, store only the rest of the key.  When
+	 * the page is full, recalculating the prefix may make enough room.
+	 */
+	sflags = __bt_pfxkey(t, h, key, dflags, &skey);
+	nbytes = NBLEAFDBT(skey.size, data->size);
+	if (h->upper - h->lower < nbytes + sizeof(indx_t) &&
+	    F_ISSET(t, B_PFXKEY)) {
+		if ((status = __bt_pfxcompact(t, h, key, dflags)) == RET_ERROR) {
+			mpool_put(t->bt_mp, h, 0);
+			return (RET_ERROR);
+		}
+		if (status == RET_SUCCESS) {
+			sflags = __bt_pfxkey(t, h, key, dflags, &skey);
+			nbytes = NBLEAFDBT(skey.size, data->size);
+		}
+	}
+
 	/*
 	 * If not enough room, or the user has put a ceiling on the number of
 	 * keys permitted in the page, split the page.  The split code will
 	 * insert the key and data and unpin the current page.  If inserting
 	 * into the offset array, shift the pointers up.
 	 */
-	nbytes = NBLEAFDBT(key->size, data->size);
 	if (h->upper - h->lower < nbytes + sizeof(indx_t)) {
 		if ((status = __bt_split(t, h, key,
 		    data, dflags, nbytes, index)) != RET_SUCCESS)
@@ -219,7 +241,7 @@ delete:		if (__bt_dleaf(t, key, h, index) == RET_ERROR) {
 
 	h->linp[index] = h->upper -= nbytes;
 	dest = (char *)h + h->upper;
-	WR_BLEAF(dest, key, data, dflags);
+	WR_BLEAF(dest, (&skey), data, sflags);
 
 	/* If the cursor is on this page, adjust it as necessary. */
 	if (F_ISSET(&t->bt_cursor, CURS_INIT) &&
@@ -259,15 +281,16 @@ u_long bt_cache_hit, bt_cache_miss;
  *
  *	@param t	tree
  *	@param key	key to insert
+ *	@param skey	key to be stored on the page
  *	@param data
  *	@param exactp
  *
  * @return EPG for new record or NULL if not found.
  */
 static EPG *
-bt_fast(t, key, data, exactp)
+bt_fast(t, key, skey, data, exactp)
 	BTREE *t;
-	const DBT *key, *data;
+	const DBT *key, *skey, *data;
 	int *exactp;
 {
 	PAGE *h;
@@ -285,7 +308,7 @@ bt_fast(t, key, data, exactp)
 	 * If won't fit in this page or have too many keys in this page,
 	 * have to search to get split stack.
 	 */
-	nbytes = NBLEAFDBT(key->size, data->size);
+	nbytes = NBLEAFDBT(skey->size, data->size);
 	if (h->upper - h->lower < nbytes + sizeof(indx_t))
 		goto miss;
 
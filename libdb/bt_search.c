@@ -128,7 +128,8 @@ __bt_search(t, key, exactp)
 
 next:		BT_PUSH(t, h->pgno, index);
 		pg = GETBINTERNAL(h, index)->pgno;
-		mpool_put(t->bt_mp, h, 0);
+		/* Internal pages are shared by every search. */
+		mpool_put(t->bt_mp, h, MPOOL_HOT);
 	}
 }
 
@@ -189,7 +189,7 @@ __bt_seqset(t, ep, key, flags)
 			if (h->flags & (P_BLEAF | P_RLEAF))
 				break;
 			pg = GETBINTERNAL(h, 0)->pgno;
-			mpool_put(t->bt_mp, h, 0);
+			mpool_put(t->bt_mp, h, MPOOL_HOT);
 		}
 		ep->page = h;
 		ep->index = 0;
@@ -210,7 +210,7 @@ __bt_seqset(t, ep, key, flags)
 			if (h->flags & (P_BLEAF | P_RLEAF))
 				break;
 			pg = GETBINTERNAL(h, NEXTINDEX(h) - 1)->pgno;
-			mpool_put(t->bt_mp, h, 0);
+			mpool_put(t->bt_mp, h, MPOOL_HOT);
 		}
 
 		ep->page = h;
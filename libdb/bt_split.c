@@ -89,7 +89,8 @@ __bt_split(t, sp, key, data, flags, ilen, argskip)
 {
 	BINTERNAL *bi = NULL;
 	BLEAF *bl = NULL, *tbl;
-	DBT a, b;
+	DBT a, b, skey;
+	EPG e;
 	EPGNO *parent;
 	PAGE *h, *l, *r, *lchild, *rchild;
 	indx_t nxtindex;
@@ -113,14 +114,19 @@ __bt_split(t, sp, key, data, flags, ilen, argskip)
 
 	/*
 	 * Insert the new key/data pair into the leaf page.  (Key inserts
-	 * always cause a leaf page to split first.)
+	 * always cause a leaf page to split first.)  A new page made by
+	 * appending has no key prefix, so the key may need more room there.
 	 */
-	h->linp[skip] = h->upper -= ilen;
-	dest = (char *)h + h->upper;
-	if (F_ISSET(t, R_RECNO))
+	if (F_ISSET(t, R_RECNO)) {
+		h->linp[skip] = h->upper -= ilen;
+		dest = (char *)h + h->upper;
 		WR_RLEAF(dest, data, flags)
-	else
-		WR_BLEAF(dest, key, data, flags)
+	} else {
+		flags = __bt_pfxkey(t, h, key, flags, &skey);
+		h->linp[skip] = h->upper -= NBLEAFDBT(skey.size, data->size);
+		dest = (char *)h + h->upper;
+		WR_BLEAF(dest, (&skey), data, flags)
+	}
 
 	/* If the root page was split, make it look right. */
 	if (sp->pgno == P_ROOT &&
@@ -186,14 +192,29 @@ __bt_split(t, sp, key, data, flags, ilen, argskip)
 			break;
 		case P_BLEAF:
 			bl = GETBLEAF(rchild, 0);
-			nbytes = NBINTERNAL(bl->ksize);
+			b.size = bl->ksize;
+			b.data = bl->bytes;
+			if (bl->flags & P_PFXKEY) {
+				e.page = rchild;
+				e.index = 0;
+				if (__bt_ret(t, &e,
+				    &b, &t->bt_rdata, NULL, NULL, 0))
+					goto err1;
+			}
+			nbytes = NBINTERNAL(b.size);
+			tbl = GETBLEAF(lchild, NEXTINDEX(lchild) - 1);
 			if (t->bt_pfx && !(bl->flags & P_BIGKEY) &&
+			    !(tbl->flags & P_BIGKEY) &&
 			    (h->prevpg != P_INVALID || skip > 1)) {
-				tbl = GETBLEAF(lchild, NEXTINDEX(lchild) - 1);
 				a.size = tbl->ksize;
 				a.data = tbl->bytes;
-				b.size = bl->ksize;
-				b.data = bl->bytes;
+				if (tbl->flags & P_PFXKEY) {
+					e.page = lchild;
+					e.index = NEXTINDEX(lchild) - 1;
+					if (__bt_ret(t, &e,
+					    &a, &t->bt_rkey, NULL, NULL, 0))
+						goto err1;
+				}
 				nksize = t->bt_pfx(&a, &b);
 				n = NBINTERNAL(nksize);
 				if (n < nbytes) {
@@ -242,9 +263,9 @@ __bt_split(t, sp, key, data, flags, ilen, argskip)
 		case P_BLEAF:
 			h->linp[skip] = h->upper -= nbytes;
 			dest = (char *)h + h->linp[skip];
-			WR_BINTERNAL(dest, nksize ? nksize : bl->ksize,
+			WR_BINTERNAL(dest, nksize ? nksize : b.size,
 			    rchild->pgno, bl->flags & P_BIGKEY);
-			memmove(dest, bl->bytes, nksize ? nksize : bl->ksize);
+			memmove(dest, b.data, nksize ? nksize : b.size);
 			if (bl->flags & P_BIGKEY &&
 			    bt_preserve(t, *(pgno_t *)bl->bytes) == RET_ERROR)
 				goto err1;
@@ -535,6 +556,8 @@ bt_broot(t, h, l, r)
 {
 	BINTERNAL *bi;
 	BLEAF *bl;
+	DBT key;
+	EPG e;
 	u_int32_t nbytes;
 	char *dest;
 
@@ -554,11 +577,19 @@ bt_broot(t, h, l, r)
 	switch (h->flags & P_TYPE) {
 	case P_BLEAF:
 		bl = GETBLEAF(r, 0);
-		nbytes = NBINTERNAL(bl->ksize);
+		key.size = bl->ksize;
+		key.data = bl->bytes;
+		if (bl->flags & P_PFXKEY) {
+			e.page = r;
+			e.index = 0;
+			if (__bt_ret(t, &e, &key, &t->bt_rdata, NULL, NULL, 0))
+				return (RET_ERROR);
+		}
+		nbytes = NBINTERNAL(key.size);
 		h->linp[1] = h->upper -= nbytes;
 		dest = (char *)h + h->upper;
-		WR_BINTERNAL(dest, bl->ksize, r->pgno, 0);
-		memmove(dest, bl->bytes, bl->ksize);
+		WR_BINTERNAL(dest, key.size, r->pgno, 0);
+		memmove(dest, key.data, key.size);
 
 		/*
 		 * If the key is on an overflow page, mark the overflow chain
@@ -584,7 +615,7 @@ bt_broot(t, h, l, r)
 	h->lower = BTDATAOFF + 2 * sizeof(indx_t);
 
 	/* Unpin the root page, set to btree internal page. */
-	h->flags &= ~P_TYPE;
+	h->flags &= ~(P_TYPE | P_PFXMASK);
 	h->flags |= P_BINTERNAL;
 	mpool_put(t->bt_mp, h, MPOOL_DIRTY);
 
@@ -618,9 +649,22 @@ bt_psplit(t, h, l, r, pskip, ilen)
 	PAGE *rval;
 	void *src = NULL;
 	indx_t full, half, nxt, off, skip, top, used;
-	u_int32_t nbytes;
+	u_int32_t n, nbytes;
 	int bigkeycnt, isbigkey;
 
+	/*
+	 * The records are copied as they are, so both pages take over the key
+	 * prefix of the split page.
+	 */
+	if ((n = PFXLEN(h)) != 0) {
+		l->flags |= n << P_PFXSHIFT;
+		r->flags |= n << P_PFXSHIFT;
+		l->upper -= LALIGN(n);
+		r->upper -= LALIGN(n);
+		memmove(PFXKEY(t, l), PFXKEY(t, h), n);
+		memmove(PFXKEY(t, r), PFXKEY(t, h), n);
+	}
+
 	/*
 	 * Split the data to the left and right pages.  Leave the skip index
 	 * open.  Additionally, make some effort not to split on an overflow
@@ -629,7 +673,7 @@ bt_psplit(t, h, l, r, pskip, ilen)
 	 */
 	bigkeycnt = 0;
 	skip = *pskip;
-	full = t->bt_psize - BTDATAOFF;
+	full = t->bt_psize - BTDATAOFF - LALIGN(n);
 	half = full / 2;
 	used = 0;
 	for (nxt = off = 0, top = NEXTINDEX(h); nxt < top; ++off) {
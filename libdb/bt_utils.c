@@ -74,6 +74,7 @@ __bt_ret(t, e, key, rkey, data, rdata, copy)
 {
 	BLEAF *bl;
 	void *p;
+	u_int32_t n;
 
 	bl = GETBLEAF(e->page, e->index);
 
@@ -90,6 +91,22 @@ __bt_ret(t, e, key, rkey, data, rdata, copy)
 		    &key->size, &rkey->data, &rkey->size))
 			return (RET_ERROR);
 		key->data = rkey->data;
+	} else if (bl->flags & P_PFXKEY) {
+		/* The key must be put together with the prefix of the page. */
+		n = PFXLEN(e->page);
+		if (n + bl->ksize > rkey->size) {
+			p = (void *)(rkey->data == NULL ?
+			    malloc(n + bl->ksize) :
+			    realloc(rkey->data, n + bl->ksize));
+			if (p == NULL)
+				return (RET_ERROR);
+			rkey->data = p;
+			rkey->size = n + bl->ksize;
+		}
+		memmove(rkey->data, PFXKEY(t, e->page), n);
+		memmove((char *)rkey->data + n, bl->bytes, bl->ksize);
+		key->size = n + bl->ksize;
+		key->data = rkey->data;
 	} else if (copy || F_ISSET(t, B_DB_LOCK)) {
 		if (bl->ksize > rkey->size) {
 			p = (void *)(rkey->data == NULL ?
@@ -138,6 +155,44 @@ dataonly:
 	return (RET_SUCCESS);
 }
 
+/**
+ * BT_PFXCMP -- Compare a key to a record without the prefix of the page.
+ *
+ *	@param t	tree
+ *	@param k1	DBT pointer of first arg to comparison
+ *	@param h	leaf page
+ *	@param bl	P_PFXKEY record on the page
+ *
+ * @return
+ *	< 0 if k1 is < record
+ *	= 0 if k1 is = record
+ *	> 0 if k1 is > record
+ *
+ * B_PFXKEY trees always use __bt_defcmp, which compares bytes in order.
+ */
+static int
+bt_pfxcmp(t, k1, h, bl)
+	BTREE *t;
+	const DBT *k1;
+	PAGE *h;
+	BLEAF *bl;
+{
+	DBT rest, k2;
+	u_int32_t n;
+	int diff;
+
+	n = PFXLEN(h);
+	if ((diff = memcmp(k1->data, PFXKEY(t, h), MIN(k1->size, n))) != 0)
+		return (diff);
+	if (k1->size < n)
+		return (-1);
+	rest.data = (char *)k1->data + n;
+	rest.size = k1->size - n;
+	k2.data = bl->bytes;
+	k2.size = bl->ksize;
+	return ((*t->bt_cmp)(&rest, &k2));
+}
+
 /*
  * __BT_CMP -- Compare a key to a given record.
  *
@@ -178,6 +233,8 @@ __bt_cmp(t, k1, e)
 		bl = GETBLEAF(h, e->index);
 		if (bl->flags & P_BIGKEY)
 			bigkey = bl->bytes;
+		else if (bl->flags & P_PFXKEY)
+			return (bt_pfxcmp(t, k1, h, bl));
 		else {
 			k2.data = bl->bytes;
 			k2.size = bl->ksize;
@@ -257,3 +314,215 @@ __bt_defpfx(a, b)
 	/* a->size must be <= b->size, or they wouldn't be in this order. */
 	return (a->size < b->size ? a->size + 1 : a->size);
 }
+
+/**
+ * __BT_PFXKEY -- Strip the prefix of a leaf page from a key.
+ *
+ *	@param t	tree
+ *	@param h	leaf page into which the key is put
+ *	@param key	key
+ *	@param flags	flags of the record (P_BIGKEY, P_BIGDATA)
+ *	@param skey	key to be stored on the page
+ *
+ * @return
+ *	flags of the record to be stored, with P_PFXKEY if the key was stripped.
+ */
+int
+__bt_pfxkey(t, h, key, flags, skey)
+	BTREE *t;
+	PAGE *h;
+	const DBT *key;
+	int flags;
+	DBT *skey;
+{
+	u_int32_t n;
+
+	*skey = *key;
+	n = PFXLEN(h);
+	if (n == 0 || flags & P_BIGKEY || key->size < n ||
+	    memcmp(key->data, PFXKEY(t, h), n) != 0)
+		return (flags);
+	skey->data = (char *)key->data + n;
+	skey->size = key->size - n;
+	return (flags | P_PFXKEY);
+}
+
+/**
+ * BT_KEYLCP -- Length of the common prefix of a record's key and a key.
+ *
+ *	@param t	tree
+ *	@param h	leaf page
+ *	@param bl	record on the page (not P_BIGKEY)
+ *	@param key	key
+ *	@param len	upper limit
+ *
+ * @return
+ *	number of bytes in common
+ */
+static u_int32_t
+bt_keylcp(t, h, bl, key, len)
+	BTREE *t;
+	PAGE *h;
+	BLEAF *bl;
+	const char *key;
+	u_int32_t len;
+{
+	const char *p;
+	u_int32_t i, n;
+
+	n = bl->flags & P_PFXKEY ? PFXLEN(h) : 0;
+	len = MIN(len, n + bl->ksize);
+	for (i = 0, p = PFXKEY(t, h); i < n && i < len; ++i)
+		if (p[i] != key[i])
+			return (i);
+	for (; i < len; ++i)
+		if (bl->bytes[i - n] != key[i])
+			return (i);
+	return (len);
+}
+
+/**
+ * __BT_PFXCOMPACT -- Recalculate the key prefix of a full leaf page.
+ *
+ *	@param t	tree
+ *	@param h	leaf page
+ *	@param key	key going to be inserted (NULL if none)
+ *	@param flags	flags of the record going to be inserted
+ *
+ * @return
+ *	RET_SUCCESS if the page was rewritten, RET_SPECIAL if it would not
+ *	become smaller, RET_ERROR.
+ *
+ * The prefix is the longest one which all keys on the page and the new key
+ * have in common.  Since the keys are sorted, the first and the last keys
+ * decide it.  Overflow keys are stored whole and don't count.  The page is
+ * rewritten only when it becomes smaller, so records grow nowhere else and
+ * the page never overflows.
+ */
+int
+__bt_pfxcompact(t, h, key, flags)
+	BTREE *t;
+	PAGE *h;
+	const DBT *key;
+	int flags;
+{
+	BLEAF *bl;
+	PAGE *tp;
+	indx_t first, last, i, top;
+	u_int32_t n, nbytes, ksize, plen, used;
+	char *dest, *ref;
+
+	top = NEXTINDEX(h);
+	for (first = 0; first < top; ++first)
+		if (!(GETBLEAF(h, first)->flags & P_BIGKEY))
+			break;
+	if (first == top)
+		return (RET_SPECIAL);
+	for (last = top - 1; GETBLEAF(h, last)->flags & P_BIGKEY; --last)
+		;
+
+	/* The second half of the temporary page holds the first key. */
+	if ((tp = (PAGE *)malloc(t->bt_psize * 2)) == NULL)
+		return (RET_ERROR);
+	ref = (char *)tp + t->bt_psize;
+	bl = GETBLEAF(h, first);
+	plen = bl->flags & P_PFXKEY ? PFXLEN(h) : 0;
+	memmove(ref, PFXKEY(t, h), plen);
+	memmove(ref + plen, bl->bytes, bl->ksize);
+	n = bt_keylcp(t, h, GETBLEAF(h, last), ref, plen + bl->ksize);
+	if (key != NULL && !(flags & P_BIGKEY)) {
+		n = MIN(n, key->size);
+		for (i = 0; i < n; ++i)
+			if (ref[i] != ((char *)key->data)[i])
+				break;
+		n = i;
+	}
+
+	/* Calculate the space the records would need. */
+	used = LALIGN(n);
+	for (i = 0; i < top; ++i) {
+		bl = GETBLEAF(h, i);
+		if (bl->flags & P_BIGKEY)
+			used += NBLEAF(bl);
+		else {
+			plen = bl->flags & P_PFXKEY ? PFXLEN(h) : 0;
+			used += NBLEAFDBT(plen + bl->ksize - n, bl->dsize);
+		}
+	}
+	if (used >= t->bt_psize - h->upper) {
+		free(tp);
+		return (RET_SPECIAL);
+	}
+
+	/* Rewrite the records, keeping their indices. */
+	memmove(tp, h, t->bt_psize);
+	h->flags = (h->flags & ~P_PFXMASK) | n << P_PFXSHIFT;
+	h->upper = t->bt_psize - LALIGN(n);
+	memmove((char *)h + h->upper, ref, n);
+	for (i = 0; i < top; ++i) {
+		bl = GETBLEAF(tp, i);
+		if (bl->flags & P_BIGKEY) {
+			nbytes = NBLEAF(bl);
+			h->linp[i] = h->upper -= nbytes;
+			memmove((char *)h + h->upper, bl, nbytes);
+			continue;
+		}
+		plen = bl->flags & P_PFXKEY ? PFXLEN(tp) : 0;
+		ksize = plen + bl->ksize - n;
+		nbytes = NBLEAFDBT(ksize, bl->dsize);
+		h->linp[i] = h->upper -= nbytes;
+		dest = (char *)h + h->upper;
+		*(u_int32_t *)dest = ksize;
+		dest += sizeof(u_int32_t);
+		*(u_int32_t *)dest = bl->dsize;
+		dest += sizeof(u_int32_t);
+		*(u_char *)dest = (bl->flags & ~P_PFXKEY) | (n ? P_PFXKEY : 0);
+		dest += sizeof(u_char);
+		if (n < plen) {
+			memmove(dest, PFXKEY(t, tp) + n, plen - n);
+			memmove(dest + plen - n, bl->bytes, bl->ksize);
+		} else
+			memmove(dest, bl->bytes + n - plen, ksize);
+		dest += ksize;
+		memmove(dest, bl->bytes + bl->ksize, bl->dsize);
+	}
+	free(tp);
+	return (RET_SUCCESS);
+}
+
+/**
+ * __BT_CACHESTAT -- Get the statistics of the page cache.
+ *
+ *	@param dbp	pointer to the DB structure.
+ *	@param hit	number of pages found in the cache
+ *	@param miss	number of pages read from the file
+ *	@param flush	number of pages evicted from the cache
+ */
+void
+__bt_cachestat(dbp, hit, miss, flush)
+	const DB *dbp;
+	u_long *hit, *miss, *flush;
+{
+	const BTREE *t = dbp->internal;
+
+	*hit = t->bt_mp->cachehit;
+	*miss = t->bt_mp->cachemiss;
+	*flush = t->bt_mp->pageflush;
+}
+
+/**
+ * __BT_PAGESIZE -- Get the page size of the file.
+ *
+ *	@param dbp	pointer to the DB structure.
+ *
+ * @return
+ *	page size
+ */
+u_int
+__bt_pagesize(dbp)
+	const DB *dbp;
+{
+	const BTREE *t = dbp->internal;
+
+	return (t->bt_psize);
+}
@@ -87,6 +87,9 @@ typedef struct _page {
 #define P_TYPE		0x1f
 		/** never delete this chain of pages */
 #define	P_PRESERVE	0x20
+		/** length of the key prefix (B_PFXKEY leaf pages) */
+#define	P_PFXSHIFT	16
+#define	P_PFXMASK	0xffff0000
 	u_int32_t flags;
 
 	indx_t	lower;			/**< lower bound of free space on page */
@@ -100,6 +103,15 @@ typedef struct _page {
 	    sizeof(u_int32_t) + sizeof(indx_t) + sizeof(indx_t))
 #define	NEXTINDEX(p)	(((p)->lower - BTDATAOFF) / sizeof(indx_t))
 
+/**
+ * The leaf pages of a tree made with R_PFXKEY may hold the prefix which their
+ * keys have in common.  It is stored once at the end of the page, and the keys
+ * flagged P_PFXKEY hold only the rest of the key.  Other keys are stored whole.
+ */
+#define	PFXLEN(p)	((p)->flags >> P_PFXSHIFT)
+#define	PFXKEY(t, p)							\
+	((char *)(p) + (t)->bt_psize - LALIGN(PFXLEN(p)))
+
 /**
  * For pages other than overflow pages, there is an array of offsets into the
  * rest of the page immediately following the page header.  Each offset is to
@@ -136,6 +148,8 @@ typedef struct _binternal {
 #define	P_BIGDATA	0x01
 		/** overflow key */
 #define	P_BIGKEY	0x02
+		/** key without the prefix of the page */
+#define	P_PFXKEY	0x04
 	u_char	flags;
 	char	bytes[1];		/**< data */
 } BINTERNAL;
@@ -186,7 +200,7 @@ typedef struct _rinternal {
 typedef struct _bleaf {
 	u_int32_t	ksize;		/**< size of key */
 	u_int32_t	dsize;		/**< size of data */
-	u_char	flags;			/**< P_BIGDATA, P_BIGKEY */
+	u_char	flags;			/**< P_BIGDATA, P_BIGKEY, P_PFXKEY */
 	char	bytes[1];		/**< data */
 } BLEAF;
 
@@ -316,7 +330,7 @@ typedef struct _btmeta {
 	u_int32_t	free;		/**< page number of first free page */
 	u_int32_t	nrecs;		/**< R: number of records */
 
-#define	SAVEMETA	(B_NODUPS | R_RECNO)
+#define	SAVEMETA	(B_NODUPS | R_RECNO | B_PFXKEY)
 	u_int32_t	flags;		/**< bt_flags & SAVEMETA */
 } BTMETA;
 
@@ -375,7 +389,7 @@ typedef struct _btree {
 
 /*
  * NB:
- * B_NODUPS and R_RECNO are stored on disk, and may not be changed.
+ * B_NODUPS, R_RECNO and B_PFXKEY are stored on disk, and may not be changed.
  */
 		/** in-memory tree */
 #define	B_INMEM		0x00001
@@ -417,6 +431,10 @@ typedef struct _btree {
 #define	B_DB_SHMEM	0x08000
 		/** DB_TXN specified. */
 #define	B_DB_TXN	0x10000
+
+/** prefix compressed keys in leaf pages.
+    [Note] B_PFXKEY is stored on disk, and may not be changed. */
+#define	B_PFXKEY	0x20000
 	u_int32_t flags;
 } BTREE;
 
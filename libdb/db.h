@@ -141,6 +141,8 @@ typedef struct __db {
 #define	BTREEVERSION	3
 		/** duplicate keys */
 #define	R_DUP		0x01
+		/** prefix compressed keys (only when creating) */
+#define	R_PFXKEY	0x02
 
 /** Structure used to pass parameters to the btree routines. */
 typedef struct {
@@ -242,4 +244,6 @@ DB	*__bt_open(const char *, int, int, const BTREEINFO *, int);
 DB	*__hash_open(const char *, int, int, const HASHINFO *, int);
 DB	*__rec_open(const char *, int, int, const RECNOINFO *, int);
 void	 __dbpanic(DB *dbp);
+void	 __bt_cachestat(const DB *, u_long *, u_long *, u_long *);
+u_int	 __bt_pagesize(const DB *);
 #endif /* !_DB_H_ */
@@ -42,6 +42,8 @@ int	 __bt_get(const DB *, const DBT *, DBT *, u_int);
 PAGE	*__bt_new(BTREE *, pgno_t *);
 void	 __bt_pgin(void *, pgno_t, void *);
 void	 __bt_pgout(void *, pgno_t, void *);
+int	 __bt_pfxcompact(BTREE *, PAGE *, const DBT *, int);
+int	 __bt_pfxkey(BTREE *, PAGE *, const DBT *, int, DBT *);
 int	 __bt_push(BTREE *, pgno_t, int);
 int	 __bt_put(const DB *dbp, DBT *, const DBT *, u_int);
 int	 __bt_ret(BTREE *, EPG *, DBT *, DBT *, DBT *, DBT *, int);
@@ -49,6 +49,9 @@ static char sccsid[] = "@(#)mpool.c	8.5 (Berkeley) 7/26/94";
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef HAVE_POSIX_FADVISE
+#include <fcntl.h>
+#endif
 
 #if (defined(_WIN32) && !defined(__CYGWIN__))
 #define fsync _commit
@@ -61,7 +64,9 @@ static char sccsid[] = "@(#)mpool.c	8.5 (Berkeley) 7/26/94";
 #include "mpool.h"
 
 static BKT *mpool_bkt(MPOOL *);
+static BKT *mpool_victim(struct _lqh *);
 static BKT *mpool_look(MPOOL *, pgno_t);
+static void mpool_readahead(MPOOL *, pgno_t);
 static int  mpool_write(MPOOL *, BKT *);
 
 /**
@@ -81,7 +86,7 @@ mpool_open(key, fd, pagesize, maxcache)
 {
 	struct stat sb;
 	MPOOL *mp;
-	int entry;
+	pgno_t entry, hashsize;
 
 	/*
 	 * Get information about the file.
@@ -99,10 +104,24 @@ mpool_open(key, fd, pagesize, maxcache)
 	/* Allocate and initialize the MPOOL cookie. */
 	if ((mp = (MPOOL *)calloc(1, sizeof(MPOOL))) == NULL)
 		return (NULL);
+	/*
+	 * The hash array is sized for the cache, so that the hash chains
+	 * stay short even if the cache is large.
+	 */
+	for (hashsize = HASHSIZE; hashsize < maxcache && hashsize < MAXHASHSIZE;)
+		hashsize <<= 1;
+	if ((mp->hqh = calloc(hashsize, sizeof(*mp->hqh))) == NULL) {
+		free(mp);
+		return (NULL);
+	}
 	CIRCLEQ_INIT(&mp->lqh);
-	for (entry = 0; entry < HASHSIZE; ++entry)
+	CIRCLEQ_INIT(&mp->hotqh);
+	for (entry = 0; entry < hashsize; ++entry)
 		CIRCLEQ_INIT(&mp->hqh[entry]);
+	mp->hashmask = hashsize - 1;
 	mp->maxcache = maxcache;
+	mp->lastpgno = MAX_PAGE_NUMBER;
+	mp->ralast = MAX_PAGE_NUMBER;
 	mp->npages = sb.st_size / pagesize;
 	mp->pagesize = pagesize;
 	mp->fd = fd;
@@ -154,7 +173,7 @@ mpool_new(mp, pgnoaddr)
 #endif
 	/*
 	 * Get a BKT from the cache.  Assign a new page number, attach
-	 * it to the head of the hash chain, the tail of the lru chain,
+	 * it to the head of the hash chain, the tail of the cold queue,
 	 * and return.
 	 */
 	if ((bp = mpool_bkt(mp)) == NULL)
@@ -162,7 +181,7 @@ mpool_new(mp, pgnoaddr)
 	*pgnoaddr = bp->pgno = mp->npages++;
 	bp->flags = MPOOL_PINNED;
 
-	head = &mp->hqh[HASHKEY(bp->pgno)];
+	head = &mp->hqh[HASHKEY(mp, bp->pgno)];
 	CIRCLEQ_INSERT_HEAD(head, bp, hq);
 	CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
 	return (bp->page);
@@ -207,14 +226,28 @@ mpool_get(mp, pgno, flags)
 		}
 #endif
 		/*
-		 * Move the page to the head of the hash chain and the tail
-		 * of the lru chain.
+		 * Move the page to the head of the hash chain.
 		 */
-		head = &mp->hqh[HASHKEY(bp->pgno)];
+		head = &mp->hqh[HASHKEY(mp, bp->pgno)];
 		CIRCLEQ_REMOVE(head, bp, hq);
 		CIRCLEQ_INSERT_HEAD(head, bp, hq);
-		CIRCLEQ_REMOVE(&mp->lqh, bp, q);
-		CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+		/*
+		 * A hot page moves to the tail of the hot queue. A cold page
+		 * is promoted to the hot queue when it is referenced again,
+		 * unless the reference follows the previous one to the same
+		 * page; a cursor gets the current leaf page again and again
+		 * while scanning it, which doesn't mean the page is popular.
+		 */
+		if (bp->flags & MPOOL_HOT) {
+			CIRCLEQ_REMOVE(&mp->hotqh, bp, q);
+			CIRCLEQ_INSERT_TAIL(&mp->hotqh, bp, q);
+		} else if (pgno != mp->lastpgno) {
+			CIRCLEQ_REMOVE(&mp->lqh, bp, q);
+			CIRCLEQ_INSERT_TAIL(&mp->hotqh, bp, q);
+			bp->flags |= MPOOL_HOT;
+			++mp->curhot;
+		}
+		mp->lastpgno = pgno;
 
 		/* Return a pinned page. */
 		bp->flags |= MPOOL_PINNED;
@@ -229,6 +262,7 @@ mpool_get(mp, pgno, flags)
 #ifdef STATISTICS
 	++mp->pageread;
 #endif
+	mpool_readahead(mp, pgno);
 
 	/*
 	 * If both of `off_t' and `long' are 32 bits, the right operand
@@ -270,11 +304,12 @@ mpool_get(mp, pgno, flags)
 
 	/*
 	 * Add the page to the head of the hash chain and the tail
-	 * of the lru chain.
+	 * of the cold queue.
 	 */
-	head = &mp->hqh[HASHKEY(bp->pgno)];
+	head = &mp->hqh[HASHKEY(mp, bp->pgno)];
 	CIRCLEQ_INSERT_HEAD(head, bp, hq);
 	CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+	mp->lastpgno = pgno;
 
 	/* Run through the user's filter. */
 	if (mp->pgin != NULL)
@@ -312,6 +347,16 @@ mpool_put(mp, page, flags)
 #endif
 	bp->flags &= ~MPOOL_PINNED;
 	bp->flags |= flags & MPOOL_DIRTY;
+	/*
+	 * The caller knows that the page will be referenced often, e.g.
+	 * an internal page of a btree. Put it into the hot queue at once.
+	 */
+	if ((flags & MPOOL_HOT) && !(bp->flags & MPOOL_HOT)) {
+		CIRCLEQ_REMOVE(&mp->lqh, bp, q);
+		CIRCLEQ_INSERT_TAIL(&mp->hotqh, bp, q);
+		bp->flags |= MPOOL_HOT;
+		++mp->curhot;
+	}
 	return (RET_SUCCESS);
 }
 
@@ -327,13 +372,18 @@ mpool_close(mp)
 {
 	BKT *bp;
 
-	/* Free up any space allocated to the lru pages. */
+	/* Free up any space allocated to the cached pages. */
 	while ((bp = mp->lqh.cqh_first) != (void *)&mp->lqh) {
 		CIRCLEQ_REMOVE(&mp->lqh, mp->lqh.cqh_first, q);
 		free(bp);
 	}
+	while ((bp = mp->hotqh.cqh_first) != (void *)&mp->hotqh) {
+		CIRCLEQ_REMOVE(&mp->hotqh, mp->hotqh.cqh_first, q);
+		free(bp);
+	}
 
 	/* Free the MPOOL cookie. */
+	free(mp->hqh);
 	free(mp);
 	return (RET_SUCCESS);
 }
@@ -350,12 +400,17 @@ mpool_sync(mp)
 {
 	BKT *bp;
 
-	/* Walk the lru chain, flushing any dirty pages to disk. */
+	/* Walk the queues, flushing any dirty pages to disk. */
 	for (bp = mp->lqh.cqh_first;
 	    bp != (void *)&mp->lqh; bp = bp->q.cqe_next)
 		if (bp->flags & MPOOL_DIRTY &&
 		    mpool_write(mp, bp) == RET_ERROR)
 			return (RET_ERROR);
+	for (bp = mp->hotqh.cqh_first;
+	    bp != (void *)&mp->hotqh; bp = bp->q.cqe_next)
+		if (bp->flags & MPOOL_DIRTY &&
+		    mpool_write(mp, bp) == RET_ERROR)
+			return (RET_ERROR);
 
 	/* Sync the file descriptor. */
 	return (fsync(mp->fd) ? RET_ERROR : RET_SUCCESS);
@@ -379,34 +434,44 @@ mpool_bkt(mp)
 		goto new;
 
 	/*
-	 * If the cache is max'd out, walk the lru list for a buffer we
-	 * can flush.  If we find one, write it (if necessary) and take it
+	 * If the cache is max'd out, look for a buffer we can flush.
+	 * The cold queue is searched first while it holds more than a
+	 * quarter of the cache, so that the pages of a scan are recycled
+	 * among themselves; otherwise the least recently used hot page
+	 * is taken.  If we find one, write it (if necessary) and take it
 	 * off any lists.  If we don't find anything we grow the cache anyway.
 	 * The cache never shrinks.
 	 */
-	for (bp = mp->lqh.cqh_first;
-	    bp != (void *)&mp->lqh; bp = bp->q.cqe_next)
-		if (!(bp->flags & MPOOL_PINNED)) {
-			/* Flush if dirty. */
-			if (bp->flags & MPOOL_DIRTY &&
-			    mpool_write(mp, bp) == RET_ERROR)
-				return (NULL);
-#ifdef STATISTICS
-			++mp->pageflush;
-#endif
-			/* Remove from the hash and lru queues. */
-			head = &mp->hqh[HASHKEY(bp->pgno)];
-			CIRCLEQ_REMOVE(head, bp, hq);
+	if (mp->curcache - mp->curhot > mp->maxcache / 4) {
+		if ((bp = mpool_victim(&mp->lqh)) == NULL)
+			bp = mpool_victim(&mp->hotqh);
+	} else {
+		if ((bp = mpool_victim(&mp->hotqh)) == NULL)
+			bp = mpool_victim(&mp->lqh);
+	}
+	if (bp != NULL) {
+		/* Flush if dirty. */
+		if (bp->flags & MPOOL_DIRTY &&
+		    mpool_write(mp, bp) == RET_ERROR)
+			return (NULL);
+		++mp->pageflush;
+		/* Remove from the hash and replacement queues. */
+		head = &mp->hqh[HASHKEY(mp, bp->pgno)];
+		CIRCLEQ_REMOVE(head, bp, hq);
+		if (bp->flags & MPOOL_HOT) {
+			CIRCLEQ_REMOVE(&mp->hotqh, bp, q);
+			--mp->curhot;
+		} else
 			CIRCLEQ_REMOVE(&mp->lqh, bp, q);
 #ifdef DEBUG
-			{ void *spage;
-				spage = bp->page;
-				memset(bp, 0xff, sizeof(BKT) + mp->pagesize);
-				bp->page = spage;
-			}
-#endif
-			return (bp);
+		{ void *spage;
+			spage = bp->page;
+			memset(bp, 0xff, sizeof(BKT) + mp->pagesize);
+			bp->page = spage;
 		}
+#endif
+		return (bp);
+	}
 
 new:	if ((bp = (BKT *)malloc(sizeof(BKT) + mp->pagesize)) == NULL)
 		return (NULL);
@@ -421,6 +486,59 @@ new:	if ((bp = (BKT *)malloc(sizeof(BKT) + mp->pagesize)) == NULL)
 	return (bp);
 }
 
+/**
+ * mpool_victim
+ *	Find the first page which can be flushed in a queue.
+ *
+ *	@param q	cold or hot queue
+ *	@return		BKT or NULL
+ */
+static BKT *
+mpool_victim(q)
+	struct _lqh *q;
+{
+	BKT *bp;
+
+	for (bp = q->cqh_first; bp != (void *)q; bp = bp->q.cqe_next)
+		if (!(bp->flags & MPOOL_PINNED))
+			return (bp);
+	return (NULL);
+}
+
+/**
+ * mpool_readahead
+ *	Tell the kernel whether the pages are being read sequentially.
+ *
+ *	@param mp
+ *	@param pgno	page number to be read
+ *
+ * The leaf pages of a btree made by sorted insertion are almost in
+ * ascending order, with a few internal and overflow pages between them.
+ * So a read is regarded as sequential if it is a little ahead of the
+ * last read.  When a scan is detected, the kernel reads ahead in a larger
+ * window asynchronously; a short step backward doesn't break the scan,
+ * and anything else restores the normal access pattern.
+ */
+static void
+mpool_readahead(mp, pgno)
+	MPOOL *mp;
+	pgno_t pgno;
+{
+#ifdef HAVE_POSIX_FADVISE
+	if (pgno > mp->ralast && pgno - mp->ralast <= RAGAP) {
+		if (++mp->raseq == 2)
+			(void)posix_fadvise(mp->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	} else if (pgno < mp->ralast && mp->ralast - pgno <= RAGAP) {
+		return;
+	} else {
+		if (mp->raseq >= 2)
+			(void)posix_fadvise(mp->fd, 0, 0, POSIX_FADV_NORMAL);
+		mp->raseq = 0;
+	}
+	mp->ralast = pgno;
+#endif
+}
+
 /**
  * mpool_write
  *	Write a page to disk.
@@ -475,17 +593,13 @@ mpool_look(mp, pgno)
 	struct _hqh *head;
 	BKT *bp;
 
-	head = &mp->hqh[HASHKEY(pgno)];
+	head = &mp->hqh[HASHKEY(mp, pgno)];
 	for (bp = head->cqh_first; bp != (void *)head; bp = bp->hq.cqe_next)
 		if (bp->pgno == pgno) {
-#ifdef STATISTICS
 			++mp->cachehit;
-#endif
 			return (bp);
 		}
-#ifdef STATISTICS
 	++mp->cachemiss;
-#endif
 	return (NULL);
 }
 
@@ -519,6 +633,8 @@ mpool_stat(mp)
 		    * 100, mp->cachehit, mp->cachemiss);
 	(void)fprintf(stderr, "%lu page reads, %lu page writes\n",
 	    mp->pageread, mp->pagewrite);
+	(void)fprintf(stderr, "%lu pages in the hot queue\n",
+	    (long unsigned int)mp->curhot);
 
 	sep = "";
 	cnt = 0;
@@ -536,6 +652,19 @@ mpool_stat(mp)
 			sep = ", ";
 			
 	}
+	for (bp = mp->hotqh.cqh_first;
+	    bp != (void *)&mp->hotqh; bp = bp->q.cqe_next) {
+		(void)fprintf(stderr, "%s%dH", sep, bp->pgno);
+		if (bp->flags & MPOOL_DIRTY)
+			(void)fprintf(stderr, "d");
+		if (bp->flags & MPOOL_PINNED)
+			(void)fprintf(stderr, "P");
+		if (++cnt == 10) {
+			sep = "\n";
+			cnt = 0;
+		} else
+			sep = ", ";
+	}
 	(void)fprintf(stderr, "\n");
 }
 #endif
@@ -34,17 +34,33 @@
 /**
  * The memory pool scheme is a simple one.  Each in-memory page is referenced
  * by a bucket which is threaded in up to two of three ways.  All active pages
- * are threaded on a hash chain (hashed by page number) and an lru chain.
- * Inactive pages are threaded on a free chain.  Each reference to a memory
- * pool is handed an opaque MPOOL cookie which stores all of this information.
+ * are threaded on a hash chain (hashed by page number) and one of two
+ * replacement queues.  Inactive pages are threaded on a free chain.  Each
+ * reference to a memory pool is handed an opaque MPOOL cookie which stores
+ * all of this information.
+ *
+ * The replacement policy is a simplified 2Q.  A page read from the file
+ * enters the cold queue, which is a FIFO.  It is promoted to the hot queue,
+ * which is an LRU chain, when it is referenced again by an unrelated access.
+ * A sequential scan touches every leaf page only once, so it passes through
+ * the cold queue without flushing the hot pages, e.g. the root and the
+ * upper internal pages of a btree.
+ */
+#define	HASHSIZE	128		/**< minimum size of the hash array */
+#define	MAXHASHSIZE	65536		/**< maximum size of the hash array */
+#define	HASHKEY(mp, pgno)	((pgno - 1) & (mp)->hashmask)
+
+/**
+ * Read-ahead for sequential scans.  When pages are read from the file in
+ * ascending order, the kernel is told that the file is being read
+ * sequentially, so that a cursor scan reads the file in large chunks.
  */
-#define	HASHSIZE	128
-#define	HASHKEY(pgno)	((pgno - 1) % HASHSIZE)
+#define	RAGAP		8		/**< max gap between sequential reads */
 
 /** The BKT structures are the elements of the queues. */
 typedef struct _bkt {
 	CIRCLEQ_ENTRY(_bkt) hq;		/**< hash queue */
-	CIRCLEQ_ENTRY(_bkt) q;		/**< lru queue */
+	CIRCLEQ_ENTRY(_bkt) q;		/**< cold or hot queue */
 	void    *page;			/**< page */
 	pgno_t   pgno;			/**< page number */
 
@@ -52,28 +68,37 @@ typedef struct _bkt {
 #define	MPOOL_DIRTY	0x01
 			/** page is pinned into memory */
 #define	MPOOL_PINNED	0x02
+			/** page is in the hot queue (or should be put there) */
+#define	MPOOL_HOT	0x04
 	u_int8_t flags;			/**< flags */
 } BKT;
 
 typedef struct MPOOL {
 
 #ifndef IS__DOXYGEN_
-	CIRCLEQ_HEAD(_lqh, _bkt) lqh;	/**< lru queue head */
+	CIRCLEQ_HEAD(_lqh, _bkt) lqh;	/**< cold queue head */
+	struct _lqh hotqh;		/**< hot queue head */
 					/** hash queue array */
-	CIRCLEQ_HEAD(_hqh, _bkt) hqh[HASHSIZE];
+	CIRCLEQ_HEAD(_hqh, _bkt) *hqh;
 #else
 	struct _lqh {
 		struct _bkt *cqh_first;
 		struct _bkt *cqh_last;
-	} lqh;							/**< lru queue head */
+	} lqh;							/**< cold queue head */
+	struct _lqh hotqh;					/**< hot queue head */
 	struct _hqh {
 		struct _bkt *cqh_first;
 		struct _bkt *cqh_last;
-	} hqh[HASHSIZE];				/**< hash queue array */
+	} *hqh;							/**< hash queue array */
 #endif
+	pgno_t	hashmask;		/**< size of the hash array - 1 */
 	pgno_t	curcache;		/**< current number of cached pages */
+	pgno_t	curhot;			/**< number of pages in the hot queue */
 	pgno_t	maxcache;		/**< max number of cached pages */
 	pgno_t	npages;			/**< number of pages in the file */
+	pgno_t	lastpgno;		/**< page number of the last mpool_get */
+	pgno_t	ralast;			/**< page number of the last read */
+	pgno_t	raseq;			/**< number of sequential reads in a row */
 	u_long	pagesize;		/**< file page size */
 	int	fd;			/**< file descriptor */
 					/** page in conversion routine */
@@ -81,11 +106,11 @@ typedef struct MPOOL {
 					/** page out conversion routine */
 	void    (*pgout)(void *, pgno_t, void *);
 	void	*pgcookie;		/**< cookie for page in/out routines */
+	u_long	cachehit;		/**< number of pages found in the cache */
+	u_long	cachemiss;		/**< number of pages read from the file */
+	u_long	pageflush;		/**< number of pages evicted */
 #ifdef STATISTICS
-	u_long	cachehit;
-	u_long	cachemiss;
 	u_long	pagealloc;
-	u_long	pageflush;
 	u_long	pageget;
 	u_long	pagenew;
 	u_long	pageput;
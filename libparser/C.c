@@ -260,6 +260,15 @@ C_family(const struct parser_param *param, int type)
 		case SHARP_IMPORT:
 		case SHARP_INCLUDE:
 		case SHARP_INCLUDE_NEXT:
+			{
+				const char *name = include_name(cp);
+
+				if (name != NULL)
+					PUT(PARSER_INCLUDE, name, lineno, sp);
+			}
+			while ((c = nexttoken(interested, c_reserved_word)) != EOF && c != '\n')
+				;
+			break;
 		case SHARP_ERROR:
 		case SHARP_LINE:
 		case SHARP_PRAGMA:
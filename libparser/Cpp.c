@@ -342,6 +342,15 @@ Cpp(const struct parser_param *param)
 		case SHARP_IMPORT:
 		case SHARP_INCLUDE:
 		case SHARP_INCLUDE_NEXT:
+			{
+				const char *name = include_name(cp);
+
+				if (name != NULL)
+					PUT(PARSER_INCLUDE, name, lineno, sp);
+			}
+			while ((c = nexttoken(interested, cpp_reserved_word)) != EOF && c != '\n')
+				;
+			break;
 		case SHARP_ERROR:
 		case SHARP_LINE:
 		case SHARP_PRAGMA:
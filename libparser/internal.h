@@ -48,6 +48,7 @@ void php(const struct parser_param *);
 void assembly(const struct parser_param *);
 
 void dbg_print(int, const char *);
+const char *include_name(const char *);
 
 extern STRBUF *asm_symtable;
 void asm_initscan(void);
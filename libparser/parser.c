@@ -477,3 +477,33 @@ dbg_print(int level, const char *s)
 		fprintf(stderr, "    ");
 	fprintf(stderr, "%s\n", s);
 }
+/**
+ * include_name: extract the file name from an include directive.
+ *
+ *	@param[in]	p	the rest of the line following the keyword
+ *	@return		file name or NULL (not a file name; e.g. macro)
+ *
+ * Ex: #include <sys/stat.h> => 'sys/stat.h'
+ *     #include "global.h"   => 'global.h'
+ */
+const char *
+include_name(const char *p)
+{
+	STATIC_STRBUF(sb);
+	int sep;
+
+	strbuf_clear(sb);
+	while (*p == ' ' || *p == '\t')
+		p++;
+	if (*p == '<')
+		sep = '>';
+	else if (*p == '"')
+		sep = '"';
+	else
+		return NULL;
+	for (p++; *p && *p != sep && *p != '\n'; p++)
+		strbuf_putc(sb, *p);
+	if (*p != sep || strbuf_getlen(sb) == 0)
+		return NULL;
+	return strbuf_value(sb);
+}
@@ -33,6 +33,8 @@ void parser_exit(void);
 #define PARSER_DEF		1
 			/** reference or other symbol */
 #define PARSER_REF_SYM		2
+			/** include directive (tag is the file name) */
+#define PARSER_INCLUDE		3
 
 /* flags */
 			/** debug mode */
@@ -55,7 +55,6 @@ int is_sqlite3(const char *);
 DBOP *dbop3_open(const char *, int, int, int);
 const char *dbop3_get(DBOP *, const char *);
 const char *dbop3_getflag(DBOP *);
-char *dbop3_quote(char *);
 void dbop3_put(DBOP *, const char *, const char *, const char *);
 void dbop3_delete(DBOP *, const char *);
 void dbop3_update(DBOP *, const char *, const char *);
@@ -189,6 +188,50 @@ terminate_sort_process(DBOP *dbop) {
 }
 #endif
 
+/**
+ * decide_pagesize: decide the page size of a new tag file.
+ *
+ *	@return		page size
+ *
+ * GTAGSPAGESIZE should be a power of 2 from GTAGSMINPAGESIZE to
+ * GTAGSMAXPAGESIZE. 'auto' is replaced with a number by gtags(1)
+ * before the tag files are made (see dbop_auto_pagesize()); otherwise
+ * it means the default.
+ */
+static int
+decide_pagesize(void)
+{
+	const char *p = getenv("GTAGSPAGESIZE");
+	int size;
+
+	if (p == NULL || *p == '\0' || !strcmp(p, "auto"))
+		return GTAGSPAGESIZE;
+	size = atoi(p);
+	if (size < GTAGSMINPAGESIZE || size > GTAGSMAXPAGESIZE || (size & (size - 1)))
+		die("invalid page size '%s' (GTAGSPAGESIZE).", p);
+	return size;
+}
+/**
+ * dbop_auto_pagesize: choose the page size for a tag file.
+ *
+ *	@param[in]	estimate	estimated size of the tag file
+ *	@return		page size
+ *
+ * A large tag file has long compact records, which are split at a quarter
+ * of the page size. Larger pages keep them in fewer records and leave
+ * fewer internal pages to walk.
+ */
+int
+dbop_auto_pagesize(off_t estimate)
+{
+	if (estimate < 16 * 1024 * 1024)
+		return GTAGSPAGESIZE;
+	if (estimate < 64 * 1024 * 1024)
+		return 16384;
+	if (estimate < 256 * 1024 * 1024)
+		return 32768;
+	return GTAGSMAXPAGESIZE;
+}
 #ifdef USE_SQLITE3
 static const char *sqlite_header = "SQLite format 3";
 int
@@ -216,6 +259,7 @@ is_sqlite3(const char *path) {
  *	@param[in]	flags
  *			DBOP_DUP: allow duplicate records.
  *			DBOP_SORTED_WRITE: use sorted writing. This requires POSIX sort.
+ *			DBOP_PFXKEY: compress the keys by their common prefix.
  *	@return		descripter for dbop_xxx() or NULL
  *
  * Sorted wirting is fast because all writing is done by not insertion but addition.
@@ -255,7 +299,16 @@ dbop_open(const char *path, int mode, int perm, int flags)
 	memset(&info, 0, sizeof(info));
 	if (flags & DBOP_DUP)
 		info.flags |= R_DUP;
-	info.psize = DBOP_PAGESIZE;
+	/*
+	 * The page size of an existing file is read from its meta page.
+	 */
+	if (mode == 1)
+		info.psize = decide_pagesize();
+	/*
+	 * Whether the keys are compressed is also recorded in the meta page.
+	 */
+	if (mode == 1 && flags & DBOP_PFXKEY)
+		info.flags |= R_PFXKEY;
 	/*
 	 * Decide cache size. The default value is 5MB.
 	 * See libutil/gparam.h for the details.
@@ -299,6 +352,11 @@ dbop_open(const char *path, int mode, int perm, int flags)
 	dbop->perm	= (mode == 1) ? perm : 0;
 	dbop->lastdat	= NULL;
 	dbop->lastsize	= 0;
+#ifdef USE_DB185_COMPAT
+	dbop->pagesize	= info.psize ? info.psize : GTAGSPAGESIZE;
+#else
+	dbop->pagesize	= __bt_pagesize(db);
+#endif
 	dbop->sortout	= NULL;
 	dbop->sortin	= NULL;
 	/*
@@ -523,6 +581,32 @@ dbop_update(DBOP *dbop, const char *key, const char *dat)
 #endif
 	dbop_put(dbop, key, dat);
 }
+/**
+ * dbop_setdfa: register a lazy DFA equivalent to a regular expression.
+ *
+ *	@param[in]	dbop	dbop descripter
+ *	@param[in]	preg	compiled regular expression
+ *	@param[in]	dfa	DFA made from the same pattern or NULL
+ *
+ * When dbop_first() is called with 'preg', the keys are checked with
+ * the DFA instead of regexec(). The DFA is owned by the caller.
+ */
+void
+dbop_setdfa(DBOP *dbop, regex_t *preg, DFA *dfa)
+{
+	dbop->dfa_preg = dfa ? preg : NULL;
+	dbop->dfa = dfa;
+}
+/**
+ * dbop_match: whether the key matches the regular expression.
+ */
+static int
+dbop_match(DBOP *dbop, regex_t *preg, const char *key)
+{
+	if (dbop->dfa && preg == dbop->dfa_preg)
+		return dfa_match(dbop->dfa, key);
+	return regexec(preg, key, 0, 0, 0) == 0;
+}
 /**
  * dbop_first: get first record. 
  * 
@@ -575,7 +659,7 @@ dbop_first(DBOP *dbop, const char *name, regex_t *preg, int flags)
 				if (strcmp((char *)key.data, dbop->key))
 					return NULL;
 			}
-			if (preg && regexec(preg, (char *)key.data, 0, 0, 0) != 0)
+			if (preg && !dbop_match(dbop, preg, (char *)key.data))
 				continue;
 			break;
 		}
@@ -588,7 +672,7 @@ dbop_first(DBOP *dbop, const char *name, regex_t *preg, int flags)
 			/* skip meta records */
 			if (ismeta(key.data) && !(dbop->openflags & DBOP_RAW))
 				continue;
-			if (preg && regexec(preg, (char *)key.data, 0, 0, 0) != 0)
+			if (preg && !dbop_match(dbop, preg, (char *)key.data))
 				continue;
 			break;
 		}
@@ -663,7 +747,7 @@ dbop_next(DBOP *dbop)
 			if (strcmp((char *)key.data, dbop->key))
 				return NULL;
 		}
-		if (dbop->preg && regexec(dbop->preg, (char *)key.data, 0, 0, 0) != 0)
+		if (dbop->preg && !dbop_match(dbop, dbop->preg, (char *)key.data))
 			continue;
 		return (flags & DBOP_KEY) ? (char *)key.data : (char *)dat.data;
 	}
@@ -785,6 +869,29 @@ dbop_putversion(DBOP *dbop, int version)
 	snprintf(number, sizeof(number), "%d", version);
 	dbop_putoption(dbop, VERSIONKEY, number);
 }
+/**
+ * dbop_cachestat: get the statistics of the page cache
+ *
+ *	@param[in]	dbop	dbop descripter
+ *	@param[out]	hit	number of pages found in the cache
+ *	@param[out]	miss	number of pages read from the file
+ *	@param[out]	flush	number of pages evicted from the cache
+ *	@return		0: succeeded, -1: not available
+ */
+int
+dbop_cachestat(DBOP *dbop, unsigned long *hit, unsigned long *miss, unsigned long *flush)
+{
+#ifdef USE_SQLITE3
+	if (dbop->openflags & DBOP_SQLITE3)
+		return -1;
+#endif
+#ifdef USE_DB185_COMPAT
+	return -1;
+#else
+	__bt_cachestat(dbop->db, hit, miss, flush);
+	return 0;
+#endif
+}
 /**
  * dbop_close: close db
  * 
@@ -847,6 +954,12 @@ dbop_close(DBOP *dbop)
 	(void)free(dbop);
 }
 #ifdef USE_SQLITE3
+static int
+page_size_callback(void *v, int argc, char **argv, char **colname) {
+	if (argc > 0 && argv[0])
+		((DBOP *)v)->pagesize = atoi(argv[0]);
+	return SQLITE_OK;
+}
 DBOP *
 dbop3_open(const char *path, int mode, int perm, int flags) {
 	int rc, rw = 0;
@@ -904,7 +1017,6 @@ dbop3_open(const char *path, int mode, int perm, int flags) {
 		die("sqlite3_open_v2 failed. (rc = %d)", rc);
 	dbop = (DBOP *)check_calloc(sizeof(DBOP), 1);
 	strlimcpy(dbop->dbname, path, sizeof(dbop->dbname));
-	dbop->sb        = strbuf_open(0);
 	dbop->db3       = db3;
 	dbop->openflags	= flags;
 	dbop->perm	= (mode == 1) ? perm : 0;
@@ -917,11 +1029,17 @@ dbop3_open(const char *path, int mode, int perm, int flags) {
 	dbop->stmt      = NULL;
 	dbop->tblname   = check_strdup(tblname);
 	/*
-	 * Maximum file size is DBOP_PAGESIZE * 2147483646.
-	 * if DBOP_PAGESIZE == 8192 then maximum file size is 17592186028032 (17T).
+	 * Maximum file size is page size * 2147483646.
+	 * if page size == 8192 then maximum file size is 17592186028032 (17T).
+	 * The page size of an existing file is kept in the file.
 	 */
-	snprintf(buf, sizeof(buf), "pragma page_size=%d", DBOP_PAGESIZE);
-	rc = sqlite3_exec(dbop->db3, buf,  NULL, NULL, &errmsg);
+	if (mode == 1) {
+		snprintf(buf, sizeof(buf), "pragma page_size=%d", decide_pagesize());
+		rc = sqlite3_exec(dbop->db3, buf,  NULL, NULL, &errmsg);
+		if (rc != SQLITE_OK)
+			die("pragma page_size error: %s", errmsg);
+	}
+	rc = sqlite3_exec(dbop->db3, "pragma page_size", page_size_callback, dbop, &errmsg);
 	if (rc != SQLITE_OK)
 		die("pragma page_size error: %s", errmsg);
 	/*
@@ -941,18 +1059,31 @@ dbop3_open(const char *path, int mode, int perm, int flags) {
 		strbuf_puts(sql, "create table ");
 		strbuf_puts(sql, dbop->tblname);
 		strbuf_puts(sql, " (key text, dat text, extra text");
+		/*
+		 * A table without duplicate keys is stored in the order of
+		 * the key, and needs no index.
+		 */
 		if (!(flags & DBOP_DUP))
-			strbuf_puts(sql, ", primary key(key)");
-		strbuf_putc(sql, ')');
+			strbuf_puts(sql, ", primary key(key)) without rowid");
+		else
+			strbuf_putc(sql, ')');
 		rc = sqlite3_exec(dbop->db3, strbuf_value(sql), NULL, NULL, &errmsg);
         	if (rc != SQLITE_OK)
 			die("create table error: %s", errmsg);
+		dbop->rowid = (flags & DBOP_DUP) ? 1 : 0;
+	} else {
+		sqlite3_stmt *stmt;
+
+		/*
+		 * Tag files made by older GLOBAL always have rowid.
+		 */
+		strbuf_clear(sql);
+		strbuf_sprintf(sql, "select rowid from %s limit 0", dbop->tblname);
+		if (sqlite3_prepare_v2(dbop->db3, strbuf_value(sql), -1, &stmt, NULL) == SQLITE_OK) {
+			dbop->rowid = 1;
+			sqlite3_finalize(stmt);
+		}
 	}
-	/*
-	rc = sqlite3_exec(dbop->db3, "pragma synchronous=off", NULL, NULL, &errmsg);
-       	if (rc != SQLITE_OK)
-		die("pragma synchronous=off error: %s", errmsg);
-	*/
 	/*
          * Decide cache size.
          * See libutil/gparam.h for the details.
@@ -962,62 +1093,120 @@ dbop3_open(const char *path, int mode, int perm, int flags) {
 		cache_size = atoi(getenv("GTAGSCACHE"));
 	if (cache_size < GTAGSMINCACHE)
 		cache_size = GTAGSMINCACHE;
-	cache_size = (cache_size + DBOP_PAGESIZE - 1) / DBOP_PAGESIZE;
+	cache_size = (cache_size + dbop->pagesize - 1) / dbop->pagesize;
 	snprintf(buf, sizeof(buf), "pragma cache_size=%d", cache_size);
 	rc = sqlite3_exec(dbop->db3, buf,  NULL, NULL, &errmsg);
        	if (rc != SQLITE_OK)
 		die("pragma cache_size error: %s", errmsg);
-	sqlite3_exec(dbop->db3, "pragma journal_mode=memory", NULL, NULL, &errmsg);
-       	if (rc != SQLITE_OK)
-		die("pragma journal_mode=memory error: %s", errmsg);
-	sqlite3_exec(dbop->db3, "pragma synchronous=off", NULL, NULL, &errmsg);
-       	if (rc != SQLITE_OK)
-		die("pragma synchronous=off error: %s", errmsg);
+	/*
+	 * A new tag file is made from scratch and is useless anyway if gtags
+	 * fails on the way, so it needs no journal. An existing tag file
+	 * is switched to the write-ahead log by dbop3_start_update().
+	 * In both cases, all records are written in a transaction,
+	 * which is committed by dbop3_close().
+	 */
+	if (mode == 1) {
+		rc = sqlite3_exec(dbop->db3, "pragma journal_mode=off", NULL, NULL, &errmsg);
+		if (rc != SQLITE_OK)
+			die("pragma journal_mode=off error: %s", errmsg);
+		rc = sqlite3_exec(dbop->db3, "pragma synchronous=off", NULL, NULL, &errmsg);
+		if (rc != SQLITE_OK)
+			die("pragma synchronous=off error: %s", errmsg);
+	}
 	rc = sqlite3_exec(dbop->db3, "begin transaction", NULL, NULL, &errmsg);
        	if (rc != SQLITE_OK)
 		die("begin transaction error: %s", errmsg);
 	strbuf_release_tempbuf(sql);
 	return dbop;
 }
-static int
-single_select_callback(void *v, int argc, char **argv, char **colname) {
-	STATIC_STRBUF(sb);
-	DBOP *dbop = (DBOP *)v;
+/**
+ * dbop3_prepare: prepare a statement once and reuse it.
+ *
+ *	@param[in]	dbop	descripter
+ *	@param[out]	stmtp	statement
+ *	@param[in]	format	SQL statement ('%s' is replaced with the table name)
+ *	@return		statement
+ */
+static sqlite3_stmt *
+dbop3_prepare(DBOP *dbop, sqlite3_stmt **stmtp, const char *format) {
+	int rc;
 
-	if (argc > 0) {
-		strbuf_clear(sb);
-		strbuf_puts(sb, argv[0]);
-		dbop->lastsize = strbuf_getlen(sb);
-		if (argv[1]) {
-			strbuf_putc(sb, '\0');
-			strbuf_puts(sb, argv[1]);
-		}
-		dbop->lastdat = strbuf_value(sb);
-		dbop->lastflag = argv[1] ? dbop->lastdat + dbop->lastsize + 1 : NULL;
-	} else {
-		dbop->lastdat = NULL;
-		dbop->lastflag = NULL;
-		dbop->lastsize = 0;
+	if (*stmtp == NULL) {
+		STRBUF *sql = strbuf_open_tempbuf();
+
+		strbuf_sprintf(sql, format, dbop->tblname);
+		rc = sqlite3_prepare_v2(dbop->db3, strbuf_value(sql), -1, stmtp, NULL);
+		if (rc != SQLITE_OK)
+			die("sqlite3_prepare_v2 failed. (rc = %d, sql = %s)", rc, strbuf_value(sql));
+		strbuf_release_tempbuf(sql);
+	}
+	return *stmtp;
+}
+/**
+ * dbop3_execute: execute a statement which returns no row.
+ *
+ *	@param[in]	stmt	statement
+ *	@param[in]	name	name of the caller for error message
+ */
+static void
+dbop3_execute(sqlite3_stmt *stmt, const char *name) {
+	int rc;
+
+	rc = sqlite3_step(stmt);
+	if (rc != SQLITE_DONE)
+		die("%s failed. (rc = %d)", name, rc);
+	rc = sqlite3_reset(stmt);
+	if (rc != SQLITE_OK)
+		die("%s reset failed. (rc = %d)", name, rc);
+}
+/**
+ * dbop3_finalize: finalize a statement.
+ *
+ *	@param[in,out]	stmtp	statement
+ */
+static void
+dbop3_finalize(sqlite3_stmt **stmtp) {
+	int rc;
+
+	if (*stmtp) {
+		rc = sqlite3_finalize(*stmtp);
+		if (rc != SQLITE_OK)
+			die("sqlite3_finalize failed. (rc = %d)", rc);
+		*stmtp = NULL;
 	}
-	return SQLITE_OK;
 }
 const char *
 dbop3_get(DBOP *dbop, const char *name) {
+	STATIC_STRBUF(sb);
+	sqlite3_stmt *stmt;
+	const char *flag;
 	int rc;
-	char *errmsg = 0;
-	STRBUF *sql = strbuf_open_tempbuf();
 
-	strbuf_sprintf(sql, "select dat, extra from %s where key = '%s' limit 1",
-			dbop->tblname, name); 
+	stmt = dbop3_prepare(dbop, &dbop->stmt_get3, "select dat, extra from %s where key = ? limit 1");
+	rc = sqlite3_bind_text(stmt, 1, name, -1, SQLITE_STATIC);
+	if (rc != SQLITE_OK)
+		die("dbop3_get bind failed. (rc = %d)", rc);
 	dbop->lastdat = NULL;
 	dbop->lastsize = 0;
 	dbop->lastflag = NULL;
-	rc = sqlite3_exec(dbop->db3, strbuf_value(sql), single_select_callback, dbop, &errmsg);
-       	if (rc != SQLITE_OK) {
-		sqlite3_close(dbop->db3);
-		die("dbop3_get failed: %s", errmsg);
+	rc = sqlite3_step(stmt);
+	if (rc == SQLITE_ROW) {
+		strbuf_clear(sb);
+		strbuf_puts(sb, (const char *)sqlite3_column_text(stmt, 0));
+		dbop->lastsize = strbuf_getlen(sb);
+		flag = (const char *)sqlite3_column_text(stmt, 1);
+		if (flag) {
+			strbuf_putc(sb, '\0');
+			strbuf_puts(sb, flag);
+		}
+		dbop->lastdat = strbuf_value(sb);
+		dbop->lastflag = flag ? dbop->lastdat + dbop->lastsize + 1 : NULL;
+	} else if (rc != SQLITE_DONE) {
+		die("dbop3_get failed. (rc = %d)", rc);
 	}
-	strbuf_release_tempbuf(sql);
+	rc = sqlite3_reset(stmt);
+	if (rc != SQLITE_OK)
+		die("dbop3_get reset failed. (rc = %d)", rc);
 	return dbop->lastdat;
 }
 const char *
@@ -1025,162 +1214,221 @@ dbop3_getflag(DBOP *dbop)
 {
 	return dbop->lastflag ? dbop->lastflag : "";
 }
-char *
-dbop3_quote(char *string) {
-	STATIC_STRBUF(sb);
-	char *p;
+static int
+journal_mode_callback(void *v, int argc, char **argv, char **colname) {
+	*(int *)v = (argc > 0 && argv[0] && !strcmp(argv[0], "wal"));
+	return SQLITE_OK;
+}
+/**
+ * dbop3_start_update: prepare for the first write to an existing tag file.
+ *
+ *	@param[in]	dbop	descripter
+ *
+ * The write-ahead log keeps the tag file consistent, and lets global
+ * read it during the update. It is not used until something is written,
+ * because changing the journal mode rewrites the header of the file,
+ * and gtags compares the modification time of GTAGS with source files.
+ */
+static void
+dbop3_start_update(DBOP *dbop) {
+	int rc;
+	char *errmsg = 0;
 
-	strbuf_clear(sb);
-	for (p = string; *p; p++) {
-		if (*p == '\'')
-			strbuf_putc(sb, '\'');
-		strbuf_putc(sb, *p);
-	}
-	return strbuf_value(sb);
+	if (dbop->mode != 2 || dbop->update)
+		return;
+	dbop->update = 1;
+	rc = sqlite3_exec(dbop->db3, "end transaction", NULL, NULL, &errmsg);
+	if (rc != SQLITE_OK)
+		die("end transaction error: %s", errmsg);
+	/*
+	 * It fails while a statement is in progress. Then the rollback
+	 * journal is used as usual.
+	 */
+	(void)sqlite3_exec(dbop->db3, "pragma journal_mode=wal", journal_mode_callback, &dbop->wal, NULL);
+	rc = sqlite3_exec(dbop->db3, "pragma synchronous=normal", NULL, NULL, &errmsg);
+	if (rc != SQLITE_OK)
+		die("pragma synchronous=normal error: %s", errmsg);
+	rc = sqlite3_exec(dbop->db3, "begin transaction", NULL, NULL, &errmsg);
+	if (rc != SQLITE_OK)
+		die("begin transaction error: %s", errmsg);
 }
 void
 dbop3_put(DBOP *dbop, const char *p1, const char *p2, const char *p3) {
+	sqlite3_stmt *stmt;
 	int rc, len;
-	char *errmsg = 0;
-	STRBUF *sql = strbuf_open_tempbuf();
 
 	if (!(len = strlen(p1)))
 		die("primary key size == 0.");
 	if (len > MAXKEYLEN)
 		die("primary key too long.");
-	if (dbop->stmt_put3 == NULL) {
-		strbuf_sprintf(sql, "insert into %s values (?, ?, ?)", dbop->tblname);
-		rc = sqlite3_prepare_v2(dbop->db3, strbuf_value(sql), -1, &dbop->stmt_put3, NULL);
-		if (rc != SQLITE_OK) {
-			die("dbop3_put prepare failed. (rc = %d, sql = %s)", rc, strbuf_value(sql));
-		}
-	}
-	rc = sqlite3_bind_text(dbop->stmt_put3, 1, p1, -1, SQLITE_STATIC);
+	dbop3_start_update(dbop);
+	stmt = dbop3_prepare(dbop, &dbop->stmt_put3, "insert into %s values (?, ?, ?)");
+	rc = sqlite3_bind_text(stmt, 1, p1, len, SQLITE_STATIC);
        	if (rc != SQLITE_OK) {
 		die("dbop3_put 1 failed. (rc = %d)", rc);
 	}
-	rc = sqlite3_bind_text(dbop->stmt_put3, 2, p2, -1, SQLITE_STATIC);
+	rc = sqlite3_bind_text(stmt, 2, p2, -1, SQLITE_STATIC);
        	if (rc != SQLITE_OK) {
 		die("dbop3_put 2 failed. (rc = %d)", rc);
 	}
-	rc = sqlite3_bind_text(dbop->stmt_put3, 3, p3, -1, SQLITE_STATIC);
+	rc = sqlite3_bind_text(stmt, 3, p3, -1, SQLITE_STATIC);
        	if (rc != SQLITE_OK) {
 		die("dbop3_put 3 failed. (rc = %d)", rc);
 	}
-	rc = sqlite3_step(dbop->stmt_put3);
-       	if (rc != SQLITE_DONE) {
-		die("dbop3_put failed. (rc = %d)", rc);
-	}
-	rc = sqlite3_reset(dbop->stmt_put3);
-       	if (rc != SQLITE_OK) {
-		die("dbop3_put reset failed. (rc = %d)", rc);
-	}
-	if (dbop->writecount++ > DBOP_COMMIT_THRESHOLD) {
-		dbop->writecount = 0;
-		rc = sqlite3_exec(dbop->db3, "end transaction", NULL, NULL, &errmsg);
-		if (rc != SQLITE_OK)
-			die("end transaction error: %s", errmsg);
-		rc = sqlite3_exec(dbop->db3, "begin transaction", NULL, NULL, &errmsg);
-		if (rc != SQLITE_OK)
-			die("begin transaction error: %s", errmsg);
-	}
-	strbuf_release_tempbuf(sql);
+	dbop3_execute(stmt, "dbop3_put");
 }
 void
 dbop3_delete(DBOP *dbop, const char *path) {
+	sqlite3_stmt *stmt;
 	int rc;
-	char *errmsg = 0;
-	STRBUF *sql = strbuf_open_tempbuf();
 
-	strbuf_puts(sql, "delete from ");
-	strbuf_puts(sql, dbop->tblname);
-	strbuf_puts(sql, " where");
-	if (path) {
-		if (*path == '(') {
-			strbuf_puts(sql, " extra in ");
-			strbuf_puts(sql, path); 
-		} else {
-			strbuf_puts(sql, " key = '");
-			strbuf_puts(sql, path);
-			strbuf_puts(sql, "'");
+	dbop3_start_update(dbop);
+	if (path && *path == '(') {
+		char *errmsg = 0;
+		STRBUF *sql = strbuf_open_tempbuf();
+
+		/*
+		 * The list of file ids is made by gtags itself.
+		 */
+		strbuf_puts(sql, "delete from ");
+		strbuf_puts(sql, dbop->tblname);
+		strbuf_puts(sql, " where extra in ");
+		strbuf_puts(sql, path);
+		rc = sqlite3_exec(dbop->db3, strbuf_value(sql), NULL, NULL, &errmsg);
+		if (rc != SQLITE_OK) {
+			sqlite3_close(dbop->db3);
+			die("dbop3_delete failed: %s", errmsg);
 		}
-	} else {
-		strbuf_puts(sql, " rowid = ");
-		strbuf_putn64(sql, dbop->lastrowid);
+		strbuf_release_tempbuf(sql);
+		return;
 	}
-	rc = sqlite3_exec(dbop->db3, strbuf_value(sql), NULL, NULL, &errmsg);
-       	if (rc != SQLITE_OK) {
-		sqlite3_close(dbop->db3);
-		die("dbop3_delete failed: %s", errmsg);
+	/*
+	 * The key is unique in a table without rowid.
+	 */
+	if (path == NULL && !dbop->rowid)
+		path = dbop->lastkey;
+	if (path) {
+		stmt = dbop3_prepare(dbop, &dbop->stmt_delete3, "delete from %s where key = ?");
+		rc = sqlite3_bind_text(stmt, 1, path, -1, SQLITE_STATIC);
+	} else {
+		stmt = dbop3_prepare(dbop, &dbop->stmt_delrow3, "delete from %s where rowid = ?");
+		rc = sqlite3_bind_int64(stmt, 1, sqlite3_column_int64(dbop->stmt, 3));
 	}
-	strbuf_release_tempbuf(sql);
+	if (rc != SQLITE_OK)
+		die("dbop3_delete bind failed. (rc = %d)", rc);
+	dbop3_execute(stmt, "dbop3_delete");
 }
 void
 dbop3_update(DBOP *dbop, const char *key, const char *dat) {
+	sqlite3_stmt *stmt;
 	int rc;
-	char *errmsg = 0;
-	STRBUF *sql = strbuf_open_tempbuf();
 
-	strbuf_sprintf(sql, "update %s set dat = '%s' where key = '%s'",
-					dbop->tblname, dbop3_quote((char *)dat), key);
-	rc = sqlite3_exec(dbop->db3, strbuf_value(sql), NULL, NULL, &errmsg);
-       	if (rc != SQLITE_OK) {
-		sqlite3_close(dbop->db3);
-		die("dbop3_update failed: %s", errmsg);
-	}
-	if (sqlite3_changes(dbop->db3) == 0) {
-		strbuf_clear(sql);
-		strbuf_sprintf(sql, "insert into %s values ('%s', '%s', NULL)",
-					dbop->tblname, key, dbop3_quote((char *)dat));
-		rc = sqlite3_exec(dbop->db3, strbuf_value(sql), NULL, NULL, &errmsg);
-		if (rc != SQLITE_OK) {
-			sqlite3_close(dbop->db3);
-			die("dbop3_updated failed: %s", errmsg);
-		}
+	dbop3_start_update(dbop);
+	stmt = dbop3_prepare(dbop, &dbop->stmt_update3, "update %s set dat = ? where key = ?");
+	rc = sqlite3_bind_text(stmt, 1, dat, -1, SQLITE_STATIC);
+	if (rc == SQLITE_OK)
+		rc = sqlite3_bind_text(stmt, 2, key, -1, SQLITE_STATIC);
+	if (rc != SQLITE_OK)
+		die("dbop3_update bind failed. (rc = %d)", rc);
+	dbop3_execute(stmt, "dbop3_update");
+	if (sqlite3_changes(dbop->db3) == 0)
+		dbop3_put(dbop, key, dat, NULL);
+}
+/**
+ * dbop3_query: prepare a query once and reuse it.
+ *
+ *	@param[in]	dbop	descripter
+ *	@param[out]	stmtp	statement
+ *	@param[in]	where	condition
+ *	@return		statement
+ *
+ * The columns are key, dat, extra and rowid if the table has it.
+ */
+static sqlite3_stmt *
+dbop3_query(DBOP *dbop, sqlite3_stmt **stmtp, const char *where) {
+	int rc;
+
+	if (*stmtp == NULL) {
+		STRBUF *sql = strbuf_open_tempbuf();
+
+		strbuf_sprintf(sql, "select key, dat, extra%s from %s%s order by key",
+			dbop->rowid ? ", rowid" : "", dbop->tblname, where);
+		rc = sqlite3_prepare_v2(dbop->db3, strbuf_value(sql), -1, stmtp, NULL);
+		if (rc != SQLITE_OK)
+			die("sqlite3_prepare_v2 failed. (rc = %d, sql = %s)", rc, strbuf_value(sql));
+		strbuf_release_tempbuf(sql);
 	}
-	strbuf_release_tempbuf(sql);
+	return *stmtp;
+}
+/**
+ * dbop3_column: set the current record.
+ *
+ *	@param[in]	dbop	descripter
+ *	@param[in]	key	key of the record
+ *	@param[in]	dat	data of the record
+ *
+ * The values are not copied. They are valid until the next call of
+ * sqlite3_step() like the records of the B-tree.
+ */
+static void
+dbop3_column(DBOP *dbop, const char *key, const char *dat) {
+	dbop->lastdat = (char *)dat;
+	dbop->lastsize = sqlite3_column_bytes(dbop->stmt, 1);
+	dbop->lastflag = (char *)sqlite3_column_text(dbop->stmt, 2);
+	dbop->lastkey = (char *)key;
+	dbop->lastkeysize = sqlite3_column_bytes(dbop->stmt, 0);
 }
 const char *
 dbop3_first(DBOP *dbop, const char *name, regex_t *preg, int flags) {
 	int rc;
 	char *key;
-	STRBUF *sql = strbuf_open_tempbuf();
 
 	dbop->done = 0; 	/* This is turned on when it receives SQLITE_DONE. */
-	strbuf_puts(sql, "select rowid, * from ");
-	strbuf_puts(sql, dbop->tblname);
+	if (dbop->stmt) {
+		rc = sqlite3_reset(dbop->stmt);
+		if (rc != SQLITE_OK)
+			die("dbop3_first: sqlite3_reset failed. (rc = %d)", rc);
+	}
 	if (name) {
-		strbuf_puts(sql, " where key ");
+		char upper[MAXKEYLEN];
+
+		strlimcpy(dbop->key, name, sizeof(dbop->key));
+		dbop->keylen = strlen(name);
+		rc = SQLITE_OK;
 		if (dbop->ioflags & DBOP_PREFIX) {
+			int len = dbop->keylen;
+
 			/*
-			 * In sqlite3, 'like' ignores case. 'glob' does not ignore case.
+			 * The keys which begin with the prefix are in the range
+			 * [prefix, upper). The upper bound is made by incrementing
+			 * the last character which can be incremented.
 			 */
-			strbuf_puts(sql, "glob '");
-			strbuf_puts(sql, name);
-			strbuf_puts(sql, "*'");
+			strlimcpy(upper, name, sizeof(upper));
+			while (len > 0 && (unsigned char)upper[len - 1] == 0xff)
+				len--;
+			if (len > 0) {
+				upper[len - 1]++;
+				dbop->stmt = dbop3_query(dbop, &dbop->stmt_range3, " where key >= ? and key < ?");
+				rc = sqlite3_bind_text(dbop->stmt, 2, upper, len, SQLITE_TRANSIENT);
+			} else {
+				dbop->stmt = dbop3_query(dbop, &dbop->stmt_from3, " where key >= ?");
+			}
 		} else {
-			strbuf_puts(sql, "= '");
-			strbuf_puts(sql, name);
-			strbuf_puts(sql, "'");
+			dbop->stmt = dbop3_query(dbop, &dbop->stmt_key3, " where key = ?");
 		}
-		strlimcpy(dbop->key, name, sizeof(dbop->key));
-		dbop->keylen = strlen(name);
-	}
-	strbuf_puts(sql, " order by key");
-	if (dbop->stmt) {
-		rc = sqlite3_finalize(dbop->stmt);
+		if (rc == SQLITE_OK)
+			rc = sqlite3_bind_text(dbop->stmt, 1, dbop->key, dbop->keylen, SQLITE_STATIC);
 		if (rc != SQLITE_OK)
-			die("dbop3_finalize failed. (rc = %d)", rc);
-		dbop->stmt = NULL;
+			die("dbop3_first: bind failed. (rc = %d)", rc);
+	} else {
+		dbop->keylen = 0;
+		dbop->stmt = dbop3_query(dbop, &dbop->stmt_all3, "");
 	}
-	rc = sqlite3_prepare_v2(dbop->db3, strbuf_value(sql), -1, &dbop->stmt, NULL);
-	if (rc != SQLITE_OK)
-		die("dbop3_first: sqlite3_prepare_v2 failed. (rc = %d)", rc);
 	/*
-	 *	0: rowid
-	 *	1: key
-	 *	2: dat
-	 *	3: flags
+	 *	0: key
+	 *	1: dat
+	 *	2: flags
+	 *	3: rowid
 	 */
 	for (;;) {
 		/* Once it receives SQLITE_DONE, do not never return value */
@@ -1191,23 +1439,15 @@ dbop3_first(DBOP *dbop, const char *name, regex_t *preg, int flags) {
 			goto finish;
 		else if (rc == SQLITE_ROW) {
 			dbop->readcount++;
-			dbop->lastrowid = sqlite3_column_int64(dbop->stmt, 0);
-			key = (char *)sqlite3_column_text(dbop->stmt, 1);
+			key = (char *)sqlite3_column_text(dbop->stmt, 0);
 			if (name) {
-				if (dbop->ioflags & DBOP_PREFIX) {
-					if (strncmp(key, dbop->key, dbop->keylen))
-						goto finish;
-				} else {
-					if (strcmp(key, dbop->key)) 
-						goto finish;
-				}
-				if (dbop->preg && regexec(dbop->preg, key, 0, 0, 0) != 0)
+				if (dbop->preg && !dbop_match(dbop, dbop->preg, key))
 					continue;
 			} else {
 				/* skip meta records */
 				if (ismeta(key) && !(dbop->openflags & DBOP_RAW))
 					continue;
-				if (dbop->preg && regexec(dbop->preg, key, 0, 0, 0) != 0)
+				if (dbop->preg && !dbop_match(dbop, dbop->preg, key))
 					continue;
 			}
 			break;
@@ -1215,25 +1455,13 @@ dbop3_first(DBOP *dbop, const char *name, regex_t *preg, int flags) {
 			die("dbop3_first: something is wrong (rc = %d).", rc);
 		}
 	}
-	strbuf_clear(dbop->sb);
-	strbuf_puts0(dbop->sb, (char *)sqlite3_column_text(dbop->stmt, 2));
-	dbop->lastsize = strbuf_getlen(dbop->sb) - 1;
-	dbop->lastflag = (char *)sqlite3_column_text(dbop->stmt, 3);
-	if (dbop->lastflag)
-		strbuf_puts(dbop->sb, dbop->lastflag);
-	dbop->lastdat = strbuf_value(dbop->sb);
-	if (dbop->lastflag)
-		dbop->lastflag = dbop->lastdat + dbop->lastsize + 1;
-	dbop->lastkey = key;
-	dbop->lastkeysize = strlen(dbop->lastkey);
-	strbuf_release_tempbuf(sql);
+	dbop3_column(dbop, key, (char *)sqlite3_column_text(dbop->stmt, 1));
 	if (flags & DBOP_KEY) {
 		strlimcpy(dbop->prev, key, sizeof(dbop->prev));
 		return key;
 	}
 	return dbop->lastdat;
 finish:
-	strbuf_release_tempbuf(sql);
 	dbop->done = 1;
 	dbop->lastdat = NULL;
 	dbop->lastsize = 0;
@@ -1246,10 +1474,10 @@ dbop3_next(DBOP *dbop) {
 	char *key, *dat;
 
 	/*
-	 *	0: rowid
-	 *	1: key
-	 *	2: dat
-	 *	3: flags
+	 *	0: key
+	 *	1: dat
+	 *	2: flags
+	 *	3: rowid
 	 */
 	for (;;) {
 		/* Once it receives SQLITE_DONE, do not never return value */
@@ -1260,9 +1488,8 @@ dbop3_next(DBOP *dbop) {
 			goto finish;
 		else if (rc == SQLITE_ROW) {
 			dbop->readcount++;
-			dbop->lastrowid = sqlite3_column_int64(dbop->stmt, 0);
-			key = (char *)sqlite3_column_text(dbop->stmt, 1);
-			dat = (char *)sqlite3_column_text(dbop->stmt, 2);
+			key = (char *)sqlite3_column_text(dbop->stmt, 0);
+			dat = (char *)sqlite3_column_text(dbop->stmt, 1);
 			/* skip meta records */
 			if (!(dbop->openflags & DBOP_RAW)) {
 				if (dbop->ioflags & DBOP_KEY && ismeta(key))
@@ -1273,39 +1500,20 @@ dbop3_next(DBOP *dbop) {
 			if (dbop->ioflags & DBOP_KEY) {
 				if (!strcmp(dbop->prev, key))
 					continue;
-				if (strlen(key) > MAXKEYLEN)
+				if (sqlite3_column_bytes(dbop->stmt, 0) > MAXKEYLEN)
 					die("primary key too long.");
 				strlimcpy(dbop->prev, key, sizeof(dbop->prev));
 			}
-			if (dbop->ioflags & DBOP_PREFIX) {
-				if (strncmp(key, dbop->key, dbop->keylen))
-					goto finish;
-			} else if (dbop->keylen) {
-				if (strcmp(key, dbop->key)) 
-					goto finish;
-			}
-			if (dbop->preg && regexec(dbop->preg, key, 0, 0, 0) != 0)
+			if (dbop->preg && !dbop_match(dbop, dbop->preg, key))
 				continue;
 			break;
 		} else {
 			die("dbop3_next: something is wrong (rc = %d).", rc);
 		}
 	}
-	strbuf_clear(dbop->sb);
-	strbuf_puts0(dbop->sb, (char *)sqlite3_column_text(dbop->stmt, 2));
-	dbop->lastsize = strbuf_getlen(dbop->sb) - 1;
-	dbop->lastflag = (char *)sqlite3_column_text(dbop->stmt, 3);
-	if (dbop->lastflag)
-		strbuf_puts(dbop->sb, dbop->lastflag);
-	dbop->lastdat = strbuf_value(dbop->sb);
-	if (dbop->lastflag)
-		dbop->lastflag = dbop->lastdat + dbop->lastsize + 1;
-	dbop->lastkey = key;
-	dbop->lastkeysize = strlen(dbop->lastkey);
-	if (dbop->ioflags & DBOP_KEY) {
-		strlimcpy(dbop->prev, key, sizeof(dbop->prev));
+	dbop3_column(dbop, key, dat);
+	if (dbop->ioflags & DBOP_KEY)
 		return key;
-	}
 	return dbop->lastdat;
 finish:
 	dbop->done = 1;
@@ -1318,11 +1526,11 @@ dbop3_close(DBOP *dbop) {
 	int rc;
 	char *errmsg = 0;
 
-	rc = sqlite3_exec(dbop->db3, "end transaction", NULL, NULL, &errmsg);
-       	if (rc != SQLITE_OK)
-		die("end transaction error: %s", errmsg);
 	/*
-	 * create index
+	 * Indexes of a new tag file are made after all records are written,
+	 * which is much faster than updating them for each record.
+	 * The index of the key includes all columns, so that dbop3_first()
+	 * and dbop3_next() read records only from the index.
 	 */
 	if (dbop->mode == 1 && dbop->openflags & DBOP_DUP) {
 		STATIC_STRBUF(sql);
@@ -1330,7 +1538,7 @@ dbop3_close(DBOP *dbop) {
 		strbuf_clear(sql);
 		strbuf_puts(sql, "create index key_i on ");
 		strbuf_puts(sql, dbop->tblname);
-		strbuf_puts(sql, "(key)");
+		strbuf_puts(sql, "(key, dat, extra)");
 		rc = sqlite3_exec(dbop->db3, strbuf_value(sql), NULL, NULL, &errmsg);
 		if (rc != SQLITE_OK)
 			die("create index error: %s", errmsg);
@@ -1342,17 +1550,26 @@ dbop3_close(DBOP *dbop) {
 		if (rc != SQLITE_OK)
 			die("create index error: %s", errmsg);
 	}
-	if (dbop->stmt) {
-		rc = sqlite3_finalize(dbop->stmt);
-		if (rc != SQLITE_OK)
-			die("sqlite3_finalize failed. (rc = %d)", rc);
-		dbop->stmt = NULL;
-	}
-	if (dbop->stmt_put3) {
-		rc = sqlite3_finalize(dbop->stmt_put3);
+	dbop3_finalize(&dbop->stmt_all3);
+	dbop3_finalize(&dbop->stmt_key3);
+	dbop3_finalize(&dbop->stmt_range3);
+	dbop3_finalize(&dbop->stmt_from3);
+	dbop3_finalize(&dbop->stmt_get3);
+	dbop3_finalize(&dbop->stmt_put3);
+	dbop3_finalize(&dbop->stmt_delete3);
+	dbop3_finalize(&dbop->stmt_delrow3);
+	dbop3_finalize(&dbop->stmt_update3);
+	rc = sqlite3_exec(dbop->db3, "end transaction", NULL, NULL, &errmsg);
+       	if (rc != SQLITE_OK)
+		die("end transaction error: %s", errmsg);
+	/*
+	 * Return to the rollback journal, so that the tag file can be read
+	 * without the write-ahead log, even from a read-only directory.
+	 */
+	if (dbop->wal) {
+		rc = sqlite3_exec(dbop->db3, "pragma journal_mode=delete", NULL, NULL, &errmsg);
 		if (rc != SQLITE_OK)
-			die("dbop3_finalize failed. (rc = %d)", rc);
-		dbop->stmt_put3 = NULL;
+			die("pragma journal_mode=delete error: %s", errmsg);
 	}
 	rc = sqlite3_close(dbop->db3);
 	if (rc != SQLITE_OK)
@@ -1360,7 +1577,6 @@ dbop3_close(DBOP *dbop) {
 	dbop->db3 = NULL;
 	if (dbop->tblname)
 		free((void *)dbop->tblname);
-	strbuf_close(dbop->sb);
 	free(dbop);
 }
 #endif /* USE_SQLITE3 */
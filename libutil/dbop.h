@@ -31,16 +31,13 @@
 #include <sqlite3.h>
 #endif
 #include "regex.h"
+#include "dfa.h"
 #include "strbuf.h"
 
 #if defined(_WIN32) && !defined(__CYGWIN__)
 typedef void* HANDLE;
 #endif
 
-#define DBOP_PAGESIZE	8192
-#ifdef USE_SQLITE3
-#define DBOP_COMMIT_THRESHOLD	800
-#endif
 #define VERSIONKEY	" __.VERSION"
 
 typedef	struct {
@@ -55,8 +52,11 @@ typedef	struct {
 	char *lastkey;			/**< the key of last located record */
 	int lastkeysize;		/**< the size of the key */
 	regex_t	*preg;			/**< compiled regular expression */
+	regex_t	*dfa_preg;		/**< regular expression equivalent to dfa */
+	DFA *dfa;			/**< lazy DFA used instead of regexec() */
 	int unread;			/**< leave record to read again */
 	const char *put_errmsg;		/**< error message for put_xxx() */
+	int pagesize;			/**< page size of the file */
 
 	/*
 	 * (2) DB185 PART
@@ -83,20 +83,25 @@ typedef	struct {
 	 * (4) sqlite3 part
 	 */
 	sqlite3 *db3;
-	STRBUF *sb;
 	int done;
 	const char *tblname;
-	sqlite3_stmt *stmt;
-	sqlite3_stmt *stmt_put3;
-	sqlite3_int64 lastrowid;
+	sqlite3_stmt *stmt;		/**< current query */
+	sqlite3_stmt *stmt_all3;	/**< query all records */
+	sqlite3_stmt *stmt_key3;	/**< query records by the key */
+	sqlite3_stmt *stmt_range3;	/**< query records by the prefix */
+	sqlite3_stmt *stmt_from3;	/**< query records from the prefix */
+	sqlite3_stmt *stmt_get3;	/**< select a record by the key */
+	sqlite3_stmt *stmt_put3;	/**< insert a record */
+	sqlite3_stmt *stmt_delete3;	/**< delete records by the key */
+	sqlite3_stmt *stmt_delrow3;	/**< delete a record by the rowid */
+	sqlite3_stmt *stmt_update3;	/**< update records by the key */
 	char *lastflag;
+	int rowid;			/**< 1: the table has rowid */
+	int update;			/**< 1: started update */
+	int wal;			/**< 1: using write-ahead log */
 #endif
 	/** statistics */
 	int readcount;
-#ifdef USE_SQLITE3
-	/** for commit */
-	int writecount;
-#endif
 } DBOP;
 
 /*
@@ -112,6 +117,8 @@ typedef	struct {
 #define DBOP_RAW		4
 			/** sorted write */
 #define DBOP_SORTED_WRITE	8
+			/** prefix compressed keys */
+#define DBOP_PFXKEY		16
 
 /*
  * ioflags
@@ -122,12 +129,14 @@ typedef	struct {
 #define DBOP_PREFIX		2
 
 DBOP *dbop_open(const char *, int, int, int);
+int dbop_auto_pagesize(off_t);
 const char *dbop_get(DBOP *, const char *);
 void dbop_put(DBOP *, const char *, const char *);
 void dbop_put_tag(DBOP *, const char *, const char *);
 void dbop_put_path(DBOP *, const char *, const char *, const char *);
 void dbop_delete(DBOP *, const char *);
 void dbop_update(DBOP *, const char *, const char *);
+void dbop_setdfa(DBOP *, regex_t *, DFA *);
 const char *dbop_first(DBOP *, const char *, regex_t *, int);
 const char *dbop_next(DBOP *);
 void dbop_unread(DBOP *);
@@ -137,6 +146,7 @@ const char *dbop_getoption(DBOP *, const char *);
 void dbop_putoption(DBOP *, const char *, const char *);
 int dbop_getversion(DBOP *);
 void dbop_putversion(DBOP *, int);
+int dbop_cachestat(DBOP *, unsigned long *, unsigned long *, unsigned long *);
 void dbop_close(DBOP *);
 
 #endif /* _DBOP_H_ */
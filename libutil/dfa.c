@@ -0,0 +1,947 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <ctype.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+
+#include "checkalloc.h"
+#include "dfa.h"
+#include "varray.h"
+
+/*
+ * Lazy DFA matcher for tag names.
+ *
+ * Dbop_first() and dbop_next() check every key with the regular expression.
+ * Regexec() of the bundled regex library is general but slow for this use:
+ * it prepares matching context for each call and may backtrack.
+ * This matcher answers only 'match or not' for a NUL terminated string,
+ * which is all that the key filter needs.
+ *
+ * The regular expression is parsed into a tree, and compiled into an NFA
+ * (Thompson construction). The DFA is built lazily while matching:
+ * a DFA state is a set of NFA states, and a transition is computed when
+ * it is used for the first time and cached in the transition table.
+ * Bytes which are not distinguished by the expression are put into the
+ * same byte class, so the table has a column for each class, not each byte.
+ *
+ * Supported: POSIX basic and extended syntax with GNU extensions
+ * (\+, \?, \| in basic syntax, \w, \W), bracket expressions
+ * with character classes, intervals and anchors.
+ * Not supported: back references, word boundaries (\b, \B, \<, \>,
+ * \`, \'), collating elements and equivalence classes ([.c.], [=c=]).
+ * Dfa_compile() returns NULL for them; the caller should use regexec()
+ * instead.
+ *
+ * Since GLOBAL doesn't call setlocale(), both regexec() and this matcher
+ * work on bytes in the C locale.
+ */
+#define MAXNFA		10000		/**< max number of NFA states */
+#define MAXREPEAT	255		/**< max number of intervals */
+#define MAXDFA		4096		/**< max number of cached DFA states */
+#define DFAHASH		1024		/**< buckets of DFA state hash */
+
+#define AT_START	1		/**< at the start of string */
+#define AT_END		2		/**< at the end of string */
+
+/*
+ * Parse tree
+ */
+enum { N_SET, N_CAT, N_ALT, N_REPEAT, N_BOL, N_EOL, N_EMPTY };
+struct node {
+	int type;
+	int set;			/**< N_SET: index of byte set */
+	int left, right;		/**< children */
+	int min, max;			/**< N_REPEAT: max < 0 means infinity */
+};
+/*
+ * NFA
+ */
+enum { S_SET, S_SPLIT, S_BOL, S_EOL, S_MATCH };
+struct nstate {
+	int type;
+	int set;			/**< S_SET: index of byte set */
+	int out, out1;			/**< next states */
+};
+/*
+ * DFA
+ */
+struct dstate {
+	int offset;			/**< first NFA state in lists */
+	int count;			/**< number of NFA states */
+	int accept;			/**< includes S_MATCH */
+	int eolaccept;			/**< accepts at the end of string, -1: unknown */
+	int chain;			/**< next state in the hash bucket */
+};
+struct dfa {
+	int flags;
+	VARRAY *nodes;			/**< struct node */
+	VARRAY *sets;			/**< byte sets (32 bytes each) */
+	VARRAY *nfa;			/**< struct nstate */
+	int start;			/**< NFA start state */
+	unsigned char classmap[256];	/**< byte -> byte class */
+	unsigned char classrep[256];	/**< byte class -> representative byte */
+	int nclasses;
+	/*
+	 * lazy DFA
+	 */
+	VARRAY *dstates;		/**< struct dstate */
+	VARRAY *lists;			/**< NFA states of DFA states (int) */
+	int *trans;			/**< transition table */
+	char *accept;			/**< accept flags of DFA states */
+	int transsize;
+	int hash[DFAHASH];
+	int dstart;			/**< DFA start state */
+	/*
+	 * work area
+	 */
+	int *mark;
+	int gen;
+	int *stack;
+	int *work;
+	int nwork;
+};
+
+#define NODE(d, i)	((struct node *)varray_assign((d)->nodes, (i), 0))
+#define NSTATE(d, i)	((struct nstate *)varray_assign((d)->nfa, (i), 0))
+#define SET(d, i)	((unsigned char *)varray_assign((d)->sets, (i), 0))
+#define DSTATE(d, i)	((struct dstate *)varray_assign((d)->dstates, (i), 0))
+#define LIST(d, ds)	((ds)->count ? (int *)varray_assign((d)->lists, (ds)->offset, 0) : NULL)
+#define INSET(s, c)	((s)[(c) >> 3] & (1 << ((c) & 7)))
+#define ADDSET(s, c)	((s)[(c) >> 3] |= (1 << ((c) & 7)))
+
+/*
+ * Parser
+ */
+struct parser {
+	DFA *dfa;
+	const unsigned char *p;		/**< current position */
+	int basic;			/**< basic regular expression */
+	int error;			/**< unsupported or invalid */
+};
+static int parse_regex(struct parser *);
+
+static int
+new_node(DFA *d, int type, int left, int right)
+{
+	struct node *n = varray_append(d->nodes);
+
+	memset(n, 0, sizeof(*n));
+	n->type = type;
+	n->left = left;
+	n->right = right;
+	return d->nodes->length - 1;
+}
+static int
+new_set(DFA *d)
+{
+	unsigned char *s = varray_append(d->sets);
+
+	memset(s, 0, 32);
+	return d->sets->length - 1;
+}
+/**
+ * set_node: make a node which matches a byte in the set.
+ *
+ *	@param[in]	d	DFA
+ *	@param[in]	set	index of byte set
+ *	@param[in]	negate	complement the set
+ */
+static int
+set_node(DFA *d, int set, int negate)
+{
+	unsigned char *s = SET(d, set);
+	int c, n;
+
+	if (d->flags & DFA_ICASE) {
+		for (c = 0; c < 256; c++)
+			if (INSET(s, c)) {
+				if (isupper(c))
+					ADDSET(s, tolower(c));
+				else if (islower(c))
+					ADDSET(s, toupper(c));
+			}
+	}
+	if (negate)
+		for (c = 0; c < 32; c++)
+			s[c] = ~s[c];
+	s[0] &= ~1;			/* NUL never appears in a string */
+	n = new_node(d, N_SET, -1, -1);
+	NODE(d, n)->set = set;
+	return n;
+}
+static int
+char_node(DFA *d, int c)
+{
+	int set = new_set(d);
+
+	ADDSET(SET(d, set), c);
+	return set_node(d, set, 0);
+}
+/**
+ * class_set: add a character class to the set.
+ *
+ *	@return		0: done, -1: unknown class
+ */
+static int
+class_set(unsigned char *s, const char *name, int len)
+{
+	static const struct {
+		const char *name;
+		int (*func)(int);
+	} classes[] = {
+		{"alpha", isalpha}, {"digit", isdigit}, {"alnum", isalnum},
+		{"upper", isupper}, {"lower", islower}, {"space", isspace},
+		{"blank", isblank}, {"punct", ispunct}, {"print", isprint},
+		{"graph", isgraph}, {"cntrl", iscntrl}, {"xdigit", isxdigit},
+		{NULL, NULL}
+	};
+	int i, c;
+
+	for (i = 0; classes[i].name; i++)
+		if ((int)strlen(classes[i].name) == len && !strncmp(classes[i].name, name, len))
+			break;
+	if (classes[i].name == NULL)
+		return -1;
+	for (c = 1; c < 256; c++)
+		if ((*classes[i].func)(c))
+			ADDSET(s, c);
+	return 0;
+}
+/**
+ * parse_bracket: parse a bracket expression. The '[' has been read.
+ */
+static int
+parse_bracket(struct parser *ps)
+{
+	DFA *d = ps->dfa;
+	int set = new_set(d);
+	int negate = 0, first = 1;
+
+	if (*ps->p == '^') {
+		negate = 1;
+		ps->p++;
+	}
+	for (;;) {
+		int lo, hi;
+
+		if (*ps->p == '\0') {
+			ps->error = 1;
+			return -1;
+		}
+		if (*ps->p == ']' && !first) {
+			ps->p++;
+			break;
+		}
+		first = 0;
+		if (ps->p[0] == '[' && (ps->p[1] == ':' || ps->p[1] == '=' || ps->p[1] == '.')) {
+			int term = ps->p[1];
+			const unsigned char *start = ps->p + 2, *q;
+
+			for (q = start; *q && !(q[0] == term && q[1] == ']'); q++)
+				;
+			if (*q == '\0') {
+				ps->error = 1;
+				return -1;
+			}
+			/*
+			 * Regexec() doesn't support [=c=] and [.c.] in the same
+			 * way as POSIX. Leave them to regexec().
+			 */
+			if (term != ':' || class_set(SET(d, set), (const char *)start, q - start) < 0) {
+				ps->error = 1;
+				return -1;
+			}
+			ps->p = q + 2;
+			continue;
+		} else {
+			lo = *ps->p++;
+		}
+		if (ps->p[0] == '-' && ps->p[1] != ']' && ps->p[1] != '\0') {
+			ps->p++;
+			if (ps->p[0] == '[' && (ps->p[1] == '.' || ps->p[1] == '=' || ps->p[1] == ':')) {
+				ps->error = 1;
+				return -1;
+			}
+			hi = *ps->p++;
+			if (hi < lo) {
+				ps->error = 1;
+				return -1;
+			}
+		} else
+			hi = lo;
+		for (; lo <= hi; lo++)
+			ADDSET(SET(d, set), lo);
+	}
+	return set_node(d, set, negate);
+}
+/**
+ * parse_escape: parse an escape sequence. The '\' has been read.
+ */
+static int
+parse_escape(struct parser *ps)
+{
+	DFA *d = ps->dfa;
+	int c = *ps->p++;
+	int set, i;
+
+	switch (c) {
+	case '\0':
+		ps->error = 1;
+		return -1;
+	case 'w':
+	case 'W':
+		set = new_set(d);
+		for (i = 1; i < 256; i++)
+			if (isalnum(i) || i == '_')
+				ADDSET(SET(d, set), i);
+		return set_node(d, set, c == 'W');
+	case 'b': case 'B': case '<': case '>': case '`': case '\'':
+		ps->error = 1;		/* word boundary: not supported */
+		return -1;
+	default:
+		if (isdigit(c)) {
+			ps->error = 1;	/* back reference: not supported */
+			return -1;
+		}
+		return char_node(d, c);
+	}
+}
+/*
+ * Tokens which depend on the syntax.
+ */
+#define IS_ALT(ps)	((ps)->basic ? ((ps)->p[0] == '\\' && (ps)->p[1] == '|') : (ps)->p[0] == '|')
+#define IS_OPEN(ps)	((ps)->basic ? ((ps)->p[0] == '\\' && (ps)->p[1] == '(') : (ps)->p[0] == '(')
+#define IS_CLOSE(ps)	((ps)->basic ? ((ps)->p[0] == '\\' && (ps)->p[1] == ')') : (ps)->p[0] == ')')
+#define TOKLEN(ps)	((ps)->basic ? 2 : 1)
+
+/**
+ * parse_interval: parse {m,n}. The '{' (or '\{') has been read.
+ */
+static int
+parse_interval(struct parser *ps, int *min, int *max)
+{
+	if (!isdigit(*ps->p)) {
+		ps->error = 1;
+		return -1;
+	}
+	*min = 0;
+	while (isdigit(*ps->p))
+		*min = *min * 10 + (*ps->p++ - '0');
+	if (*ps->p == ',') {
+		ps->p++;
+		if (isdigit(*ps->p)) {
+			*max = 0;
+			while (isdigit(*ps->p))
+				*max = *max * 10 + (*ps->p++ - '0');
+		} else
+			*max = -1;
+	} else
+		*max = *min;
+	if (ps->basic) {
+		if (ps->p[0] != '\\' || ps->p[1] != '}') {
+			ps->error = 1;
+			return -1;
+		}
+		ps->p += 2;
+	} else {
+		if (*ps->p != '}') {
+			ps->error = 1;
+			return -1;
+		}
+		ps->p++;
+	}
+	if (*min > MAXREPEAT || *max > MAXREPEAT || (*max >= 0 && *max < *min)) {
+		ps->error = 1;
+		return -1;
+	}
+	return 0;
+}
+/**
+ * parse_branch: parse a sequence of pieces.
+ */
+static int
+parse_branch(struct parser *ps)
+{
+	DFA *d = ps->dfa;
+	int result = new_node(d, N_EMPTY, -1, -1);
+	int atstart = 1;
+
+	while (*ps->p && !IS_ALT(ps) && !IS_CLOSE(ps)) {
+		int atom = -1, c = *ps->p;
+		int quantified, interval;
+
+		/*
+		 * atom
+		 */
+		if (IS_OPEN(ps)) {
+			ps->p += TOKLEN(ps);
+			atom = parse_regex(ps);
+			if (ps->error)
+				return -1;
+			if (!IS_CLOSE(ps)) {
+				ps->error = 1;
+				return -1;
+			}
+			ps->p += TOKLEN(ps);
+		} else if (c == '^' && (!ps->basic || atstart)) {
+			ps->p++;
+			atom = new_node(d, N_BOL, -1, -1);
+			if (ps->basic) {
+				/* '*' just after the anchor is a literal */
+				result = new_node(d, N_CAT, result, atom);
+				if (*ps->p == '*') {
+					ps->p++;
+					result = new_node(d, N_CAT, result, char_node(d, '*'));
+				}
+				atstart = 0;
+				continue;
+			}
+		} else if (c == '$' && (!ps->basic || ps->p[1] == '\0'
+				|| (ps->p[1] == '\\' && (ps->p[2] == ')' || ps->p[2] == '|')))) {
+			ps->p++;
+			atom = new_node(d, N_EOL, -1, -1);
+		} else if (c == '[') {
+			ps->p++;
+			atom = parse_bracket(ps);
+		} else if (c == '.') {
+			int set = new_set(d);
+
+			ps->p++;
+			atom = set_node(d, set, 1);
+		} else if (c == '\\') {
+			ps->p++;
+			if (ps->basic && (*ps->p == '{' || *ps->p == '}' || *ps->p == '+' || *ps->p == '?')) {
+				ps->error = 1;	/* operator without operand */
+				return -1;
+			}
+			atom = parse_escape(ps);
+		} else if (c == '*' && ps->basic && atstart) {
+			ps->p++;
+			atom = char_node(d, '*');
+		} else if (!ps->basic && (c == '*' || c == '+' || c == '?' || c == '{')) {
+			ps->error = 1;		/* operator without operand */
+			return -1;
+		} else {
+			ps->p++;
+			atom = char_node(d, c);
+		}
+		if (ps->error)
+			return -1;
+		atstart = 0;
+		/*
+		 * quantifiers
+		 */
+		for (quantified = interval = 0;; quantified = 1) {
+			int min, max, brace = 0;
+
+			if (*ps->p == '*') {
+				ps->p++;
+				min = 0, max = -1;
+			} else if (!ps->basic && *ps->p == '+') {
+				ps->p++;
+				min = 1, max = -1;
+			} else if (!ps->basic && *ps->p == '?') {
+				ps->p++;
+				min = 0, max = 1;
+			} else if (ps->basic && ps->p[0] == '\\' && ps->p[1] == '+') {
+				ps->p += 2;
+				min = 1, max = -1;
+			} else if (ps->basic && ps->p[0] == '\\' && ps->p[1] == '?') {
+				ps->p += 2;
+				min = 0, max = 1;
+			} else if (!ps->basic && *ps->p == '{') {
+				ps->p++;
+				if (parse_interval(ps, &min, &max) < 0)
+					return -1;
+				brace = 1;
+			} else if (ps->basic && ps->p[0] == '\\' && ps->p[1] == '{') {
+				ps->p += 2;
+				if (parse_interval(ps, &min, &max) < 0)
+					return -1;
+				brace = 1;
+			} else
+				break;
+			/*
+			 * Regexec() doesn't treat an interval combined with
+			 * another quantifier (e.g. 'a{1,2}+') as POSIX says.
+			 */
+			if (quantified && (brace || interval)) {
+				ps->error = 1;
+				return -1;
+			}
+			interval = brace;
+			if (NODE(d, atom)->type == N_BOL || NODE(d, atom)->type == N_EOL) {
+				ps->error = 1;
+				return -1;
+			}
+			atom = new_node(d, N_REPEAT, atom, -1);
+			NODE(d, atom)->min = min;
+			NODE(d, atom)->max = max;
+		}
+		result = new_node(d, N_CAT, result, atom);
+	}
+	return result;
+}
+/**
+ * parse_regex: parse alternatives.
+ */
+static int
+parse_regex(struct parser *ps)
+{
+	int result = parse_branch(ps);
+
+	while (!ps->error && IS_ALT(ps)) {
+		int right;
+
+		ps->p += TOKLEN(ps);
+		right = parse_branch(ps);
+		if (ps->error)
+			return -1;
+		result = new_node(ps->dfa, N_ALT, result, right);
+	}
+	return result;
+}
+
+/*
+ * NFA
+ */
+static int
+new_nstate(DFA *d, int type, int out, int out1)
+{
+	struct nstate *s;
+
+	if (d->nfa->length >= MAXNFA)
+		return -1;
+	s = varray_append(d->nfa);
+	s->type = type;
+	s->set = -1;
+	s->out = out;
+	s->out1 = out1;
+	return d->nfa->length - 1;
+}
+/**
+ * compile: compile a parse tree into NFA.
+ *
+ *	@param[in]	d	DFA
+ *	@param[in]	node	parse tree
+ *	@param[in]	next	state which follows the node
+ *	@return		start state of the node, -1: too large
+ */
+static int
+compile(DFA *d, int node, int next)
+{
+	struct node n = *NODE(d, node);
+	int s, a, b, i;
+
+	if (next < 0)
+		return -1;
+	switch (n.type) {
+	case N_EMPTY:
+		return next;
+	case N_SET:
+		if ((s = new_nstate(d, S_SET, next, -1)) >= 0)
+			NSTATE(d, s)->set = n.set;
+		return s;
+	case N_BOL:
+		return new_nstate(d, S_BOL, next, -1);
+	case N_EOL:
+		return new_nstate(d, S_EOL, next, -1);
+	case N_CAT:
+		return compile(d, n.left, compile(d, n.right, next));
+	case N_ALT:
+		a = compile(d, n.left, next);
+		b = compile(d, n.right, next);
+		if (a < 0 || b < 0)
+			return -1;
+		return new_nstate(d, S_SPLIT, a, b);
+	case N_REPEAT:
+		s = next;
+		if (n.max < 0) {
+			/* loop: split -> body -> split */
+			int loop = new_nstate(d, S_SPLIT, -1, next);
+
+			if (loop < 0 || (a = compile(d, n.left, loop)) < 0)
+				return -1;
+			NSTATE(d, loop)->out = a;
+			s = loop;
+		} else {
+			for (i = n.min; i < n.max; i++) {
+				if ((a = compile(d, n.left, s)) < 0)
+					return -1;
+				if ((s = new_nstate(d, S_SPLIT, a, s)) < 0)
+					return -1;
+			}
+		}
+		for (i = 0; i < n.min; i++)
+			if ((s = compile(d, n.left, s)) < 0)
+				return -1;
+		return s;
+	}
+	return -1;
+}
+/**
+ * make_classes: divide bytes into classes which no set distinguishes.
+ */
+static void
+make_classes(DFA *d)
+{
+	int map[512];
+	int i, c;
+
+	memset(d->classmap, 0, sizeof(d->classmap));
+	d->nclasses = 1;
+	for (i = 0; i < d->sets->length; i++) {
+		const unsigned char *s = SET(d, i);
+		int n = 0;
+
+		for (c = 0; c < 2 * d->nclasses; c++)
+			map[c] = -1;
+		for (c = 0; c < 256; c++) {
+			int key = d->classmap[c] * 2 + (INSET(s, c) ? 1 : 0);
+
+			if (map[key] < 0)
+				map[key] = n++;
+			d->classmap[c] = map[key];
+		}
+		d->nclasses = n;
+	}
+	for (c = 255; c >= 0; c--)
+		d->classrep[d->classmap[c]] = c;
+}
+
+/*
+ * Lazy DFA
+ */
+/**
+ * closure: add a state and the states reachable by empty transitions.
+ *
+ *	@param[in]	d	DFA
+ *	@param[in]	s	NFA state
+ *	@param[in]	context	AT_START, AT_END
+ *
+ * The states which consume a byte, S_MATCH and pending S_EOL are
+ * appended to the work list.
+ */
+static void
+closure(DFA *d, int s, int context)
+{
+	int sp = 0;
+
+	d->stack[sp++] = s;
+	while (sp > 0) {
+		struct nstate *n;
+
+		s = d->stack[--sp];
+		if (d->mark[s] == d->gen)
+			continue;
+		d->mark[s] = d->gen;
+		n = NSTATE(d, s);
+		switch (n->type) {
+		case S_SPLIT:
+			d->stack[sp++] = n->out1;
+			d->stack[sp++] = n->out;
+			break;
+		case S_BOL:
+			if (context & AT_START)
+				d->stack[sp++] = n->out;
+			break;
+		case S_EOL:
+			if (context & AT_END)
+				d->stack[sp++] = n->out;
+			else
+				d->work[d->nwork++] = s;
+			break;
+		default:
+			d->work[d->nwork++] = s;
+			break;
+		}
+	}
+}
+static int
+cmp_int(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+/**
+ * flush_cache: forget all DFA states.
+ */
+static void
+flush_cache(DFA *d)
+{
+	int i;
+
+	varray_reset(d->dstates);
+	varray_reset(d->lists);
+	for (i = 0; i < DFAHASH; i++)
+		d->hash[i] = -1;
+	d->dstart = -1;
+}
+/**
+ * lookup_state: get the DFA state for the work list.
+ *
+ *	@return		DFA state
+ */
+static int
+lookup_state(DFA *d)
+{
+	unsigned int h = 2166136261U;
+	struct dstate *ds;
+	int i, id;
+
+	qsort(d->work, d->nwork, sizeof(int), cmp_int);
+	for (i = 0; i < d->nwork; i++)
+		h = (h ^ d->work[i]) * 16777619U;
+	h %= DFAHASH;
+	for (id = d->hash[h]; id >= 0; id = ds->chain) {
+		ds = DSTATE(d, id);
+		if (ds->count != d->nwork)
+			continue;
+		if (d->nwork == 0 || !memcmp(varray_assign(d->lists, ds->offset, 0), d->work, sizeof(int) * d->nwork))
+			return id;
+	}
+	/*
+	 * New state.
+	 */
+	id = d->dstates->length;
+	if (id >= d->transsize) {
+		d->transsize = d->transsize ? d->transsize * 2 : 64;
+		d->trans = (int *)check_realloc(d->trans, sizeof(int) * d->transsize * d->nclasses);
+		d->accept = (char *)check_realloc(d->accept, d->transsize);
+	}
+	for (i = 0; i < d->nclasses; i++)
+		d->trans[id * d->nclasses + i] = -1;
+	ds = varray_append(d->dstates);
+	ds->offset = d->lists->length;
+	ds->count = d->nwork;
+	ds->accept = 0;
+	ds->eolaccept = -1;
+	ds->chain = d->hash[h];
+	d->hash[h] = id;
+	for (i = 0; i < d->nwork; i++) {
+		*(int *)varray_append(d->lists) = d->work[i];
+		if (NSTATE(d, d->work[i])->type == S_MATCH)
+			ds->accept = 1;
+	}
+	d->accept[id] = ds->accept;
+	return id;
+}
+/**
+ * start_state: get the DFA state at the start of string.
+ */
+static int
+start_state(DFA *d)
+{
+	if (d->dstart < 0) {
+		d->gen++;
+		d->nwork = 0;
+		closure(d, d->start, AT_START);
+		d->dstart = lookup_state(d);
+	}
+	return d->dstart;
+}
+/**
+ * transition: compute the transition from a state by a byte class.
+ *
+ *	@param[in]	d	DFA
+ *	@param[in]	id	DFA state
+ *	@param[in]	class	byte class
+ *	@return		next DFA state
+ */
+static int
+transition(DFA *d, int id, int class)
+{
+	struct dstate *ds = DSTATE(d, id);
+	int c = d->classrep[class];
+	int *list = LIST(d, ds);
+	int count = ds->count;
+	int i, next;
+
+	d->gen++;
+	d->nwork = 0;
+	for (i = 0; i < count; i++) {
+		struct nstate *n = NSTATE(d, list[i]);
+
+		if (n->type == S_SET && INSET(SET(d, n->set), c))
+			closure(d, n->out, 0);
+	}
+	/* The match may start at any position. */
+	closure(d, d->start, 0);
+	if (d->dstates->length >= MAXDFA) {
+		flush_cache(d);
+		return lookup_state(d);
+	}
+	next = lookup_state(d);
+	d->trans[id * d->nclasses + class] = next;
+	return next;
+}
+/**
+ * eol_accept: whether the state accepts at the end of string.
+ */
+static int
+eol_accept(DFA *d, int id, int context)
+{
+	struct dstate *ds = DSTATE(d, id);
+	int *list = LIST(d, ds);
+	int i, result = 0;
+
+	d->gen++;
+	d->nwork = 0;
+	for (i = 0; i < ds->count; i++)
+		if (NSTATE(d, list[i])->type == S_EOL)
+			closure(d, NSTATE(d, list[i])->out, context);
+	for (i = 0; i < d->nwork; i++)
+		if (NSTATE(d, d->work[i])->type == S_MATCH)
+			result = 1;
+	return result;
+}
+/**
+ * dfa_compile: compile a regular expression.
+ *
+ *	@param[in]	pattern	regular expression
+ *	@param[in]	flags	DFA_BASIC: basic regular expression,
+ *				DFA_ICASE: ignore case distinctions
+ *	@return		DFA or NULL (not supported)
+ *
+ * The pattern should have been accepted by regcomp(). NULL is returned
+ * for the features this matcher doesn't support.
+ */
+DFA *
+dfa_compile(const char *pattern, int flags)
+{
+	DFA *d = (DFA *)check_calloc(sizeof(DFA), 1);
+	struct parser ps;
+	int tree, match, i;
+
+	d->flags = flags;
+	d->nodes = varray_open(sizeof(struct node), 64);
+	d->sets = varray_open(32, 16);
+	d->nfa = varray_open(sizeof(struct nstate), 128);
+	d->dstates = varray_open(sizeof(struct dstate), 64);
+	d->lists = varray_open(sizeof(int), 256);
+	ps.dfa = d;
+	ps.p = (const unsigned char *)pattern;
+	ps.basic = (flags & DFA_BASIC) ? 1 : 0;
+	ps.error = 0;
+	tree = parse_regex(&ps);
+	if (ps.error || *ps.p != '\0') {
+		dfa_free(d);
+		return NULL;
+	}
+	match = new_nstate(d, S_MATCH, -1, -1);
+	d->start = compile(d, tree, match);
+	if (d->start < 0) {
+		dfa_free(d);
+		return NULL;
+	}
+	varray_close(d->nodes);
+	d->nodes = NULL;
+	make_classes(d);
+	d->mark = (int *)check_malloc(sizeof(int) * d->nfa->length);
+	for (i = 0; i < d->nfa->length; i++)
+		d->mark[i] = 0;
+	d->stack = (int *)check_malloc(sizeof(int) * d->nfa->length * 2);
+	d->work = (int *)check_malloc(sizeof(int) * d->nfa->length);
+	flush_cache(d);
+	return d;
+}
+/**
+ * dfa_nmatch: whether the string includes a match.
+ *
+ *	@param[in]	d	DFA
+ *	@param[in]	string	string
+ *	@param[in]	len	length of the string
+ *	@return		1: match, 0: not match
+ *
+ * A NUL character terminates the string even if it is within 'len' bytes.
+ */
+int
+dfa_nmatch(DFA *d, const char *string, size_t len)
+{
+	const unsigned char *p = (const unsigned char *)string;
+	const unsigned char *end = p + len;
+	int id = start_state(d);
+	struct dstate *ds;
+
+	if (d->accept[id])
+		return 1;
+	if (p == end || *p == '\0')
+		return eol_accept(d, id, AT_START|AT_END);
+	for (; p < end && *p; p++) {
+		int class = d->classmap[*p];
+		int next = d->trans[id * d->nclasses + class];
+
+		if (next < 0)
+			next = transition(d, id, class);
+		id = next;
+		if (d->accept[id])
+			return 1;
+	}
+	ds = DSTATE(d, id);
+	if (ds->eolaccept < 0)
+		ds->eolaccept = eol_accept(d, id, AT_END);
+	return ds->eolaccept;
+}
+/**
+ * dfa_match: whether the string includes a match.
+ *
+ *	@param[in]	d	DFA
+ *	@param[in]	string	string
+ *	@return		1: match, 0: not match
+ */
+int
+dfa_match(DFA *d, const char *string)
+{
+	return dfa_nmatch(d, string, strlen(string));
+}
+/**
+ * dfa_free: free DFA.
+ *
+ *	@param[in]	d	DFA
+ */
+void
+dfa_free(DFA *d)
+{
+	if (d->nodes)
+		varray_close(d->nodes);
+	varray_close(d->sets);
+	varray_close(d->nfa);
+	varray_close(d->dstates);
+	varray_close(d->lists);
+	if (d->trans)
+		free(d->trans);
+	if (d->accept)
+		free(d->accept);
+	if (d->mark)
+		free(d->mark);
+	if (d->stack)
+		free(d->stack);
+	if (d->work)
+		free(d->work);
+	free(d);
+}
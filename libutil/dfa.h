@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _DFA_H_
+#define _DFA_H_
+
+#include <sys/types.h>
+
+/* flags for dfa_compile() */
+#define DFA_BASIC	1		/**< basic regular expression */
+#define DFA_ICASE	2		/**< ignore case distinctions */
+
+typedef struct dfa DFA;
+
+DFA *dfa_compile(const char *, int);
+int dfa_match(DFA *, const char *);
+int dfa_nmatch(DFA *, const char *, size_t);
+void dfa_free(DFA *);
+
+#endif /* ! _DFA_H_ */
@@ -112,6 +112,8 @@ static const char *envname[] = {
 	/*"GTAGSROOT",*/
 	"GTAGSOBJDIR",
 	"GTAGSOBJDIRPREFIX",
+	"GTAGSPAGESIZE",
+	"GTAGSSORTSIZE",
 	"GTAGSTHROUGH",
 	"GTAGS_OPTIONS",
 	"HTAGS_OPTIONS",
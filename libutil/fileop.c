@@ -40,6 +40,10 @@
 #else
 #include <sys/file.h>
 #endif
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+#include <zlib.h>
+#define USE_ZLIB 1
+#endif
 
 #include "checkalloc.h"
 #include "die.h"
@@ -53,6 +57,9 @@
 #define mkdir(path,mode) mkdir(path)
 #endif
 
+static int update_only;
+static int compress_level = -1;		/**< -1: default level of gzip */
+
 /*
 
 File operation: usage
@@ -67,6 +74,22 @@ File operation: usage
 	...
 	close_file(fileop);
 
+	If zlib is available, compressed output is made in process:
+	the stream is deflated into the target as it is written.
+	Without fopencookie(3) or funopen(3), the output is buffered
+	in a temporary file and compressed by close_file() instead.
+	Without zlib, gzip(1) is used.
+
+ [COMPRESS LEVEL]
+	set_compress_level(9);
+
+ [UPDATE]
+	set_update_only(1);
+
+	Afterwards, open_output_file() writes to a temporary file, and
+	close_file() replaces the target only when the contents differ.
+	Unchanged pages keep their time stamp.
+
  [READ]
 	FILEOP *fileop = open_input_file(path);
 	FILE *ip = get_descripter(fileop);
@@ -75,6 +98,62 @@ File operation: usage
 	...
 	close_file(fileop);
 */
+/**
+ * set_update_only: keep output files whose contents are unchanged.
+ *
+ *	@param[in]	onoff	0: always rewrite, 1: rewrite only when changed
+ *
+ * Compressed output is always rewritten.
+ */
+void
+set_update_only(int onoff)
+{
+	update_only = onoff;
+}
+/**
+ * set_compress_level: set the compression level of compressed output.
+ *
+ *	@param[in]	level	0 (no compression) - 9 (best compression),
+ *			-1: default level
+ */
+void
+set_compress_level(int level)
+{
+	if (level < -1 || level > 9)
+		die("invalid compression level '%d'.", level);
+	compress_level = level;
+}
+/**
+ * is_same_file: compare the contents of two files.
+ *
+ *	@param[in]	path1	path name
+ *	@param[in]	path2	path name
+ *	@return		1: same, 0: different or not exist
+ */
+static int
+is_same_file(const char *path1, const char *path2)
+{
+	char buf1[8192], buf2[8192];
+	FILE *fp1, *fp2;
+	size_t n1, n2;
+	int same = 1;
+
+	if ((fp1 = fopen(path1, "rb")) == NULL)
+		return 0;
+	if ((fp2 = fopen(path2, "rb")) == NULL) {
+		fclose(fp1);
+		return 0;
+	}
+	do {
+		n1 = fread(buf1, 1, sizeof(buf1), fp1);
+		n2 = fread(buf2, 1, sizeof(buf2), fp2);
+		if (n1 != n2 || memcmp(buf1, buf2, n1))
+			same = 0;
+	} while (same && n1 > 0);
+	fclose(fp1);
+	fclose(fp2);
+	return same;
+}
 /**
  * open input file.
  *
@@ -95,6 +174,100 @@ open_input_file(const char *path)
 	fileop->type = FILEOP_INPUT;
 	return fileop;
 }
+#ifdef USE_ZLIB
+/**
+ * open_gzip: open a gzip file for writing.
+ *
+ *	@param[in]	path	output file
+ *	@return		gzip file
+ */
+static gzFile
+open_gzip(const char *path)
+{
+	char mode[4] = "wb";
+	gzFile gz;
+
+	/* set_compress_level() assures a single digit */
+	if (compress_level >= 0) {
+		mode[2] = '0' + compress_level;
+		mode[3] = '\0';
+	}
+	if ((gz = gzopen(path, mode)) == NULL)
+		die("cannot create file '%s'.", path);
+	return gz;
+}
+#if defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN)
+#define USE_GZSTREAM 1
+/*
+ * Stream which deflates the written data into a gzip file.
+ */
+#ifdef HAVE_FOPENCOOKIE
+static ssize_t
+gzstream_write(void *cookie, const char *buf, size_t size)
+{
+	return size > 0 ? gzwrite((gzFile)cookie, buf, (unsigned)size) : 0;
+}
+#else
+static int
+gzstream_write(void *cookie, const char *buf, int size)
+{
+	return size > 0 && gzwrite((gzFile)cookie, buf, (unsigned)size) == 0 ? -1 : size;
+}
+#endif
+static int
+gzstream_close(void *cookie)
+{
+	return gzclose((gzFile)cookie) == Z_OK ? 0 : -1;
+}
+/**
+ * open_gzstream: open a stream which writes a gzip file.
+ *
+ *	@param[in]	path	output file
+ *	@return		stream
+ */
+static FILE *
+open_gzstream(const char *path)
+{
+	gzFile gz = open_gzip(path);
+	FILE *fp;
+#ifdef HAVE_FOPENCOOKIE
+	cookie_io_functions_t io = { NULL, gzstream_write, NULL, gzstream_close };
+
+	fp = fopencookie(gz, "w", io);
+#else
+	fp = funopen(gz, NULL, gzstream_write, NULL, gzstream_close);
+#endif
+	if (fp == NULL)
+		die("cannot create file '%s'.", path);
+	return fp;
+}
+#else
+/**
+ * deflate_file: compress the contents of a stream into a gzip file.
+ *
+ *	@param[in]	fp	input stream (read from the beginning)
+ *	@param[in]	path	output file
+ */
+static void
+deflate_file(FILE *fp, const char *path)
+{
+	char buf[8192];
+	gzFile gz;
+	size_t n;
+
+	if (fflush(fp) != 0 || fseek(fp, 0L, SEEK_SET) != 0)
+		die("cannot read temporary file for '%s'.", path);
+	gz = open_gzip(path);
+	while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+		if (gzwrite(gz, buf, (unsigned)n) != (int)n)
+			die("cannot write to '%s'.", path);
+	if (ferror(fp))
+		die("cannot read temporary file for '%s'.", path);
+	if (gzclose(gz) != Z_OK)
+		die("cannot close '%s'.", path);
+}
+#endif /* USE_GZSTREAM */
+#endif /* USE_ZLIB */
 /**
  * open output file
  *
@@ -102,7 +275,9 @@ open_input_file(const char *path)
  *	@param[in]	compress 0: normal, 1: compress
  *	@return		file descripter
  *
- *	[Note] Uses the gzip program to compress, which should already be on your system.
+ *	[Note] Uses zlib to compress. Without zlib, uses the gzip program,
+ *	       which should already be on your system.
+ *	[Note] In update only mode, an existing file is written via '<path>.new'.
  */
 FILEOP *
 open_output_file(const char *path, int compress)
@@ -110,12 +285,30 @@ open_output_file(const char *path, int compress)
 	FILEOP *fileop;
 	FILE *fp;
 	char command[MAXFILLEN];
+	char tmppath[MAXPATHLEN];
 
+	command[0] = tmppath[0] = '\0';
 	if (compress) {
-		snprintf(command, sizeof(command), "gzip -c >\"%s\"", path);
+#if defined(USE_GZSTREAM)
+		fp = open_gzstream(path);
+#elif defined(USE_ZLIB)
+		fp = tmpfile();
+		if (fp == NULL)
+			die("cannot create temporary file for '%s'.", path);
+#else
+		if (compress_level >= 0)
+			snprintf(command, sizeof(command), "gzip -%d -c >\"%s\"", compress_level, path);
+		else
+			snprintf(command, sizeof(command), "gzip -c >\"%s\"", path);
 		fp = popen(command, "w");
 		if (fp == NULL)
 			die("cannot execute '%s'.", command);
+#endif
+	} else if (update_only && test("f", path)) {
+		snprintf(tmppath, sizeof(tmppath), "%s.new", path);
+		fp = fopen(tmppath, "w");
+		if (fp == NULL)
+			die("cannot create file '%s'.", tmppath);
 	} else {
 		fp = fopen(path, "w");
 		if (fp == NULL)
@@ -128,6 +321,10 @@ open_output_file(const char *path, int compress)
 	fileop->type = FILEOP_OUTPUT;
 	if (compress)
 		fileop->type |= FILEOP_COMPRESS;
+	else if (tmppath[0]) {
+		strlimcpy(fileop->tmppath, tmppath, sizeof(fileop->tmppath));
+		fileop->type |= FILEOP_UPDATE;
+	}
 	fileop->fp = fp;
 	return fileop;
 }
@@ -150,10 +347,29 @@ void
 close_file(FILEOP *fileop)
 {
 	if (fileop->type & FILEOP_COMPRESS) {
+#if defined(USE_GZSTREAM)
+		if (fclose(fileop->fp) != 0)
+			die("cannot write to '%s'.", fileop->path);
+#elif defined(USE_ZLIB)
+		deflate_file(fileop->fp, fileop->path);
+		fclose(fileop->fp);
+#else
 		if (pclose(fileop->fp) != 0)
 			die("terminated abnormally. '%s'", fileop->command);
+#endif
 	} else
 		fclose(fileop->fp);
+	if (fileop->type & FILEOP_UPDATE) {
+		if (is_same_file(fileop->tmppath, fileop->path)) {
+			(void)unlink(fileop->tmppath);
+		} else {
+#if defined(_WIN32) && !defined(__CYGWIN__)
+			(void)unlink(fileop->path);
+#endif
+			if (rename(fileop->tmppath, fileop->path) < 0)
+				die("cannot rename '%s' to '%s'.", fileop->tmppath, fileop->path);
+		}
+	}
 	free(fileop);
 }
 
@@ -31,14 +31,19 @@
 #define FILEOP_INPUT	1
 #define FILEOP_OUTPUT	2
 #define FILEOP_COMPRESS	4
+#define FILEOP_UPDATE	8
 
 typedef struct {
 	int type;
 	FILE *fp;
 	char command[MAXFILLEN];
 	char path[MAXPATHLEN];
+	char tmppath[MAXPATHLEN];
 } FILEOP;
 
+void set_update_only(int);
+void set_compress_level(int);
+
 FILEOP *open_input_file(const char *);
 FILEOP *open_output_file(const char *, int);
 FILE *get_descripter(FILEOP *);
@@ -989,9 +989,17 @@ find_close(void)
 	}
 	if (rootdir)
 		free(rootdir);
-	if (suff)
+	/*
+	 * The regular expressions are compiled again if find_open() is
+	 * called again.
+	 */
+	if (suff) {
 		regfree(suff);
-	if (skip)
+		suff = NULL;
+	}
+	if (skip) {
 		regfree(skip);
+		skip = NULL;
+	}
 	find_eof = find_mode = 0;
 }
@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <ctype.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+
+#include "checkalloc.h"
+#include "die.h"
+#include "dbop.h"
+#include "gincludeop.h"
+#include "gtagsop.h"
+#include "locatestring.h"
+#include "makepath.h"
+#include "strbuf.h"
+#include "strlimcpy.h"
+#include "test.h"
+
+/*
+ * GINCLUDE: include graph
+ *
+ * Gtags(1) records the include directives which the parsers met while
+ * extracting tags. Htags(1) and global(1) read them without grepping
+ * the source files.
+ *
+ *      key             data
+ *      ----------------------------------------------
+ *      stdio.h\0       11 3 #include <stdio.h>\0
+ *
+ * The key is the last name of the included file. The data consists of
+ * the file id of the including file, the line number and the line image.
+ * Records with the same key are duplicated.
+ */
+static int create_version = 1;	/**< format version of newly created file */
+
+/**
+ * include_lastname: get the last name of an included file.
+ *
+ *	@param[in]	name	file name written in the directive
+ *	@return		last name
+ */
+const char *
+include_lastname(const char *name)
+{
+	const char *p = locatestring(name, "/", MATCH_LAST);
+
+	return p ? p + 1 : name;
+}
+/**
+ * ginclude_open: open GINCLUDE.
+ *
+ *	@param[in]	dbpath	dbpath directory
+ *	@param[in]	mode	GTAGS_READ: read only, GTAGS_CREATE: create,
+ *				GTAGS_MODIFY: modify
+ *	@return		descripter or NULL (GINCLUDE not found)
+ *
+ * GINCLUDE doesn't exist in the tag files made by older gtags(1).
+ * The caller should fall back to the old method for NULL.
+ */
+GINCLUDE *
+ginclude_open(const char *dbpath, int mode)
+{
+	const char *path = makepath(dbpath, GINCLUDE_NAME, NULL);
+	GINCLUDE *ginc;
+	DBOP *dbop;
+
+	if (mode != GTAGS_CREATE && !test("f", path))
+		return NULL;
+	dbop = dbop_open(path, mode, 0644, DBOP_DUP);
+	if (dbop == NULL) {
+		if (mode == GTAGS_CREATE)
+			die("cannot make %s.", GINCLUDE_NAME);
+		return NULL;
+	}
+	if (mode == GTAGS_CREATE)
+		dbop_putversion(dbop, create_version);
+	else if (dbop_getversion(dbop) > create_version)
+		die("%s seems new format. Please install the latest GLOBAL.", GINCLUDE_NAME);
+	ginc = (GINCLUDE *)check_calloc(sizeof(GINCLUDE), 1);
+	ginc->dbop = dbop;
+	ginc->mode = mode;
+	return ginc;
+}
+/**
+ * ginclude_put: record an include directive.
+ *
+ *	@param[in]	ginc	descripter
+ *	@param[in]	name	file name written in the directive
+ *	@param[in]	lineno	line number
+ *	@param[in]	fid	file id of the including file
+ *	@param[in]	image	line image
+ */
+void
+ginclude_put(GINCLUDE *ginc, const char *name, int lineno, const char *fid, const char *image)
+{
+	STATIC_STRBUF(sb);
+	const char *last = include_lastname(name);
+
+	if (*last == '\0')
+		return;
+	strbuf_clear(sb);
+	strbuf_puts(sb, fid);
+	strbuf_putc(sb, ' ');
+	strbuf_putn(sb, lineno);
+	strbuf_putc(sb, ' ');
+	strbuf_puts(sb, image);
+	dbop_put(ginc->dbop, last, strbuf_value(sb));
+}
+/**
+ * ginclude_delete: delete the records of the specified files.
+ *
+ *	@param[in]	ginc	descripter
+ *	@param[in]	deleteset	bit array of fid
+ */
+void
+ginclude_delete(GINCLUDE *ginc, IDSET *deleteset)
+{
+	const char *dat;
+
+	for (dat = dbop_first(ginc->dbop, NULL, NULL, 0); dat; dat = dbop_next(ginc->dbop))
+		if (idset_contains(deleteset, atoi(dat)))
+			dbop_delete(ginc->dbop, NULL);
+}
+/**
+ * unpack: unpack the current record.
+ */
+static GINCREC *
+unpack(GINCLUDE *ginc, const char *dat)
+{
+	GINCREC *rec = &ginc->rec;
+	char *q = rec->fid;
+	const char *p = dat;
+
+	if (dat == NULL)
+		return NULL;
+	while (*p && *p != ' ' && q < rec->fid + sizeof(rec->fid) - 1)
+		*q++ = *p++;
+	*q = '\0';
+	if (*p++ != ' ' || !isdigit((unsigned char)*p))
+		die("%s is corrupted.", GINCLUDE_NAME);
+	rec->lineno = atoi(p);
+	while (*p && *p != ' ')
+		p++;
+	if (*p == ' ')
+		p++;
+	rec->name = ginc->dbop->lastkey;
+	rec->image = p;
+	return rec;
+}
+/**
+ * ginclude_first: get the first record.
+ *
+ *	@param[in]	ginc	descripter
+ *	@param[in]	name	last name of the included file or NULL (all records)
+ *	@return		record or NULL (end of records)
+ */
+GINCREC *
+ginclude_first(GINCLUDE *ginc, const char *name)
+{
+	return unpack(ginc, dbop_first(ginc->dbop, name, NULL, 0));
+}
+/**
+ * ginclude_next: get the next record.
+ *
+ *	@param[in]	ginc	descripter
+ *	@return		record or NULL (end of records)
+ */
+GINCREC *
+ginclude_next(GINCLUDE *ginc)
+{
+	return unpack(ginc, dbop_next(ginc->dbop));
+}
+/**
+ * ginclude_close: close GINCLUDE.
+ *
+ *	@param[in]	ginc	descripter
+ */
+void
+ginclude_close(GINCLUDE *ginc)
+{
+	dbop_close(ginc->dbop);
+	free(ginc);
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GINCLUDEOP_H_
+#define _GINCLUDEOP_H_
+
+#include "gparam.h"
+#include "dbop.h"
+#include "idset.h"
+
+#define GINCLUDE_NAME	"GINCLUDE"
+
+/*
+ * An include edge: the file 'fid' includes 'name' at line 'lineno'.
+ */
+typedef struct {
+	const char *name;		/**< last name of the included file */
+	char fid[MAXFIDLEN];		/**< file id of the including file */
+	int lineno;			/**< line number of the directive */
+	const char *image;		/**< line image of the directive */
+} GINCREC;
+
+typedef struct {
+	DBOP *dbop;
+	int mode;			/**< GTAGS_READ, GTAGS_CREATE, GTAGS_MODIFY */
+	GINCREC rec;			/**< record returned by ginclude_first/next */
+} GINCLUDE;
+
+GINCLUDE *ginclude_open(const char *, int);
+void ginclude_put(GINCLUDE *, const char *, int, const char *, const char *);
+void ginclude_delete(GINCLUDE *, IDSET *);
+GINCREC *ginclude_first(GINCLUDE *, const char *);
+GINCREC *ginclude_next(GINCLUDE *);
+void ginclude_close(GINCLUDE *);
+const char *include_lastname(const char *);
+
+#endif /* ! _GINCLUDEOP_H_ */
@@ -31,6 +31,7 @@
 #include "date.h"
 #include "dbop.h"
 #include "defined.h"
+#include "dfa.h"
 #include "die.h"
 #include "encodepath.h"
 #include "env.h"
@@ -38,6 +39,7 @@
 #include "find.h"
 #include "format.h"
 #include "getdbpath.h"
+#include "gincludeop.h"
 #include "gparam.h"
 #include "gpathop.h"
 #include "gtagsop.h"
@@ -48,9 +50,11 @@
 #include "locatestring.h"
 #include "logging.h"
 #include "makepath.h"
+#include "nameindex.h"
 #include "nearsort.h"
 #include "path.h"
 #include "pool.h"
+#include "postlist.h"
 #include "rewrite.h"
 #include "secure_popen.h"
 #include "split.h"
@@ -59,6 +63,7 @@
 #include "strhash.h"
 #include "strlimcpy.h"
 #include "strmake.h"
+#include "subword.h"
 #include "tab.h"
 #include "test.h"
 #include "token.h"
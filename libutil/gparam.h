@@ -59,5 +59,31 @@
 #define GTAGSCACHE	50000000
 		/** minimum cache size 500KB	*/
 #define GTAGSMINCACHE	500000
+/*
+ * The default page size of tag files is 8KB.
+ * It can be changed by GTAGSPAGESIZE when the tag files are made.
+ */
+		/** default page size 8KB	*/
+#define GTAGSPAGESIZE	8192
+		/** minimum page size 512B	*/
+#define GTAGSMINPAGESIZE	512
+		/** maximum page size 64KB	*/
+#define GTAGSMAXPAGESIZE	65536
+/*
+ * The records of a tag name are sorted in memory up to 50MB.
+ * The rest are sorted in temporary files.
+ */
+		/** default sort size 50MB	*/
+#define GTAGSSORTSIZE	50000000
+		/** minimum sort size 100KB	*/
+#define GTAGSMINSORTSIZE	100000
+		/** max number of runs open at a time	*/
+#define GTAGSMAXRUNS	16
+/*
+ * The blocks of posting lists are kept in memory up to 50MB
+ * while making GRTAGS.
+ */
+		/** posting list size 50MB	*/
+#define GTAGSPOSTLISTSIZE	50000000
 
 #endif /* ! _GPARAM_H_ */
@@ -58,10 +58,22 @@
 #include "strhash.h"
 #include "strlimcpy.h"
 #include "strmake.h"
+#include "subword.h"
 #include "varray.h"
 
 #define HASHBUCKETS	2048
 
+/**
+ * A sorted run of a segment written to a temporary file.
+ */
+struct segment_run {
+	FILE *fp;			/**< temporary file */
+	STRBUF *tagline;		/**< tag line of the current record */
+	GTP gtp;			/**< current record */
+	int eof;			/**< no more record */
+	int level;			/**< number of merge passes */
+};
+
 static int compare_path(const void *, const void *);
 static int compare_lineno(const void *, const void *);
 static int compare_tags(const void *, const void *);
@@ -71,8 +83,23 @@ static const char *seekto(const char *, int);
 static int is_defined_in_GTAGS(GTOP *, const char *);
 static char *get_prefix(const char *, int);
 static int gtags_restart(GTOP *);
+static void read_line_offset(GTOP *, const char *, int);
+static const char *read_filter(GTOP *, const char *);
+static const char *read_first(GTOP *);
+static const char *read_next(GTOP *);
+static void put_compact_record(GTOP *, const char *, int);
 static void flush_pool(GTOP *, const char *);
+static unsigned long segment_sortsize(void);
+static void segment_spill(GTOP *, int (*)(const void *, const void *));
+static void run_read(GTOP *, struct segment_run *);
+static int run_compare(GTOP *, int, int);
+static void run_sift_down(GTOP *, int);
+static void run_start(GTOP *, int);
+static GTP *run_next(GTOP *);
+static void run_merge(GTOP *, int);
 static void segment_read(GTOP *);
+static GTP *segment_next(GTOP *);
+static void segment_close(GTOP *);
 
 /**
  * compare_path: compare function for sorting path names.
@@ -197,6 +224,32 @@ seekto(const char *string, int n)
  *	   In addition,successive line numbers are expressed as a range.
  *           ex: 10-3 means '10 11 12 13'.
  *
+ *	   With the GTAGS_COMPOFFSET option (format version 7), the byte
+ *	   offset of each line follows the line numbers, so that the line
+ *	   image can be taken without reading the source file from the head.
+ *	   Each offset is expressed as difference from the previous one.
+ *
+ *         <file id> <tag name> <line number>,... <byte offset>,...
+ *
+ *         [example]
+ *         +------------------------------------
+ *         |110 func 10-1 160,24
+ *
+ *           It means line 10 at offset 160 and line 11 at offset 184.
+ *
+ *	   With the GTAGS_POSTLIST option (format version 8), the records of
+ *	   a tag name in GRTAGS are packed into blocks of a posting list.
+ *	   A block has the range of file ids and skip pointers in the head,
+ *	   and the entries of file ids expressed as difference from the
+ *	   previous one. A block of one entry is the same as the record.
+ *	   See libutil/postlist.c for the details.
+ *
+ *         <file id>[+<span>] <tag name> [*<skip pointers> ]<entry>;...
+ *
+ *         [example]
+ *         +------------------------------------
+ *         |110+5 @n 10,3;2 7-1;3 24
+ *
  * [Description]
  * 
  * - Standard format is applied to GTAGS, and compact format is applied
@@ -243,8 +296,12 @@ seekto(const char *string, int n)
                        if (format !=  4) then print error message.
   GLOBAL-5.4 - 5.8.2	support format version 4 and 5
                        if (format > 5 || format < 4) then print error message.
-  GLOBAL-5.9 -		support only format version 6
+  GLOBAL-5.9 - 6.6.3	support only format version 6
                        if (format > 6 || format < 6) then print error message.
+  GLOBAL-6.6.4 -	support format version 6, 7 and 8
+                       version 7 is used only with gtags --byte-offset.
+                       version 8 is used only with gtags --posting-list.
+                       if (format > 8 || format < 6) then print error message.
  *
  * In GLOBAL-5.0, we threw away the compatibility with the past formats.
  * Though we could continue the support for older formats, it seemed
@@ -260,7 +317,9 @@ seekto(const char *string, int n)
  *       GTAGS seems older format. Please remake tag files.
  */
 static int new_format_version = 6;	/**< new format version */
-static int upper_bound_version = 6;	/**< acceptable format version (upper bound) */
+static int offset_format_version = 7;	/**< format version with byte offsets */
+static int postlist_format_version = 8;	/**< format version with posting lists */
+static int upper_bound_version = 8;	/**< acceptable format version (upper bound) */
 static int lower_bound_version = 6;	/**< acceptable format version (lower bound) */
 static const char *const tagslist[] = {"GPATH", "GTAGS", "GRTAGS", "GSYMS"};
 /**
@@ -343,6 +402,7 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 	gtop->db = db;
 	gtop->mode = mode;
 	gtop->openflags = flags;
+	strlimcpy(gtop->dbpath, dbpath, sizeof(gtop->dbpath));
 	/*
 	 * Open tag file allowing duplicate records.
 	 */
@@ -366,9 +426,15 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 	if (flags & GTAGS_SQLITE3) {
 		dbop_flags |= DBOP_SQLITE3;
 		set_gpath_flags(DBOP_SQLITE3);
+		/* records of sqlite3 are selected by the file id column */
+		gtop->openflags &= ~GTAGS_POSTLIST;
 	} else
 #endif
+	{
 		dbop_flags |= DBOP_SORTED_WRITE;
+		if (flags & GTAGS_PFXKEY)
+			dbop_flags |= DBOP_PFXKEY;
+	}
 	/*
 	 * GRTAGS and GSYMS are virtual tag file. They are included in a real GRTAGS file.
 	 * In fact, GSYMS doesn't exist now.
@@ -412,13 +478,28 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 		if (gtop->db == GRTAGS || gtop->db == GSYMS || gtop->openflags & GTAGS_COMPACT) {
 			gtop->format |= GTAGS_COMPACT;
 			gtop->format |= GTAGS_COMPLINE;
+			/*
+			 * Older GLOBAL cannot read byte offsets.
+			 */
+			if (gtop->openflags & GTAGS_COMPOFFSET) {
+				gtop->format |= GTAGS_COMPOFFSET;
+				gtop->format_version = offset_format_version;
+			}
+			/*
+			 * Posting lists are used only for GRTAGS.
+			 */
+			if (gtop->openflags & GTAGS_POSTLIST && gtop->db == GRTAGS) {
+				gtop->format |= GTAGS_POSTLIST;
+				gtop->format_version = postlist_format_version;
+			}
 		} else {
 			/* standard format */
 			gtop->format |= GTAGS_COMPRESS;
 		}
 		gtop->format |= GTAGS_COMPNAME;
 		if (gtop->format & GTAGS_COMPACT)
-			dbop_putoption(gtop->dbop, COMPACTKEY, NULL);
+			dbop_putoption(gtop->dbop, COMPACTKEY,
+				(gtop->format & GTAGS_COMPOFFSET) ? "offset" : NULL);
 		if (gtop->format & GTAGS_COMPRESS) {
 			dbop_putoption(gtop->dbop, COMPRESSKEY, DEFAULT_ABBREVIATION);
 			abbrev_open(DEFAULT_ABBREVIATION);
@@ -427,6 +508,8 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 			dbop_putoption(gtop->dbop, COMPLINEKEY, NULL);
 		if (gtop->format & GTAGS_COMPNAME)
 			dbop_putoption(gtop->dbop, COMPNAMEKEY, NULL);
+		if (gtop->format & GTAGS_POSTLIST)
+			dbop_putoption(gtop->dbop, POSTLISTKEY, NULL);
 		dbop_putversion(gtop->dbop, gtop->format_version); 
 	} else {
 		/*
@@ -445,8 +528,11 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 		else if (gtop->format_version < lower_bound_version)
 			die("%s seems older format. Please remake tag files.", tagfile);
 		gtop->format = 0;
-		if (dbop_getoption(gtop->dbop, COMPACTKEY) != NULL)
+		if ((p = dbop_getoption(gtop->dbop, COMPACTKEY)) != NULL) {
 			gtop->format |= GTAGS_COMPACT;
+			if (!strcmp(p, "offset"))
+				gtop->format |= GTAGS_COMPOFFSET;
+		}
 		if ((p = dbop_getoption(gtop->dbop, COMPRESSKEY)) != NULL) {
 			abbrev_open(p);
 			gtop->format |= GTAGS_COMPRESS;
@@ -455,6 +541,8 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 			gtop->format |= GTAGS_COMPLINE;
 		if (dbop_getoption(gtop->dbop, COMPNAMEKEY) != NULL)
 			gtop->format |= GTAGS_COMPNAME;
+		if (dbop_getoption(gtop->dbop, POSTLISTKEY) != NULL)
+			gtop->format |= GTAGS_POSTLIST;
 	}
 	if (gpath_open(dbpath, dbmode) < 0) {
 		if (dbmode == 1)
@@ -470,9 +558,17 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 	if (gtop->format & GTAGS_COMPACT) {
 		assert(root != NULL);
 		strlimcpy(gtop->root, root, sizeof(gtop->root));
-		if (gtop->mode != GTAGS_READ)
+		if (gtop->mode != GTAGS_READ) {
 			gtop->path_hash = strhash_open(HASHBUCKETS);
+			gtop->sb_offset = strbuf_open(0);
+		}
 	}
+	/*
+	 * A block is not larger than a compact record.
+	 */
+	if (gtop->format & GTAGS_POSTLIST)
+		gtop->postlist = postlist_open(gtop->mode != GTAGS_READ ? gtop->dbop : NULL,
+						gtop->dbop->pagesize / 4);
 	gtop->sb_compress = strbuf_open(0);
 	return gtop;
 }
@@ -493,6 +589,9 @@ gtags_put_using(GTOP *gtop, const char *tag, int lno, const char *fid, const cha
 	if (gtop->format & GTAGS_COMPACT) {
 		struct sh_entry *entry;
 
+		if (gtop->touched)
+			strhash_assign(gtop->touched, tag, 1);
+
 		/*
 		 * Register each record into the pool.
 		 *
@@ -528,6 +627,8 @@ gtags_put_using(GTOP *gtop, const char *tag, int lno, const char *fid, const cha
 	} else {
 		key = tag;
 	}
+	if (gtop->touched)
+		strhash_assign(gtop->touched, key, 1);
 	strbuf_reset(gtop->sb);
 	strbuf_puts(gtop->sb, fid);
 	strbuf_putc(gtop->sb, ' ');
@@ -551,6 +652,11 @@ gtags_flush(GTOP *gtop, const char *fid)
 		flush_pool(gtop, fid);
 		strhash_reset(gtop->path_hash);
 	}
+	/*
+	 * Blocks of posting lists are kept in memory until they are full.
+	 */
+	if (gtop->format & GTAGS_POSTLIST && postlist_size(gtop->postlist) > GTAGSPOSTLISTSIZE)
+		postlist_flush(gtop->postlist);
 }
 /**
  * gtags_delete: delete records belong to set of fid.
@@ -568,6 +674,11 @@ gtags_delete(GTOP *gtop, IDSET *deleteset)
 	if (gtop->dbop->openflags & DBOP_SQLITE3) {
 		STRBUF *where = strbuf_open(0);
 		long id;
+
+		if (gtop->touched)
+			for (tagline = dbop_first(gtop->dbop, NULL, NULL, 0); tagline; tagline = dbop_next(gtop->dbop))
+				if (idset_contains(deleteset, atoi(tagline)))
+					strhash_assign(gtop->touched, gtop->dbop->lastkey, 1);
 		strbuf_puts(where, "(");
 		for (id = idset_first(deleteset); id != END_OF_ID; id = idset_next(deleteset)) {
 			strbuf_puts(where, "'");
@@ -580,6 +691,40 @@ gtags_delete(GTOP *gtop, IDSET *deleteset)
 		strbuf_close(where);
 	} else
 #endif
+	if (gtop->format & GTAGS_POSTLIST) {
+		STRBUF *rest = strbuf_open(0);
+		const char *p, *end;
+
+		/*
+		 * Blocks which have no file id in the deleteset are skipped.
+		 * The other blocks are removed, and the rest of their entries
+		 * are written again after reading, because writing during reading
+		 * breaks the cursor.
+		 */
+		for (tagline = dbop_first(gtop->dbop, NULL, NULL, 0); tagline; tagline = dbop_next(gtop->dbop)) {
+			if (postlist_first(gtop->postlist, tagline, deleteset) == NULL)
+				continue;
+			if (gtop->touched)
+				strhash_assign(gtop->touched, gtop->dbop->lastkey, 1);
+			for (p = postlist_first(gtop->postlist, tagline, NULL); p; p = postlist_next(gtop->postlist, NULL)) {
+				if (!idset_contains(deleteset, atoi(p))) {
+					strbuf_puts0(rest, gtop->dbop->lastkey);
+					strbuf_puts0(rest, p);
+				}
+			}
+			dbop_delete(gtop->dbop, NULL);
+		}
+		p = strbuf_value(rest);
+		end = p + strbuf_getlen(rest);
+		while (p < end) {
+			const char *key = p;
+
+			p += strlen(p) + 1;
+			postlist_put(gtop->postlist, key, p);
+			p += strlen(p) + 1;
+		}
+		strbuf_close(rest);
+	} else
 	for (tagline = dbop_first(gtop->dbop, NULL, NULL, 0); tagline; tagline = dbop_next(gtop->dbop)) {
 		/*
 		 * Extract path from the tag line.
@@ -588,8 +733,11 @@ gtags_delete(GTOP *gtop, IDSET *deleteset)
 		/*
 		 * If the file id exists in the deleteset, delete the tagline.
 		 */
-		if (idset_contains(deleteset, fid))
+		if (idset_contains(deleteset, fid)) {
+			if (gtop->touched)
+				strhash_assign(gtop->touched, gtop->dbop->lastkey, 1);
 			dbop_delete(gtop->dbop, NULL);
+		}
 	}
 }
 /**
@@ -642,7 +790,124 @@ get_prefix(const char *pattern, int flags)
 	return prefix;
 }
 /**
- * gtags_restart: restart dbop iterator using lower case prefix.
+ * get_nameindex: get the name index (GNAMES) of the tag files.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@return		name index or NULL (not available)
+ */
+static NAMEINDEX *
+get_nameindex(GTOP *gtop)
+{
+	if (gtop->mode != GTAGS_READ)
+		return NULL;
+	if (!gtop->nameindex_tried) {
+		gtop->nameindex_tried = 1;
+		gtop->nameindex = nameindex_open(gtop->dbpath);
+	}
+	return gtop->nameindex;
+}
+/**
+ * get_variants: get the names which match the pattern ignoring case.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	pattern	tag name (not regular expression)
+ *	@param[in]	flags	flags for gtags_first()
+ *	@return		number of names,
+ *			-1: name index is not available
+ *
+ * The names are looked up in the case-folded list of GNAMES, and are
+ * set to gtop->variants in the order of the keys in the tag file.
+ */
+static int
+get_variants(GTOP *gtop, const char *pattern, int flags)
+{
+	const char *name;
+	int len = strlen(pattern);
+
+	if (get_nameindex(gtop) == NULL)
+		return -1;
+	for (name = nameindex_first(gtop->nameindex, pattern, gtop->db, NAMEINDEX_IGNORECASE);
+	     name != NULL;
+	     name = nameindex_next(gtop->nameindex))
+	{
+		if (!(flags & GTOP_PREFIX) && name[len] != '\0')
+			continue;
+		*(const char **)varray_append(gtop->variants) = name;
+	}
+	if (gtop->openflags & GTAGS_DEBUG)
+		fprintf(stderr, "Using %s: %d names\n", GNAMES_NAME, gtop->variants->length);
+	return gtop->variants->length;
+}
+/**
+ * get_candidates: get the names which match the regular expression.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	regex	regular expression (compiled in gtop->preg)
+ *	@param[in]	flags	flags for gtags_first()
+ *	@return		number of names,
+ *			-1: name index is not available or useless
+ *
+ * Only the names which have all trigrams of the literals in the regular
+ * expression are checked by the matcher, instead of all keys in the tag file.
+ */
+static int
+get_candidates(GTOP *gtop, const char *regex, int flags)
+{
+	NAMEINDEX *ni = get_nameindex(gtop);
+	const char *name;
+	int count;
+
+	if (ni == NULL)
+		return -1;
+	count = nameindex_regex(ni, regex, gtop->db, (flags & GTOP_BASICREGEX) ? NAMEINDEX_BASICREGEX : 0);
+	if (count < 0)
+		return -1;
+	while ((name = nameindex_next(ni)) != NULL)
+		if (gtop->dfa ? dfa_match(gtop->dfa, name) : regexec(gtop->preg, name, 0, 0, 0) == 0)
+			*(const char **)varray_append(gtop->variants) = name;
+	if (gtop->openflags & GTAGS_DEBUG)
+		fprintf(stderr, "Using %s: %d candidates, %d names\n", GNAMES_NAME, count, gtop->variants->length);
+	return gtop->variants->length;
+}
+/**
+ * get_subwords: get the names which have the subwords of the query in a row.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	query	query
+ *	@return		number of names
+ *
+ * The candidates are taken from the subword lists of the name index.
+ * Without the name index, all keys in the tag file are checked.
+ */
+static int
+get_subwords(GTOP *gtop, const char *query)
+{
+	NAMEINDEX *ni = get_nameindex(gtop);
+	const char *name;
+
+	if (ni) {
+		int count = nameindex_subword(ni, query, gtop->db);
+
+		while ((name = nameindex_next(ni)) != NULL)
+			if (subword_match(name, query))
+				*(const char **)varray_append(gtop->variants) = name;
+		if (gtop->openflags & GTAGS_DEBUG)
+			fprintf(stderr, "Using %s: %d candidates, %d names\n", GNAMES_NAME, count, gtop->variants->length);
+	} else {
+		if (gtop->variant_pool == NULL)
+			gtop->variant_pool = pool_open();
+		for (name = dbop_first(gtop->dbop, NULL, NULL, DBOP_KEY); name; name = dbop_next(gtop->dbop)) {
+			VIRTUAL_GRTAGS_GSYMS_PROCESSING(gtop);
+			if (subword_match(name, query))
+				*(const char **)varray_append(gtop->variants) =
+					pool_strdup(gtop->variant_pool, name, 0);
+		}
+	}
+	return gtop->variants->length;
+}
+/**
+ * gtags_restart: restart dbop iterator using lower case prefix
+ * or the next name which matches ignoring case.
  *
  *	@param[in]	gtop	GTOP structure
  *	@return		prepared or not
@@ -654,8 +919,14 @@ gtags_restart(GTOP *gtop)
 {
 	int upper, lower;
 
+	if (gtop->variants && gtop->variants->length > 0) {
+		if (gtop->variant_index >= gtop->variants->length)
+			return 0;
+		gtop->key = *(const char **)varray_assign(gtop->variants, gtop->variant_index++, 0);
+		return 1;
+	}
 	if (gtop->prefix == NULL)
-		die("gtags_restart: impossible.");
+		return 0;
 	upper = gtop->prefix[0];
 	lower = tolower(upper);
 	if (upper < lower) {
@@ -670,6 +941,103 @@ gtags_restart(GTOP *gtop)
 		fprintf(stderr, "gtags_restart: not prepared.\n");
 	return 0;
 }
+/**
+ * gtags_setlimit: limit the number of records.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	limit	max number of records returned by
+ *				gtags_first() and gtags_next(), 0: unlimited
+ *
+ * Only the first records in the sorted order are returned. Since the other
+ * records are not kept, a query which has a lot of records gets faster.
+ */
+void
+gtags_setlimit(GTOP *gtop, int limit)
+{
+	gtop->limit = limit;
+}
+/**
+ * gtags_setfidset: limit the files of records.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	fidset	file ids of records returned by gtags_first()
+ *				and gtags_next(), NULL: all files
+ *
+ * With posting lists, the blocks out of the range of the file ids
+ * are skipped without reading the entries.
+ */
+void
+gtags_setfidset(GTOP *gtop, IDSET *fidset)
+{
+	gtop->fidset = fidset;
+}
+/**
+ * read_filter: skip records which should not be read.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	tagline	record read by dbop_first() or dbop_next()
+ *	@return		record or NULL
+ *
+ * A block of posting lists is read one entry at a time by read_next().
+ */
+static const char *
+read_filter(GTOP *gtop, const char *tagline)
+{
+	gtop->inblock = 0;
+	for (; tagline != NULL; tagline = dbop_next(gtop->dbop)) {
+		VIRTUAL_GRTAGS_GSYMS_PROCESSING(gtop);
+		if (gtop->dbflags & DBOP_KEY)
+			break;
+		if (gtop->format & GTAGS_POSTLIST) {
+			const char *p = postlist_first(gtop->postlist, tagline, gtop->fidset);
+
+			if (p == NULL)
+				continue;
+			gtop->inblock = 1;
+			tagline = p;
+			break;
+		}
+		if (gtop->fidset && !idset_contains(gtop->fidset, atoi(tagline)))
+			continue;
+		break;
+	}
+	return gtop->lasttag = tagline;
+}
+/**
+ * read_first: read the first record using gtop->key, gtop->preg and gtop->dbflags.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@return		record or NULL
+ */
+static const char *
+read_first(GTOP *gtop)
+{
+	gtop->unread = 0;
+	return read_filter(gtop, dbop_first(gtop->dbop, gtop->key, gtop->preg, gtop->dbflags));
+}
+/**
+ * read_next: read the next record.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@return		record or NULL
+ *
+ * If gtop->unread is set, the last record is returned again.
+ */
+static const char *
+read_next(GTOP *gtop)
+{
+	if (gtop->unread) {
+		gtop->unread = 0;
+		return gtop->lasttag;
+	}
+	if (gtop->inblock) {
+		const char *p = postlist_next(gtop->postlist, gtop->fidset);
+
+		if (p != NULL)
+			return gtop->lasttag = p;
+	}
+	return read_filter(gtop, dbop_next(gtop->dbop));
+}
 /**
  * gtags_first: return first record
  *
@@ -685,6 +1053,7 @@ gtags_restart(GTOP *gtop)
  *			GTOP_BASICREGEX:	use basic regular expression.
  *			GTOP_NEARSORT:		use 'Nearness sort'.
  *			GTOP_NOSORT:		don't sort
+ *			GTOP_SUBWORD:		match subwords of names
  *
  *			By default, sort is done by alphabetical order.
  *	@return		record
@@ -714,6 +1083,19 @@ gtags_first(GTOP *gtop, const char *pattern, int flags)
 		free(gtop->path_array);
 		gtop->path_array = NULL;
 	}
+	if (gtop->variants == NULL)
+		gtop->variants = varray_open(sizeof(const char *), 32);
+	else
+		varray_reset(gtop->variants);
+	if (gtop->variant_pool)
+		pool_reset(gtop->variant_pool);
+	gtop->variant_index = 0;
+	if (gtop->dfa) {
+		dfa_free(gtop->dfa);
+		gtop->dfa = NULL;
+	}
+	dbop_setdfa(gtop->dbop, NULL, NULL);
+	segment_close(gtop);
 
 	if (flags & GTOP_KEY)
 		gtop->dbflags |= DBOP_KEY;
@@ -737,6 +1119,22 @@ gtags_first(GTOP *gtop, const char *pattern, int flags)
 		 * we take sequential read method.
 		 */
 		gtop->preg = NULL;
+	} else if (flags & GTOP_SUBWORD) {
+		/*
+		 * Each name is read by a exact match.
+		 */
+		get_subwords(gtop, pattern);
+		if (!gtags_restart(gtop))
+			return NULL;
+		gtop->preg = NULL;
+	} else if ((flags & GTOP_IGNORECASE) && (flags & GTOP_NOREGEX || !isregex(pattern))
+		&& get_variants(gtop, pattern, flags) >= 0) {
+		/*
+		 * Each name is read by a exact match.
+		 */
+		if (!gtags_restart(gtop))
+			return NULL;
+		gtop->preg = NULL;
 	} else if (flags & GTOP_IGNORECASE) {
 		regflags |= REG_ICASE;
 		if (flags & GTOP_NOREGEX || !isregex(pattern)) {
@@ -783,6 +1181,25 @@ gtags_first(GTOP *gtop, const char *pattern, int flags)
 			die("gtags_first: impossible (3).");
 		if (regcomp(gtop->preg, strbuf_value(regex), regflags) != 0)
 			die("invalid regular expression.");
+		/*
+		 * Keys are checked by the lazy DFA instead of regexec()
+		 * unless the pattern uses features the DFA doesn't support.
+		 */
+		gtop->dfa = dfa_compile(strbuf_value(regex),
+			((flags & GTOP_BASICREGEX) ? DFA_BASIC : 0) | ((regflags & REG_ICASE) ? DFA_ICASE : 0));
+		if (gtop->dfa)
+			dbop_setdfa(gtop->dbop, gtop->preg, gtop->dfa);
+		if (gtop->openflags & GTAGS_DEBUG)
+			fprintf(stderr, "Using %s\n", gtop->dfa ? "DFA" : "regexec");
+		/*
+		 * A regular expression without prefix requires a scan of all keys.
+		 * Narrow down the names using the name index if possible.
+		 */
+		if (gtop->key == NULL && get_candidates(gtop, strbuf_value(regex), flags) >= 0) {
+			if (!gtags_restart(gtop))
+				return NULL;
+			gtop->preg = NULL;
+		}
 	}
 	/*
 	 * If GTOP_PATH is set, at first, we collect all path names in a pool and
@@ -805,11 +1222,7 @@ gtags_first(GTOP *gtop, const char *pattern, int flags)
 		 *  ...
 		 */
 again0:
-		for (tagline = dbop_first(gtop->dbop, gtop->key, gtop->preg, gtop->dbflags);
-		     tagline != NULL;
-		     tagline = dbop_next(gtop->dbop))
-		{
-			VIRTUAL_GRTAGS_GSYMS_PROCESSING(gtop);
+		for (tagline = read_first(gtop); tagline != NULL; tagline = read_next(gtop)) {
 			/* extract file id */
 			p = locatestring(tagline, " ", MATCH_FIRST);
 			if (p == NULL)
@@ -824,7 +1237,7 @@ again0:
 				entry->value = strhash_strdup(gtop->path_hash, cp, 0);
 			}
 		}
-		if (gtop->prefix && gtags_restart(gtop))
+		if (gtags_restart(gtop))
 			goto again0;
 		/*
 		 * Sort path names.
@@ -852,18 +1265,9 @@ again0:
 		gtop->gtp.path = gtop->path_array[gtop->path_index++];
 		return &gtop->gtp;
 	} else if (gtop->flags & GTOP_KEY) {
-again1:
-		for (gtop->gtp.tag = dbop_first(gtop->dbop, gtop->key, gtop->preg, gtop->dbflags);
-		     gtop->gtp.tag != NULL;
-		     gtop->gtp.tag = dbop_next(gtop->dbop))
-		{
-			VIRTUAL_GRTAGS_GSYMS_PROCESSING(gtop);
-			break;
-		}
-		if (gtop->gtp.tag == NULL) {
-			if (gtop->prefix && gtags_restart(gtop))
-				goto again1;
-		}
+		gtop->gtp.tag = read_first(gtop);
+		while (gtop->gtp.tag == NULL && gtags_restart(gtop))
+			gtop->gtp.tag = read_first(gtop);
 		return gtop->gtp.tag ? &gtop->gtp : NULL;
 	} else {
 		if (gtop->vb == NULL)
@@ -878,28 +1282,20 @@ again1:
 			gtop->path_hash = strhash_open(HASHBUCKETS);
 		else
 			strhash_reset(gtop->path_hash);
-again2:
-		for (tagline = dbop_first(gtop->dbop, gtop->key, gtop->preg, gtop->dbflags);
-			tagline != NULL;
-			tagline = dbop_next(gtop->dbop))
-		{
-			VIRTUAL_GRTAGS_GSYMS_PROCESSING(gtop);
-			break;
-		}
-		if (tagline == NULL) {
-			if (gtop->prefix && gtags_restart(gtop))
-				goto again2;
+		tagline = read_first(gtop);
+		while (tagline == NULL && gtags_restart(gtop))
+			tagline = read_first(gtop);
+		if (tagline == NULL)
 			return NULL;
-		}
 		/*
-		 * Dbop_next() will read the same record again.
+		 * Read_next() will read the same record again.
 		 */
-		dbop_unread(gtop->dbop);
+		gtop->unread = 1;
 		/*
 		 * Read a tag segment with sorting.
 		 */
 		segment_read(gtop);
-		return  &gtop->gtp_array[gtop->gtp_index++];
+		return segment_next(gtop);
 	}
 }
 /**
@@ -913,55 +1309,58 @@ GTP *
 gtags_next(GTOP *gtop)
 {
 	gtop->readcount++;
+	if (gtop->limit > 0 && gtop->readcount > gtop->limit)
+		return NULL;
 	if (gtop->flags & GTOP_PATH) {
 		if (gtop->path_index >= gtop->path_count)
 			return NULL;
 		gtop->gtp.path = gtop->path_array[gtop->path_index++];
 		return &gtop->gtp;
 	} else if (gtop->flags & GTOP_KEY) {
-		gtop->gtp.tag = dbop_next(gtop->dbop);
-again3:
-		for (; gtop->gtp.tag != NULL; gtop->gtp.tag = dbop_next(gtop->dbop))
-		{
-			VIRTUAL_GRTAGS_GSYMS_PROCESSING(gtop);
-			break;
-		}
-		if (gtop->gtp.tag == NULL) {
-			if (gtop->prefix && gtags_restart(gtop)) {
-				gtop->gtp.tag = dbop_first(gtop->dbop, gtop->key, gtop->preg, gtop->dbflags);
-				goto again3;
-			}
-		}
+		gtop->gtp.tag = read_next(gtop);
+		while (gtop->gtp.tag == NULL && gtags_restart(gtop))
+			gtop->gtp.tag = read_first(gtop);
 		return gtop->gtp.tag ? &gtop->gtp : NULL;
 	} else {
+		GTP *gtp = segment_next(gtop);
+
 		/*
 		 * End of segment.
 		 * Reset resources and read new segment again.
 		 */
-		if (gtop->gtp_index >= gtop->gtp_count) {
+		if (gtp == NULL) {
 			varray_reset(gtop->vb);
 			pool_reset(gtop->segment_pool);
 			/* strhash_reset(gtop->path_hash); */
 			segment_read(gtop);
+			gtp = segment_next(gtop);
 		}
-		if (gtop->gtp_index >= gtop->gtp_count) {
-			if (gtop->prefix && gtags_restart(gtop)) {
-				gtop->gtp.tag = dbop_first(gtop->dbop, gtop->key, gtop->preg, gtop->dbflags);
-				if (gtop->gtp.tag == NULL)
-					return NULL;
-				dbop_unread(gtop->dbop);
-				segment_read(gtop);
-			} else
+		while (gtp == NULL) {
+			if (!gtags_restart(gtop))
 				return NULL;
+			gtop->gtp.tag = read_first(gtop);
+			if (gtop->gtp.tag == NULL) {
+				if (gtop->variants && gtop->variants->length > 0)
+					continue;
+				return NULL;
+			}
+			gtop->unread = 1;
+			segment_read(gtop);
+			gtp = segment_next(gtop);
 		}
-		return &gtop->gtp_array[gtop->gtp_index++];
+		return gtp;
 	}
 }
 void
 gtags_show_statistics(GTOP *gtop)
 {
+	unsigned long hit, miss, flush;
+
 	fprintf(stderr, "Numbers of gtags (%s): %d\n", dbname(gtop->db), gtop->readcount);
 	fprintf(stderr, "Numbers of dbop  (%s): %d\n", dbname(gtop->db), gtop->dbop->readcount);
+	if (dbop_cachestat(gtop->dbop, &hit, &miss, &flush) == 0)
+		fprintf(stderr, "Page cache (%s): %lu hits, %lu misses, %lu evictions\n",
+			dbname(gtop->db), hit, miss, flush);
 }
 /**
  * gtags_close: close tag file
@@ -973,24 +1372,114 @@ gtags_close(GTOP *gtop)
 {
 	if (gtop->format & GTAGS_COMPRESS)
 		abbrev_close();
+	if (gtop->postlist) {
+		if (gtop->mode != GTAGS_READ)
+			postlist_flush(gtop->postlist);
+		postlist_close(gtop->postlist);
+	}
 	if (gtop->segment_pool)
 		pool_close(gtop->segment_pool);
+	segment_close(gtop);
+	if (gtop->runs)
+		varray_close(gtop->runs);
+	if (gtop->run_heap)
+		varray_close(gtop->run_heap);
 	if (gtop->path_array)
 		free(gtop->path_array);
 	if (gtop->sb)
 		strbuf_close(gtop->sb);
 	if (gtop->sb_compress)
 		strbuf_close(gtop->sb_compress);
+	if (gtop->sb_offset)
+		strbuf_close(gtop->sb_offset);
+	if (gtop->line_offset)
+		varray_close(gtop->line_offset);
 	if (gtop->vb)
 		varray_close(gtop->vb);
 	if (gtop->path_hash)
 		strhash_close(gtop->path_hash);
+	if (gtop->variants)
+		varray_close(gtop->variants);
+	if (gtop->variant_pool)
+		pool_close(gtop->variant_pool);
+	if (gtop->nameindex)
+		nameindex_close(gtop->nameindex);
+	if (gtop->dfa)
+		dfa_free(gtop->dfa);
 	gpath_close();
 	dbop_close(gtop->dbop);
 	if (gtop->gtags)
 		dbop_close(gtop->gtags);
 	free(gtop);
 }
+/**
+ * read_line_offset: make the table of byte offsets of lines.
+ *
+ *	@param[in]	gtop	descripter of GTOP
+ *	@param[in]	s_fid	file id
+ *	@param[in]	maxline	the last line number needed
+ *
+ * gtop->line_offset[n] is the offset of line n. The lines beyond the end
+ * of the file have the size of the file.
+ */
+static void
+read_line_offset(GTOP *gtop, const char *s_fid, int maxline)
+{
+	const char *path = gpath_fid2path(s_fid, NULL);
+	char buf[BUFSIZ];
+	FILE *fp;
+	int offset = 0;
+
+	if (path == NULL)
+		die("GPATH is corrupted.(file id '%s' not found)", s_fid);
+	if (gtop->line_offset == NULL)
+		gtop->line_offset = varray_open(sizeof(int), 1024);
+	else
+		varray_reset(gtop->line_offset);
+	*(int *)varray_append(gtop->line_offset) = 0;	/* line 0 doesn't exist */
+	*(int *)varray_append(gtop->line_offset) = 0;
+	fp = fopen(makepath(gtop->root, path, NULL), "rb");
+	if (fp != NULL) {
+		size_t size;
+
+		while (gtop->line_offset->length <= maxline && (size = fread(buf, 1, sizeof(buf), fp)) > 0) {
+			const char *p = buf, *end = buf + size, *nl;
+
+			while (gtop->line_offset->length <= maxline && (nl = memchr(p, '\n', end - p)) != NULL) {
+				p = nl + 1;
+				*(int *)varray_append(gtop->line_offset) = offset + (p - buf);
+			}
+			offset += size;
+		}
+		fclose(fp);
+	}
+	while (gtop->line_offset->length <= maxline)
+		*(int *)varray_append(gtop->line_offset) = offset;
+}
+/**
+ * put_compact_record: write a record of compact format.
+ *
+ *	@param[in]	gtop	descripter of GTOP
+ *	@param[in]	key	tag name
+ *	@param[in]	header_offset	length of '<file id> <tag name> '
+ *
+ * The byte offsets are appended to the line numbers if any.
+ * The line numbers and the byte offsets are cleared.
+ */
+static void
+put_compact_record(GTOP *gtop, const char *key, int header_offset)
+{
+	if (gtop->format & GTAGS_COMPOFFSET) {
+		strbuf_putc(gtop->sb, ' ');
+		strbuf_puts(gtop->sb, strbuf_value(gtop->sb_offset));
+		strbuf_reset(gtop->sb_offset);
+	}
+	if (gtop->format & GTAGS_POSTLIST)
+		postlist_put(gtop->postlist, key, strbuf_value(gtop->sb));
+	else
+		dbop_put_tag(gtop->dbop, key, strbuf_value(gtop->sb));
+	strbuf_setlen(gtop->sb, header_offset);
+}
 /**
  * flush_pool: flush and write the pool as compact format.
  *
@@ -1006,6 +1495,19 @@ flush_pool(GTOP *gtop, const char *s_fid)
 
 	if (s_fid == NULL)
 		die("flush_pool: impossible");
+	if (gtop->format & GTAGS_COMPOFFSET) {
+		int maxline = 0;
+
+		for (entry = strhash_first(gtop->path_hash); entry; entry = strhash_next(gtop->path_hash)) {
+			VARRAY *vb = (VARRAY *)entry->value;
+			int *lno_array = varray_assign(vb, 0, 0);
+
+			for (i = 0; i < vb->length; i++)
+				if (lno_array[i] > maxline)
+					maxline = lno_array[i];
+		}
+		read_line_offset(gtop, s_fid, maxline);
+	}
 	/*
 	 * Write records as compact format and free line number table
 	 * for each entry in the pool.
@@ -1050,7 +1552,7 @@ flush_pool(GTOP *gtop, const char *s_fid)
 		 * GTAGS_COMPLINE is set by default in format version 5.
 		 */
 		if (gtop->format & GTAGS_COMPLINE) {
-			int cont = 0;
+			int cont = 0, last_offset = 0;
 
 			last = 0;			/* line 0 doesn't exist */
 			for (i = 0; i < vb->length; i++) {
@@ -1058,6 +1560,14 @@ flush_pool(GTOP *gtop, const char *s_fid)
 
 				if (n == last)
 					continue;
+				if (gtop->format & GTAGS_COMPOFFSET) {
+					int offset = *(int *)varray_assign(gtop->line_offset, n, 0);
+
+					if (strbuf_getlen(gtop->sb_offset) > 0)
+						strbuf_putc(gtop->sb_offset, ',');
+					strbuf_putn(gtop->sb_offset, offset - last_offset);
+					last_offset = offset;
+				}
 				if (last > 0 && n == last + 1) {
 					if (!cont) {
 						/*
@@ -1083,9 +1593,9 @@ flush_pool(GTOP *gtop, const char *s_fid)
 					} else {
 						strbuf_putn(gtop->sb, n);
 					}
-					if (strbuf_getlen(gtop->sb) > DBOP_PAGESIZE / 4) {
-						dbop_put_tag(gtop->dbop, key, strbuf_value(gtop->sb));
-						strbuf_setlen(gtop->sb, header_offset);
+					if (strbuf_getlen(gtop->sb) + strbuf_getlen(gtop->sb_offset) > gtop->dbop->pagesize / 4) {
+						put_compact_record(gtop, key, header_offset);
+						last_offset = 0;
 					}
 				}
 				last = n;
@@ -1107,7 +1617,7 @@ flush_pool(GTOP *gtop, const char *s_fid)
 				if (strbuf_getlen(gtop->sb) > header_offset)
 					strbuf_putc(gtop->sb, ',');
 				strbuf_putn(gtop->sb, n);
-				if (strbuf_getlen(gtop->sb) > DBOP_PAGESIZE / 4) {
+				if (strbuf_getlen(gtop->sb) > gtop->dbop->pagesize / 4) {
 					dbop_put_tag(gtop->dbop, key, strbuf_value(gtop->sb));
 					strbuf_setlen(gtop->sb, header_offset);
 				}
@@ -1115,12 +1625,295 @@ flush_pool(GTOP *gtop, const char *s_fid)
 			}
 		}
 		if (strbuf_getlen(gtop->sb) > header_offset) {
-			dbop_put_tag(gtop->dbop, key, strbuf_value(gtop->sb));
+			put_compact_record(gtop, key, header_offset);
 		}
 		/* Free line number table */
 		varray_close(vb);
 	}
 }
+/**
+ * sift_down: restore the heap property of a max-heap.
+ *
+ *	@param[in]	a	heap
+ *	@param[in]	n	number of elements
+ *	@param[in]	i	element which may be smaller than its children
+ *	@param[in]	compare	compare function
+ */
+static void
+sift_down(GTP *a, int n, int i, int (*compare)(const void *, const void *))
+{
+	GTP tmp;
+
+	for (;;) {
+		int max = i, l = 2 * i + 1, r = l + 1;
+
+		if (l < n && compare(&a[l], &a[max]) > 0)
+			max = l;
+		if (r < n && compare(&a[r], &a[max]) > 0)
+			max = r;
+		if (max == i)
+			break;
+		tmp = a[i];
+		a[i] = a[max];
+		a[max] = tmp;
+		i = max;
+	}
+}
+/**
+ * segment_sortsize: memory size for sorting a segment.
+ *
+ *	@return		size in bytes
+ */
+static unsigned long
+segment_sortsize(void)
+{
+	static unsigned long sortsize;
+
+	if (sortsize == 0) {
+		const char *p = getenv("GTAGSSORTSIZE");
+
+		sortsize = p ? strtoul(p, NULL, 10) : GTAGSSORTSIZE;
+		if (sortsize < GTAGSMINSORTSIZE)
+			sortsize = GTAGSMINSORTSIZE;
+	}
+	return sortsize;
+}
+/**
+ * segment_spill: write the segment table to a temporary file as a run.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	compare	compare function
+ *
+ * Each tag line is terminated by a NUL character.
+ * The segment table and the pool are emptied.
+ *
+ * At most GTAGSMAXRUNS runs are kept open. When the limit is reached,
+ * the newest runs which have passed the same number of merges are merged
+ * into one run, so that each record is rewritten only a few times.
+ */
+static void
+segment_spill(GTOP *gtop, int (*compare)(const void *, const void *))
+{
+	GTP *gtp = varray_assign(gtop->vb, 0, 0);
+	struct segment_run *run;
+	int i, n;
+
+	if (gtop->runs == NULL)
+		gtop->runs = varray_open(sizeof(struct segment_run), 8);
+	run = varray_append(gtop->runs);
+	if ((run->fp = tmpfile()) == NULL)
+		die("cannot make temporary file for sorting.");
+	run->tagline = strbuf_open(0);
+	run->eof = 0;
+	run->level = 0;
+	if (!(gtop->flags & GTOP_NOSORT))
+		qsort(gtp, gtop->vb->length, sizeof(GTP), compare);
+	for (i = 0; i < gtop->vb->length; i++) {
+		fputs(gtp[i].tagline, run->fp);
+		putc('\0', run->fp);
+	}
+	if (ferror(run->fp))
+		die("cannot write temporary file for sorting.");
+	varray_reset(gtop->vb);
+	pool_reset(gtop->segment_pool);
+	gtop->segment_size = 0;
+	if ((n = gtop->runs->length) < GTAGSMAXRUNS)
+		return;
+	/*
+	 * The levels of the runs never increase from the oldest to the newest.
+	 * If the newest run is alone at its level, the runs of the next level
+	 * are merged together with it.
+	 */
+	run = varray_assign(gtop->runs, 0, 0);
+	for (i = n - 1; i > 0 && run[i - 1].level == run[n - 1].level; i--)
+		;
+	if (i == n - 1)
+		for (i--; i > 0 && run[i - 1].level == run[n - 2].level; i--)
+			;
+	run_merge(gtop, i);
+}
+/**
+ * run_read: read the next record of a run.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	run	run
+ *
+ * The path name is taken from the cache which segment_read() made.
+ */
+static void
+run_read(GTOP *gtop, struct segment_run *run)
+{
+	const char *tagline, *fid, *lineno;
+	struct sh_entry *sh;
+	int c;
+
+	strbuf_clear(run->tagline);
+	while ((c = getc(run->fp)) != EOF && c != '\0')
+		strbuf_putc(run->tagline, c);
+	if (c == EOF) {
+		run->eof = 1;
+		return;
+	}
+	tagline = strbuf_value(run->tagline);
+	fid = (const char *)strmake(tagline, " ");
+	sh = strhash_assign(gtop->path_hash, fid, 0);
+	if (sh == NULL)
+		die("Something is wrong. 'fid %s' not found in the cache.", fid);
+	lineno = seekto(tagline, SEEKTO_LINENO);
+	if (lineno == NULL)
+		die("invalid tag record.\n%s", tagline);
+	run->gtp.tag = (const char *)gtop->cur_tagname;
+	run->gtp.path = sh->value;
+	run->gtp.lineno = atoi(lineno);
+	run->gtp.tagline = strbuf_value(run->tagline);
+}
+/**
+ * run_compare: compare the current records of two runs.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	a	index of a run
+ *	@param[in]	b	index of a run
+ *	@return		<0: a is smaller, >0: b is smaller
+ *
+ * The equal records (and all records without sorting) are ordered by
+ * the index of the run, that is, in the order they were read.
+ */
+static int
+run_compare(GTOP *gtop, int a, int b)
+{
+	int (*compare)(const void *, const void *) =
+		gtop->flags & GTOP_NEARSORT ? compare_neartags : compare_tags;
+	struct segment_run *run = varray_assign(gtop->runs, 0, 0);
+	int ret = 0;
+
+	if (!(gtop->flags & GTOP_NOSORT))
+		ret = compare(&run[a].gtp, &run[b].gtp);
+	return ret ? ret : a - b;
+}
+/**
+ * run_sift_down: restore the heap property of the min-heap of runs.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	i	element which may be larger than its children
+ */
+static void
+run_sift_down(GTOP *gtop, int i)
+{
+	int *heap = varray_assign(gtop->run_heap, 0, 0);
+	int n = gtop->run_count;
+	int tmp;
+
+	for (;;) {
+		int min = i, l = 2 * i + 1, r = l + 1;
+
+		if (l < n && run_compare(gtop, heap[l], heap[min]) < 0)
+			min = l;
+		if (r < n && run_compare(gtop, heap[r], heap[min]) < 0)
+			min = r;
+		if (min == i)
+			break;
+		tmp = heap[i];
+		heap[i] = heap[min];
+		heap[min] = tmp;
+		i = min;
+	}
+}
+/**
+ * run_start: start merging the runs.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	from	index of the first run to be merged
+ *
+ * The runs from @a from to the last are rewound and put on the heap.
+ */
+static void
+run_start(GTOP *gtop, int from)
+{
+	struct segment_run *run = varray_assign(gtop->runs, 0, 0);
+	int *heap;
+	int i;
+
+	if (gtop->run_heap == NULL)
+		gtop->run_heap = varray_open(sizeof(int), GTAGSMAXRUNS);
+	varray_assign(gtop->run_heap, gtop->runs->length - 1, 1);
+	heap = varray_assign(gtop->run_heap, 0, 0);
+	gtop->run_count = 0;
+	for (i = from; i < gtop->runs->length; i++) {
+		rewind(run[i].fp);
+		run_read(gtop, &run[i]);
+		if (!run[i].eof)
+			heap[gtop->run_count++] = i;
+	}
+	for (i = gtop->run_count / 2 - 1; i >= 0; i--)
+		run_sift_down(gtop, i);
+	gtop->run_last = -1;
+}
+/**
+ * run_next: return the smallest record of the runs.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@return		record, NULL: end of runs
+ *
+ * The record is valid until the next call.
+ */
+static GTP *
+run_next(GTOP *gtop)
+{
+	struct segment_run *run = varray_assign(gtop->runs, 0, 0);
+	int *heap = varray_assign(gtop->run_heap, 0, 0);
+
+	/*
+	 * The last record is no longer used.
+	 */
+	if (gtop->run_last >= 0) {
+		run_read(gtop, &run[gtop->run_last]);
+		if (run[gtop->run_last].eof)
+			heap[0] = heap[--gtop->run_count];
+		run_sift_down(gtop, 0);
+		gtop->run_last = -1;
+	}
+	if (gtop->run_count == 0)
+		return NULL;
+	gtop->run_last = heap[0];
+	return &run[heap[0]].gtp;
+}
+/**
+ * run_merge: merge the runs into a run.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@param[in]	from	index of the first run to be merged
+ *
+ * The runs from @a from to the last are replaced with the merged run.
+ */
+static void
+run_merge(GTOP *gtop, int from)
+{
+	struct segment_run *run;
+	FILE *fp;
+	GTP *gtp;
+	int i, level;
+
+	if ((fp = tmpfile()) == NULL)
+		die("cannot make temporary file for sorting.");
+	run_start(gtop, from);
+	while ((gtp = run_next(gtop)) != NULL) {
+		fputs(gtp->tagline, fp);
+		putc('\0', fp);
+	}
+	if (ferror(fp))
+		die("cannot write temporary file for sorting.");
+	run = varray_assign(gtop->runs, 0, 0);
+	level = run[from].level + 1;
+	for (i = from; i < gtop->runs->length; i++) {
+		fclose(run[i].fp);
+		if (i > from)
+			strbuf_close(run[i].tagline);
+	}
+	run[from].fp = fp;
+	run[from].eof = 0;
+	run[from].level = level;
+	gtop->runs->length = from + 1;
+}
 /**
  * Read a tag segment with sorting.
  *
@@ -1140,20 +1933,40 @@ flush_pool(GTOP *gtop, const char *s_fid)
  *	- 3rd key: line number
  *
  * Since all records in a segment have same tag name, you need not think about 1st key.
+ *
+ * If the number of records is limited by gtags_setlimit(), only the first
+ * records in the sorted order are kept in a max-heap, and the others are
+ * thrown away as soon as they are read. Without sorting, reading stops
+ * when enough records are read.
+ *
+ * Otherwise, when the segment table grows beyond GTAGSSORTSIZE bytes,
+ * it is sorted and written to a temporary file as a run. The runs are
+ * merged by segment_next(), so the memory used does not depend on
+ * the number of records in a segment.
  */
 void
 segment_read(GTOP *gtop)
 {
-	const char *tagline, *fid, *path, *lineno;
-	GTP *gtp;
+	int (*compare)(const void *, const void *) =
+		gtop->flags & GTOP_NEARSORT ? compare_neartags : compare_tags;
+	const char *tagline, *fid, *lineno;
+	GTP *gtp, cur;
 	struct sh_entry *sh;
+	int limit = 0;
+	unsigned long sortsize = segment_sortsize();
 
+	gtop->segment_size = 0;
+	if (gtop->limit > 0) {
+		/* gtop->readcount - 1 records have been returned */
+		limit = gtop->limit - gtop->readcount + 1;
+		if (limit <= 0)
+			limit = 1;
+	}
 	/*
 	 * Save tag lines.
 	 */
 	gtop->cur_tagname[0] = '\0';
-	while ((tagline = dbop_next(gtop->dbop)) != NULL) {
-		VIRTUAL_GRTAGS_GSYMS_PROCESSING(gtop);
+	while ((tagline = read_next(gtop)) != NULL) {
 		/*
 		 * get tag name and line number.
 		 *
@@ -1163,27 +1976,72 @@ segment_read(GTOP *gtop)
 			strlimcpy(gtop->cur_tagname, gtop->dbop->lastkey, sizeof(gtop->cur_tagname));
 		} else if (strcmp(gtop->cur_tagname, gtop->dbop->lastkey) != 0) {
 			/*
-			 * Dbop_next() wil read the same record again.
+			 * Read_next() wil read the same record again.
 			 */
-			dbop_unread(gtop->dbop);
+			gtop->unread = 1;
 			break;
 		}
-		gtp = varray_append(gtop->vb);
-		gtp->tagline = pool_strdup(gtop->segment_pool, tagline, 0);
-		gtp->tag = (const char *)gtop->cur_tagname;
 		/*
-		 * convert fid into hashed path name to save memory.
+		 * convert fid into path name. The path names are cached
+		 * in the hash table by fid.
 		 */
 		fid = (const char *)strmake(tagline, " ");
-		path = gpath_fid2path(fid, NULL);
-		if (path == NULL)
-			die("GPATH is corrupted.(file id '%s' not found)", fid);
-		sh = strhash_assign(gtop->path_hash, path, 1);
-		gtp->path = sh->name;
-		lineno = seekto(gtp->tagline, SEEKTO_LINENO);
+		sh = strhash_assign(gtop->path_hash, fid, 1);
+		if (sh->value == NULL) {
+			const char *path = gpath_fid2path(fid, NULL);
+
+			if (path == NULL)
+				die("GPATH is corrupted.(file id '%s' not found)", fid);
+			sh->value = strhash_strdup(gtop->path_hash, path, 0);
+		}
+		cur.path = sh->value;
+		lineno = seekto(tagline, SEEKTO_LINENO);
 		if (lineno == NULL)
 			die("invalid tag record.\n%s", tagline);
-		gtp->lineno = atoi(lineno);
+		cur.lineno = atoi(lineno);
+		cur.tag = (const char *)gtop->cur_tagname;
+		if (limit > 0 && gtop->vb->length >= limit) {
+			GTP *heap = varray_assign(gtop->vb, 0, 0);
+
+			/*
+			 * The largest record in the heap is replaced.
+			 */
+			if (compare(&cur, &heap[0]) >= 0)
+				continue;
+			cur.tagline = pool_strdup(gtop->segment_pool, tagline, 0);
+			heap[0] = cur;
+			sift_down(heap, limit, 0, compare);
+			continue;
+		}
+		gtp = varray_append(gtop->vb);
+		*gtp = cur;
+		gtp->tagline = pool_strdup(gtop->segment_pool, tagline, 0);
+		if (limit == 0) {
+			gtop->segment_size += sizeof(GTP) + strlen(tagline) + 1;
+			if (gtop->segment_size > sortsize)
+				segment_spill(gtop, compare);
+		}
+		if (limit > 0 && gtop->vb->length == limit) {
+			GTP *heap = varray_assign(gtop->vb, 0, 0);
+			int i;
+
+			/*
+			 * Without sorting, the rest of the segment is not needed.
+			 */
+			if (gtop->flags & GTOP_NOSORT)
+				break;
+			for (i = limit / 2 - 1; i >= 0; i--)
+				sift_down(heap, limit, i, compare);
+		}
+	}
+	/*
+	 * If some runs were written, the rest is also written and
+	 * the records are merged by segment_next().
+	 */
+	if (gtop->runs && gtop->runs->length > 0) {
+		if (gtop->vb->length > 0)
+			segment_spill(gtop, compare);
+		run_start(gtop, 0);
 	}
 	/*
 	 * Sort tag lines.
@@ -1192,6 +2050,50 @@ segment_read(GTOP *gtop)
 	gtop->gtp_count = gtop->vb->length;
 	gtop->gtp_index = 0;
 	if (!(gtop->flags & GTOP_NOSORT))
-		qsort(gtop->gtp_array, gtop->gtp_count, sizeof(GTP),
-			gtop->flags & GTOP_NEARSORT ? compare_neartags : compare_tags);
+		qsort(gtop->gtp_array, gtop->gtp_count, sizeof(GTP), compare);
+}
+/**
+ * segment_next: return the next record of the segment.
+ *
+ *	@param[in]	gtop	GTOP structure
+ *	@return		record, NULL: end of segment
+ *
+ * If the segment was written to runs, the records are merged.
+ * Without sorting, the runs are read in order.
+ */
+static GTP *
+segment_next(GTOP *gtop)
+{
+	GTP *gtp;
+
+	if (gtop->runs == NULL || gtop->runs->length == 0) {
+		if (gtop->gtp_index >= gtop->gtp_count)
+			return NULL;
+		return &gtop->gtp_array[gtop->gtp_index++];
+	}
+	if ((gtp = run_next(gtop)) == NULL)
+		segment_close(gtop);
+	return gtp;
+}
+/**
+ * segment_close: remove the runs of the segment.
+ *
+ *	@param[in]	gtop	GTOP structure
+ */
+static void
+segment_close(GTOP *gtop)
+{
+	struct segment_run *run;
+	int i;
+
+	if (gtop->runs == NULL || gtop->runs->length == 0)
+		return;
+	run = varray_assign(gtop->runs, 0, 0);
+	for (i = 0; i < gtop->runs->length; i++) {
+		fclose(run[i].fp);
+		strbuf_close(run[i].tagline);
+	}
+	varray_reset(gtop->runs);
+	gtop->run_count = 0;
+	gtop->run_last = -1;
 }
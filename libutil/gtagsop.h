@@ -27,6 +27,9 @@
 #include "gparam.h"
 #include "dbop.h"
 #include "idset.h"
+#include "idset.h"
+#include "nameindex.h"
+#include "postlist.h"
 #include "strbuf.h"
 #include "strhash.h"
 #include "varray.h"
@@ -35,6 +38,7 @@
 #define COMPRESSKEY	" __.COMPRESS"
 #define COMPLINEKEY	" __.COMPLINE"
 #define COMPNAMEKEY	" __.COMPNAME"
+#define POSTLISTKEY	" __.POSTLIST"
 
 #define NOTAGS		-1
 #define GPATH		0
@@ -64,6 +68,12 @@
 #ifdef USE_SQLITE3
 #define GTAGS_SQLITE3	32
 #endif
+			/** byte offset for each line number */
+#define GTAGS_COMPOFFSET	64
+			/** prefix compressed tag names */
+#define GTAGS_PFXKEY		128
+			/** pack records of a tag name into posting lists */
+#define GTAGS_POSTLIST		256
 			/** print information for debug */
 #define GTAGS_DEBUG		65536
 
@@ -86,6 +96,8 @@
 #define GTOP_NEARSORT		64
 			/** don't sort */
 #define GTOP_NOSORT		128
+			/** match subwords (camelCase and snake_case) */
+#define GTOP_SUBWORD		256
 
 /**
  * This entry corresponds to one raw record.
@@ -125,24 +137,54 @@ typedef struct {
 	POOL *segment_pool;
 	VARRAY *vb;
 	char cur_tagname[IDENTLEN];	/**< current tag name */
+	unsigned long segment_size;	/**< memory used for the segment table */
+	VARRAY *runs;			/**< sorted runs in temporary files */
+	VARRAY *run_heap;		/**< min-heap of the run indexes */
+	int run_count;			/**< number of runs in the heap */
+	int run_last;			/**< run of the last record, -1: none */
 
 	/*
 	 * Stuff for compact format
 	 */
 	STRBUF *sb;			/**< string buffer */
 	STRBUF *sb_compress;		/**< string buffer */
+	STRBUF *sb_offset;		/**< byte offsets of a record */
+	VARRAY *line_offset;		/**< byte offset of each line */
 
 	/** used for compact format and path name only read */
 	STRHASH *path_hash;
 
+	/*
+	 * Stuff for posting lists (GTAGS_POSTLIST).
+	 */
+	POSTLIST *postlist;		/**< blocks of compact records */
+	IDSET *fidset;			/**< file ids to be read or NULL (all) */
+	const char *lasttag;		/**< record read last */
+	int inblock;			/**< 1: reading a block */
+	int unread;			/**< 1: read lasttag again */
+
+	/*
+	 * Stuff for case-insensitive search using the name index (GNAMES).
+	 * The names which match ignoring case are read one by one.
+	 */
+	char dbpath[MAXPATHLEN];	/**< dbpath directory */
+	NAMEINDEX *nameindex;		/**< name index or NULL */
+	int nameindex_tried;		/**< nameindex_open() was called */
+	VARRAY *variants;		/**< names to be read (const char *) */
+	POOL *variant_pool;		/**< names which are not in the name index */
+	int variant_index;		/**< next name in variants */
+	STRHASH *touched;		/**< names of added or deleted records or NULL */
+
 	/*
 	 * Stuff for calling dbop
 	 */
 	const char *key;
 	char *prefix;
 	regex_t *preg;
+	DFA *dfa;			/**< lazy DFA made from preg or NULL */
 	int dbflags;
 	int readcount;
+	int limit;			/**< max number of records, 0: unlimited */
 } GTOP;
 
 const char *dbname(int);
@@ -150,6 +192,8 @@ GTOP *gtags_open(const char *, const char *, int, int, int);
 void gtags_put_using(GTOP *, const char *, int, const char *, const char *);
 void gtags_flush(GTOP *, const char *);
 void gtags_delete(GTOP *, IDSET *);
+void gtags_setlimit(GTOP *, int);
+void gtags_setfidset(GTOP *, IDSET *);
 GTP *gtags_first(GTOP *, const char *, int);
 GTP *gtags_next(GTOP *);
 void gtags_show_statistics(GTOP *);
@@ -154,6 +154,39 @@ idset_contains(IDSET *idset, unsigned int id)
 		return 0;
 	return (idset->set[id / LONG_BIT] & bit[id % LONG_BIT]) != 0;
 }
+/**
+ * Whether or not idset includes any id in a range.
+ *
+ *	@param[in]	idset	idset structure
+ *	@param[in]	from	lower bound of the range
+ *	@param[in]	to	upper bound of the range (inclusive)
+ *	@return		true: contains, false: doesn't contain
+ */
+int
+idset_range(IDSET *idset, unsigned int from, unsigned int to)
+{
+	unsigned int id;
+
+	if (IS_EMPTY(idset))
+		return 0;
+	if (from < idset->min)
+		from = idset->min;
+	if (to > idset->max)
+		to = idset->max;
+	for (id = from; id <= to; ) {
+		/* whole word in the range */
+		if (id % LONG_BIT == 0 && to - id >= LONG_BIT - 1) {
+			if (idset->set[id / LONG_BIT] != 0)
+				return 1;
+			id += LONG_BIT;
+		} else {
+			if (idset->set[id / LONG_BIT] & bit[id % LONG_BIT])
+				return 1;
+			id++;
+		}
+	}
+	return 0;
+}
 /**
  * Get first id.
  *
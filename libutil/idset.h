@@ -36,6 +36,7 @@ IDSET *idset_open(unsigned int);
 int idset_empty(IDSET *);
 void idset_add(IDSET *, unsigned int);
 int idset_contains(IDSET *, unsigned int);
+int idset_range(IDSET *, unsigned int, unsigned int);
 unsigned int idset_first(IDSET *);
 unsigned int idset_next(IDSET *);
 unsigned int idset_count(IDSET *);
@@ -0,0 +1,1082 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <ctype.h>
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "checkalloc.h"
+#include "dbop.h"
+#include "die.h"
+#include "gparam.h"
+#include "gtagsop.h"
+#include "makepath.h"
+#include "nameindex.h"
+#include "strbuf.h"
+#include "strhash.h"
+#include "strlimcpy.h"
+#include "subword.h"
+#include "varray.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/*
+ * GNAMES: name index
+ *
+ * Gtags(1) writes the list of all names in GTAGS and GRTAGS into GNAMES
+ * after making or updating tag files. The names are kept sorted twice,
+ * by strcmp() and by strcasecmp(), so that a prefix is found by binary
+ * search in the mmapped image without reading B-tree pages.
+ * Global -c and the completion of htags-server(1) use it.
+ *
+ * The trigrams of the names are also recorded with the list of names
+ * which contain them. A regular expression without usable prefix is
+ * narrowed down to the names which contain all of its literal trigrams.
+ * A regular expression which ends with a literal and '$' is looked up
+ * in the list of names sorted from the end instead.
+ * The subwords of the names (see subword.c) are recorded in the same way
+ * as the trigrams for global --subword.
+ *
+ * GNAMES is a cache. It remembers the size and mtime of GTAGS and GRTAGS,
+ * and is ignored when they don't match. The caller should fall back to
+ * gtags_first() for NULL of nameindex_open().
+ * After an incremental update, GNAMES is remade from the old one and the
+ * names touched by the update (see nameindex_update()).
+ */
+#define NAMEINDEX_MAGIC		0x474e414d	/* 'GNAM' */
+#define NAMEINDEX_VERSION	4
+#define HASHBUCKETS		2048
+
+#define NAME(ni, i)	((ni)->pool + (ni)->entry[i].name)
+#define FOLDED(ni, i)	NAME(ni, (ni)->folded[i])
+#define FOLD(c)		(((c) >= 'A' && (c) <= 'Z') ? (c) - 'A' + 'a' : (c))
+#define GRAM(p)		((FOLD((unsigned char)(p)[0]) << 16) | (FOLD((unsigned char)(p)[1]) << 8) | FOLD((unsigned char)(p)[2]))
+
+struct name {
+	const char *name;
+	unsigned int ndef;
+	unsigned int nref;
+	unsigned int index;
+};
+
+/**
+ * get_stamp: get the size and mtime of GTAGS and GRTAGS.
+ *
+ *	@param[in]	dbpath	dbpath directory
+ *	@param[out]	stamp	stamp[4]
+ */
+static void
+get_stamp(const char *dbpath, unsigned int *stamp)
+{
+	struct stat st;
+
+	memset(stamp, 0, sizeof(unsigned int) * 4);
+	if (stat(makepath(dbpath, dbname(GTAGS), NULL), &st) == 0) {
+		stamp[0] = (unsigned int)st.st_size;
+		stamp[1] = (unsigned int)st.st_mtime;
+	}
+	if (stat(makepath(dbpath, dbname(GRTAGS), NULL), &st) == 0) {
+		stamp[2] = (unsigned int)st.st_size;
+		stamp[3] = (unsigned int)st.st_mtime;
+	}
+}
+/**
+ * count_names: count records for each name in a tag file.
+ *
+ *	@param[in]	sh	name table
+ *	@param[in]	dbpath	dbpath directory
+ *	@param[in]	db	GTAGS or GRTAGS
+ */
+static void
+count_names(STRHASH *sh, const char *dbpath, int db)
+{
+	struct sh_entry *ent = NULL;
+	struct name *np = NULL;
+	DBOP *dbop;
+	const char *key;
+
+	dbop = dbop_open(makepath(dbpath, dbname(db), NULL), 0, 0, 0);
+	if (dbop == NULL)
+		return;
+	for (key = dbop_first(dbop, NULL, NULL, 0); key; key = dbop_next(dbop)) {
+		key = dbop->lastkey;
+		if (*key == ' ')		/* meta record */
+			continue;
+		/*
+		 * Records of a name are adjacent in the B-tree.
+		 */
+		if (ent == NULL || strcmp(ent->name, key)) {
+			ent = strhash_assign(sh, key, 1);
+			if (ent->value == NULL) {
+				np = pool_malloc(sh->pool, sizeof(struct name));
+				memset(np, 0, sizeof(struct name));
+				np->name = ent->name;
+				ent->value = np;
+			}
+			np = ent->value;
+		}
+		if (db == GTAGS)
+			np->ndef++;
+		else
+			np->nref++;
+	}
+	dbop_close(dbop);
+}
+/**
+ * add_name: add a name to the name table.
+ */
+static void
+add_name(STRHASH *sh, const char *name, unsigned int ndef, unsigned int nref)
+{
+	struct sh_entry *ent = strhash_assign(sh, name, 1);
+	struct name *np = pool_malloc(sh->pool, sizeof(struct name));
+
+	memset(np, 0, sizeof(struct name));
+	np->name = ent->name;
+	np->ndef = ndef;
+	np->nref = nref;
+	ent->value = np;
+}
+/**
+ * recount_names: count records of the given names in the tag files.
+ *
+ *	@param[in]	sh	name table
+ *	@param[in]	dbpath	dbpath directory
+ *	@param[in]	names	names to count
+ *
+ * Names which have no record are not added to the name table.
+ */
+static void
+recount_names(STRHASH *sh, const char *dbpath, STRHASH *names)
+{
+	DBOP *dbop[2];
+	struct sh_entry *ent;
+	const char *p;
+	unsigned int count[2];
+	int i;
+
+	for (i = 0; i < 2; i++)
+		dbop[i] = dbop_open(makepath(dbpath, dbname(i == 0 ? GTAGS : GRTAGS), NULL), 0, 0, 0);
+	for (ent = strhash_first(names); ent; ent = strhash_next(names)) {
+		for (i = 0; i < 2; i++) {
+			count[i] = 0;
+			if (dbop[i] == NULL)
+				continue;
+			for (p = dbop_first(dbop[i], ent->name, NULL, 0); p; p = dbop_next(dbop[i]))
+				count[i]++;
+		}
+		if (count[0] > 0 || count[1] > 0)
+			add_name(sh, ent->name, count[0], count[1]);
+	}
+	for (i = 0; i < 2; i++)
+		if (dbop[i])
+			dbop_close(dbop[i]);
+}
+static int
+cmp_name(const void *a, const void *b)
+{
+	return strcmp((*(const struct name **)a)->name, (*(const struct name **)b)->name);
+}
+static int
+cmp_folded(const void *a, const void *b)
+{
+	const struct name *n1 = *(const struct name **)a;
+	const struct name *n2 = *(const struct name **)b;
+	int r = strcasecmp(n1->name, n2->name);
+
+	return r ? r : strcmp(n1->name, n2->name);
+}
+/**
+ * cmp_reverse: compare strings from the end ignoring case.
+ *
+ *	@param[in]	s1, s2	strings
+ *	@param[in]	len1, len2	length of them
+ *	@return		<0, 0, >0
+ */
+static int
+cmp_reverse(const char *s1, int len1, const char *s2, int len2)
+{
+	while (len1 > 0 && len2 > 0) {
+		int c1 = (unsigned char)s1[--len1];
+		int c2 = (unsigned char)s2[--len2];
+
+		c1 = FOLD(c1);
+		c2 = FOLD(c2);
+		if (c1 != c2)
+			return c1 - c2;
+	}
+	return len1 - len2;
+}
+static int
+cmp_reversed(const void *a, const void *b)
+{
+	const struct name *n1 = *(const struct name **)a;
+	const struct name *n2 = *(const struct name **)b;
+	int r = cmp_reverse(n1->name, strlen(n1->name), n2->name, strlen(n2->name));
+
+	return r ? r : (int)n1->index - (int)n2->index;
+}
+struct pair {
+	unsigned int gram;
+	unsigned int index;
+};
+static int
+cmp_pair(const void *a, const void *b)
+{
+	const struct pair *p1 = (const struct pair *)a;
+	const struct pair *p2 = (const struct pair *)b;
+
+	if (p1->gram != p2->gram)
+		return p1->gram < p2->gram ? -1 : 1;
+	return p1->index < p2->index ? -1 : p1->index > p2->index ? 1 : 0;
+}
+struct wpair {
+	const char *word;
+	unsigned int index;
+};
+static int
+cmp_wpair(const void *a, const void *b)
+{
+	const struct wpair *p1 = (const struct wpair *)a;
+	const struct wpair *p2 = (const struct wpair *)b;
+	int r = strcmp(p1->word, p2->word);
+
+	if (r)
+		return r;
+	return p1->index < p2->index ? -1 : p1->index > p2->index ? 1 : 0;
+}
+/**
+ * put_posting: append a posting to the list of the key.
+ *
+ *	@param[in]	table	table of struct nameindex_list
+ *	@param[in]	posting	postings
+ *	@param[in]	newkey	1: start a new list
+ *	@param[in]	key	key of the list
+ *	@param[in]	index	entry number
+ */
+static void
+put_posting(VARRAY *table, VARRAY *posting, int newkey, unsigned int key, unsigned int index)
+{
+	struct nameindex_list *list;
+
+	if (newkey) {
+		list = varray_append(table);
+		list->key = key;
+		list->offset = posting->length;
+		list->count = 0;
+	} else
+		list = varray_assign(table, table->length - 1, 0);
+	*(unsigned int *)varray_append(posting) = index;
+	list->count++;
+}
+/**
+ * make_grams: make the trigram table.
+ *
+ *	@param[in]	list	names sorted by strcmp()
+ *	@param[in]	count	number of names
+ *	@param[out]	table	trigram table
+ *	@param[out]	posting	postings
+ */
+static void
+make_grams(struct name **list, unsigned int count, VARRAY *table, VARRAY *posting)
+{
+	struct pair *pair;
+	unsigned int i, n = 0, size = 0;
+	const char *p;
+
+	for (i = 0; i < count; i++) {
+		int len = strlen(list[i]->name);
+		if (len >= 3)
+			size += len - 2;
+	}
+	pair = (struct pair *)check_malloc(sizeof(struct pair) * (size ? size : 1));
+	for (i = 0; i < count; i++)
+		for (p = list[i]->name; p[0] && p[1] && p[2]; p++) {
+			pair[n].gram = GRAM(p);
+			pair[n].index = i;
+			n++;
+		}
+	qsort(pair, n, sizeof(struct pair), cmp_pair);
+	for (i = 0; i < n; i++) {
+		int newkey = (i == 0 || pair[i].gram != pair[i - 1].gram);
+
+		if (!newkey && pair[i].index == pair[i - 1].index)
+			continue;		/* same trigram in a name */
+		put_posting(table, posting, newkey, pair[i].gram, pair[i].index);
+	}
+	free(pair);
+}
+/**
+ * make_words: make the subword table.
+ *
+ *	@param[in]	list	names sorted by strcmp()
+ *	@param[in]	count	number of names
+ *	@param[out]	pool	string pool; subwords are appended
+ *	@param[out]	table	subword table
+ *	@param[out]	posting	postings
+ */
+static void
+make_words(struct name **list, unsigned int count, STRBUF *pool, VARRAY *table, VARRAY *posting)
+{
+	STRHASH *words = strhash_open(HASHBUCKETS);
+	STRBUF *sb = strbuf_open(0);
+	VARRAY *vb = varray_open(sizeof(struct wpair), 1000);
+	struct wpair *pair;
+	unsigned int i, offset = 0;
+	const char *p, *end;
+
+	for (i = 0; i < count; i++) {
+		strbuf_reset(sb);
+		subword_split(list[i]->name, sb);
+		end = strbuf_value(sb) + strbuf_getlen(sb);
+		for (p = strbuf_value(sb); p < end; p += strlen(p) + 1) {
+			pair = varray_append(vb);
+			pair->word = strhash_assign(words, p, 1)->name;
+			pair->index = i;
+		}
+	}
+	pair = (struct wpair *)vb->vbuf;
+	qsort(pair, vb->length, sizeof(struct wpair), cmp_wpair);
+	for (i = 0; i < (unsigned int)vb->length; i++) {
+		int newkey = (i == 0 || strcmp(pair[i].word, pair[i - 1].word));
+
+		if (!newkey && pair[i].index == pair[i - 1].index)
+			continue;		/* same subword in a name */
+		if (newkey) {
+			offset = strbuf_getlen(pool);
+			strbuf_puts0(pool, pair[i].word);
+		}
+		put_posting(table, posting, newkey, offset, pair[i].index);
+	}
+	varray_close(vb);
+	strbuf_close(sb);
+	strhash_close(words);
+}
+/**
+ * write_index: write GNAMES made from a name table.
+ *
+ *	@param[in]	dbpath	dbpath directory
+ *	@param[in]	sh	name table (the value is struct name)
+ *
+ * GNAMES is replaced atomically, so readers never see a partial file.
+ */
+static void
+write_index(const char *dbpath, STRHASH *sh)
+{
+	STRBUF *pool = strbuf_open(0);
+	VARRAY *gram = varray_open(sizeof(struct nameindex_list), 1000);
+	VARRAY *word = varray_open(sizeof(struct nameindex_list), 1000);
+	VARRAY *posting = varray_open(sizeof(unsigned int), 10000);
+	struct nameindex_header header;
+	struct nameindex_entry *entry;
+	unsigned int *folded, *reversed;
+	struct name **list;
+	struct sh_entry *ent;
+	char path[MAXPATHLEN], tmp[MAXPATHLEN];
+	unsigned int i, count;
+	FILE *op;
+
+	memset(&header, 0, sizeof(header));
+	count = sh->entries;
+	list = (struct name **)check_malloc(sizeof(struct name *) * (count ? count : 1));
+	i = 0;
+	for (ent = strhash_first(sh); ent; ent = strhash_next(sh))
+		list[i++] = ent->value;
+	qsort(list, count, sizeof(struct name *), cmp_name);
+	entry = (struct nameindex_entry *)check_malloc(sizeof(struct nameindex_entry) * (count ? count : 1));
+	for (i = 0; i < count; i++) {
+		list[i]->index = i;
+		entry[i].name = strbuf_getlen(pool);
+		entry[i].ndef = list[i]->ndef;
+		entry[i].nref = list[i]->nref;
+		strbuf_puts0(pool, list[i]->name);
+	}
+	make_grams(list, count, gram, posting);
+	make_words(list, count, pool, word, posting);
+	qsort(list, count, sizeof(struct name *), cmp_folded);
+	folded = (unsigned int *)check_malloc(sizeof(unsigned int) * (count ? count : 1));
+	for (i = 0; i < count; i++)
+		folded[i] = list[i]->index;
+	qsort(list, count, sizeof(struct name *), cmp_reversed);
+	reversed = (unsigned int *)check_malloc(sizeof(unsigned int) * (count ? count : 1));
+	for (i = 0; i < count; i++)
+		reversed[i] = list[i]->index;
+
+	header.magic = NAMEINDEX_MAGIC;
+	header.version = NAMEINDEX_VERSION;
+	header.count = count;
+	header.ngrams = gram->length;
+	header.nwords = word->length;
+	header.nposting = posting->length;
+	header.poolsize = strbuf_getlen(pool);
+	get_stamp(dbpath, header.stamp);
+
+	strlimcpy(path, makepath(dbpath, GNAMES_NAME, NULL), sizeof(path));
+	strlimcpy(tmp, makepath(dbpath, GNAMES_NAME, "tmp"), sizeof(tmp));
+	if ((op = fopen(tmp, "wb")) == NULL)
+		die("cannot make %s.", GNAMES_NAME);
+	if (fwrite(&header, sizeof(header), 1, op) != 1
+	    || fwrite(entry, sizeof(struct nameindex_entry), count, op) != count
+	    || fwrite(folded, sizeof(unsigned int), count, op) != count
+	    || fwrite(reversed, sizeof(unsigned int), count, op) != count
+	    || fwrite(gram->vbuf, sizeof(struct nameindex_list), header.ngrams, op) != header.ngrams
+	    || fwrite(word->vbuf, sizeof(struct nameindex_list), header.nwords, op) != header.nwords
+	    || fwrite(posting->vbuf, sizeof(unsigned int), header.nposting, op) != header.nposting
+	    || fwrite(strbuf_value(pool), 1, header.poolsize, op) != header.poolsize
+	    || fclose(op) != 0)
+		die("cannot write %s.", GNAMES_NAME);
+	if (rename(tmp, path) < 0)
+		die("cannot rename '%s' to '%s'.", tmp, path);
+	free(reversed);
+	free(folded);
+	free(entry);
+	free(list);
+	varray_close(posting);
+	varray_close(word);
+	varray_close(gram);
+	strbuf_close(pool);
+}
+/**
+ * nameindex_create: make GNAMES from GTAGS and GRTAGS.
+ *
+ *	@param[in]	dbpath	dbpath directory
+ */
+void
+nameindex_create(const char *dbpath)
+{
+	STRHASH *sh = strhash_open(HASHBUCKETS);
+
+	count_names(sh, dbpath, GTAGS);
+	count_names(sh, dbpath, GRTAGS);
+	write_index(dbpath, sh);
+	strhash_close(sh);
+}
+/**
+ * nameindex_update: remake GNAMES after an incremental update.
+ *
+ *	@param[in]	dbpath	dbpath directory
+ *	@param[in]	ni	GNAMES opened before the update
+ *	@param[in]	touched	names whose records were added or deleted
+ *
+ * The counts of the other names are taken from the old GNAMES, so only
+ * the touched names are looked up in the tag files instead of reading
+ * them all.
+ */
+void
+nameindex_update(const char *dbpath, NAMEINDEX *ni, STRHASH *touched)
+{
+	STRHASH *sh = strhash_open(HASHBUCKETS);
+	unsigned int i;
+
+	for (i = 0; i < ni->header->count; i++) {
+		const char *name = NAME(ni, i);
+
+		if (strhash_assign(touched, name, 0) == NULL)
+			add_name(sh, name, ni->entry[i].ndef, ni->entry[i].nref);
+	}
+	recount_names(sh, dbpath, touched);
+	write_index(dbpath, sh);
+	strhash_close(sh);
+}
+/**
+ * nameindex_open: open GNAMES.
+ *
+ *	@param[in]	dbpath	dbpath directory
+ *	@return		descripter or NULL (GNAMES not found or out of date)
+ */
+NAMEINDEX *
+nameindex_open(const char *dbpath)
+{
+	NAMEINDEX *ni;
+	const struct nameindex_header *header;
+	unsigned int stamp[4];
+	struct stat st;
+	char *map;
+	int fd, mapped = 0;
+
+	if ((fd = open(makepath(dbpath, GNAMES_NAME, NULL), O_RDONLY|O_BINARY)) < 0)
+		return NULL;
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(struct nameindex_header)) {
+		close(fd);
+		return NULL;
+	}
+#ifdef HAVE_MMAP
+	map = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+		die("mmap failed (%s).", GNAMES_NAME);
+	mapped = 1;
+#else
+	map = check_malloc(st.st_size);
+	if (read(fd, map, st.st_size) != st.st_size)
+		die("read failed (%s).", GNAMES_NAME);
+#endif
+	close(fd);
+	ni = (NAMEINDEX *)check_calloc(sizeof(NAMEINDEX), 1);
+	ni->map = map;
+	ni->size = st.st_size;
+	ni->mapped = mapped;
+	header = ni->header = (const struct nameindex_header *)map;
+	/*
+	 * Ignore the file of other byte order or version, and the file
+	 * left behind by tag files modified later.
+	 */
+	get_stamp(dbpath, stamp);
+	if (header->magic != NAMEINDEX_MAGIC
+	    || header->version != NAMEINDEX_VERSION
+	    || memcmp(header->stamp, stamp, sizeof(stamp))
+	    || ni->size != sizeof(struct nameindex_header)
+			+ (size_t)header->count * (sizeof(struct nameindex_entry) + sizeof(unsigned int) * 2)
+			+ (size_t)(header->ngrams + header->nwords) * sizeof(struct nameindex_list)
+			+ (size_t)header->nposting * sizeof(unsigned int)
+			+ header->poolsize) {
+		nameindex_close(ni);
+		return NULL;
+	}
+	ni->entry = (const struct nameindex_entry *)(map + sizeof(struct nameindex_header));
+	ni->folded = (const unsigned int *)(ni->entry + header->count);
+	ni->reversed = ni->folded + header->count;
+	ni->gram = (const struct nameindex_list *)(ni->reversed + header->count);
+	ni->word = ni->gram + header->ngrams;
+	ni->posting = (const unsigned int *)(ni->word + header->nwords);
+	ni->pool = (const char *)(ni->posting + header->nposting);
+	return ni;
+}
+
+/**
+ * selected: whether the entry belongs to the tag file.
+ */
+static int
+selected(NAMEINDEX *ni, int i)
+{
+	const struct nameindex_entry *e = &ni->entry[i];
+
+	switch (ni->db) {
+	case GTAGS:
+		return e->ndef > 0;
+	case GRTAGS:
+		return e->nref > 0 && e->ndef > 0;
+	case GSYMS:
+		return e->nref > 0 && e->ndef == 0;
+	default:		/* GRTAGS + GSYMS */
+		return e->nref > 0;
+	}
+}
+/**
+ * add_match: append an entry to the match list.
+ */
+static void
+add_match(NAMEINDEX *ni, int i)
+{
+	if (ni->nmatch >= ni->matchsize) {
+		ni->matchsize = ni->matchsize ? ni->matchsize * 2 : 256;
+		ni->match = (int *)check_realloc(ni->match, sizeof(int) * ni->matchsize);
+	}
+	ni->match[ni->nmatch++] = i;
+}
+static int
+cmp_int(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+/**
+ * nameindex_first: get the first name which begins with the prefix.
+ *
+ *	@param[in]	ni	descripter
+ *	@param[in]	prefix	prefix or NULL (all names)
+ *	@param[in]	db	GTAGS, GRTAGS, GSYMS or GRTAGS+GSYMS
+ *	@param[in]	flags	NAMEINDEX_IGNORECASE: ignore case distinctions
+ *	@return		name or NULL
+ *
+ * Names are returned in the order of strcmp() even if NAMEINDEX_IGNORECASE
+ * is specified, which is the same order as gtags_first() returns.
+ */
+const char *
+nameindex_first(NAMEINDEX *ni, const char *prefix, int db, int flags)
+{
+	int count = ni->header->count;
+	int lo = 0, hi = count;
+
+	ni->db = db;
+	ni->prefix = (prefix && *prefix) ? prefix : NULL;
+	ni->prefixlen = ni->prefix ? strlen(ni->prefix) : 0;
+	ni->listed = (flags & NAMEINDEX_IGNORECASE) ? 1 : 0;
+	ni->nmatch = 0;
+	if (!ni->listed) {
+		if (ni->prefix) {
+			while (lo < hi) {
+				int mid = (lo + hi) / 2;
+
+				if (strcmp(NAME(ni, mid), ni->prefix) < 0)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+		}
+		ni->cur = lo - 1;
+		return nameindex_next(ni);
+	}
+	/*
+	 * Names which begin with the prefix ignoring case are adjacent
+	 * in the folded list. They are picked up and sorted by entry number.
+	 */
+	if (ni->prefix) {
+		while (lo < hi) {
+			int mid = (lo + hi) / 2;
+
+			if (strcasecmp(FOLDED(ni, mid), ni->prefix) < 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+	}
+	for (; lo < count; lo++) {
+		if (ni->prefix && strncasecmp(FOLDED(ni, lo), ni->prefix, ni->prefixlen))
+			break;
+		add_match(ni, ni->folded[lo]);
+	}
+	qsort(ni->match, ni->nmatch, sizeof(int), cmp_int);
+	ni->cur = -1;
+	return nameindex_next(ni);
+}
+/**
+ * nameindex_next: get the next name.
+ *
+ *	@param[in]	ni	descripter
+ *	@return		name or NULL
+ */
+const char *
+nameindex_next(NAMEINDEX *ni)
+{
+	int count = ni->header->count;
+	int i;
+
+	for (;;) {
+		if (ni->listed) {
+			if (++ni->cur >= ni->nmatch)
+				return NULL;
+			i = ni->match[ni->cur];
+		} else {
+			i = ++ni->cur;
+			if (i >= count)
+				return NULL;
+			if (ni->prefix && strncmp(NAME(ni, i), ni->prefix, ni->prefixlen))
+				return NULL;
+		}
+		if (selected(ni, i))
+			break;
+	}
+	ni->ndef = ni->entry[i].ndef;
+	ni->nref = ni->entry[i].nref;
+	return NAME(ni, i);
+}
+/**
+ * required_literals: pick up the literal strings which every string
+ * matched to the regular expression contains.
+ *
+ *	@param[in]	regex	regular expression
+ *	@param[in]	basic	1: basic regular expression, 0: extended
+ *	@param[out]	sb	literals longer than 2 bytes, each followed by '\0'
+ *	@return		0: done, -1: cannot decide (alternation)
+ *
+ * This is conservative: a character which might be optional is dropped.
+ * Groups are skipped entirely, since they may be repeated zero times.
+ */
+int
+required_literals(const char *regex, int basic, STRBUF *sb)
+{
+	const char *p = regex;
+	char run[IDENTLEN];
+	int len = 0, depth = 0;
+
+#define FLUSH() do {								\
+	if (len >= 3 && depth == 0) {						\
+		strbuf_nputs(sb, run, len);					\
+		strbuf_putc(sb, '\0');						\
+	}									\
+	len = 0;								\
+} while (0)
+	while (*p) {
+		int c = (unsigned char)*p++;
+
+		if (c == '\\') {
+			if (*p == '\0')
+				return -1;
+			c = (unsigned char)*p++;
+			if (basic && c == '|')
+				return -1;
+			if (basic && (c == '(' || c == ')')) {
+				FLUSH();
+				depth += (c == '(') ? 1 : -1;
+				continue;
+			}
+			if (basic && (c == '?' || c == '+')) {	/* GNU extension */
+				if (c == '?' && len > 0)
+					len--;
+				FLUSH();
+				continue;
+			}
+			if (basic && c == '{') {		/* \{m,n\} */
+				if (len > 0)
+					len--;
+				FLUSH();
+				while (*p && !(p[0] == '\\' && p[1] == '}'))
+					p++;
+				if (*p)
+					p += 2;
+				continue;
+			}
+			/* \w, \b, \<, \1 and so on */
+			if (isalnum(c) || c == '<' || c == '>' || c == '`' || c == '\'') {
+				FLUSH();
+				continue;
+			}
+		} else if (c == '[') {
+			FLUSH();
+			if (*p == '^')
+				p++;
+			if (*p == ']')
+				p++;
+			while (*p && *p != ']') {
+				if (*p == '[' && (p[1] == ':' || p[1] == '.' || p[1] == '=')) {
+					int term = p[1];
+
+					for (p += 2; *p && !(p[0] == term && p[1] == ']'); p++)
+						;
+					if (*p)
+						p += 2;
+				} else
+					p++;
+			}
+			if (*p)
+				p++;
+			continue;
+		} else if (c == '.' || c == '^' || c == '$') {
+			FLUSH();
+			continue;
+		} else if (c == '*' || (!basic && (c == '?' || c == '{'))) {
+			if (len > 0)
+				len--;
+			FLUSH();
+			if (c == '{') {
+				while (*p && *p != '}')
+					p++;
+				if (*p)
+					p++;
+			}
+			continue;
+		} else if (!basic && c == '+') {
+			FLUSH();
+			continue;
+		} else if (!basic && (c == '(' || c == ')')) {
+			FLUSH();
+			depth += (c == '(') ? 1 : -1;
+			continue;
+		} else if (!basic && c == '|') {
+			return -1;
+		}
+		if (depth > 0)
+			continue;
+		if (len >= (int)sizeof(run))
+			FLUSH();
+		run[len++] = c;
+	}
+	FLUSH();
+#undef FLUSH
+	return 0;
+}
+/**
+ * suffix_literal: get the literal at the end of the regular expression.
+ *
+ *	@param[in]	regex	regular expression
+ *	@param[out]	buf	buffer for the literal
+ *	@param[in]	size	size of the buffer
+ *	@return		length of the literal, 0: not end-anchored literal
+ */
+static int
+suffix_literal(const char *regex, char *buf, int size)
+{
+	int len = strlen(regex);
+	const char *p, *end;
+
+	if (len < 2 || regex[len - 1] != '$' || regex[len - 2] == '\\')
+		return 0;
+	end = regex + len - 1;
+	for (p = end; p > regex && !strchr(".[]()*+?{}|\\^$", p[-1]); p--)
+		;
+	/* The first character may be a part of an escape sequence like \w. */
+	if (p > regex && p[-1] == '\\')
+		p++;
+	if (p >= end)
+		return 0;
+	if (end - p >= size)
+		p = end - (size - 1);
+	len = end - p;
+	memcpy(buf, p, len);
+	buf[len] = '\0';
+	return len;
+}
+/**
+ * lookup_suffix: pick up the names which end with the suffix ignoring case.
+ *
+ *	@param[in]	ni	descripter
+ *	@param[in]	suffix	suffix
+ *	@param[in]	len	length of the suffix
+ */
+static void
+lookup_suffix(NAMEINDEX *ni, const char *suffix, int len)
+{
+	int count = ni->header->count;
+	int lo = 0, hi = count;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		const char *name = NAME(ni, ni->reversed[mid]);
+
+		if (cmp_reverse(name, strlen(name), suffix, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	for (; lo < count; lo++) {
+		const char *name = NAME(ni, ni->reversed[lo]);
+		int namelen = strlen(name);
+
+		if (namelen < len || cmp_reverse(name + namelen - len, len, suffix, len))
+			break;
+		add_match(ni, ni->reversed[lo]);
+	}
+	qsort(ni->match, ni->nmatch, sizeof(int), cmp_int);
+}
+/**
+ * lookup_gram: get the posting list of a trigram.
+ *
+ *	@param[in]	ni	descripter
+ *	@param[in]	gram	trigram
+ *	@return		entry of the trigram table or NULL
+ */
+static const struct nameindex_list *
+lookup_gram(NAMEINDEX *ni, unsigned int gram)
+{
+	int lo = 0, hi = ni->header->ngrams;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (ni->gram[mid].key < gram)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < (int)ni->header->ngrams && ni->gram[lo].key == gram)
+		return &ni->gram[lo];
+	return NULL;
+}
+/**
+ * intersect: intersect the match list with a posting list.
+ *
+ *	@param[in]	ni	descripter
+ *	@param[in]	post	posting list (sorted)
+ *	@param[in]	count	length of the posting list
+ *	@param[in]	first	1: the match list is set to the posting list
+ */
+static void
+intersect(NAMEINDEX *ni, const unsigned int *post, int count, int first)
+{
+	int i, j, n;
+
+	if (first) {
+		ni->nmatch = 0;
+		for (i = 0; i < count; i++)
+			add_match(ni, post[i]);
+		return;
+	}
+	for (i = j = n = 0; i < ni->nmatch && j < count; ) {
+		if (ni->match[i] < (int)post[j])
+			i++;
+		else if (ni->match[i] > (int)post[j])
+			j++;
+		else {
+			ni->match[n++] = ni->match[i];
+			i++, j++;
+		}
+	}
+	ni->nmatch = n;
+}
+/**
+ * nameindex_regex: select the names which may match the regular expression.
+ *
+ *	@param[in]	ni	descripter
+ *	@param[in]	regex	regular expression
+ *	@param[in]	db	GTAGS, GRTAGS, GSYMS or GRTAGS+GSYMS
+ *	@param[in]	flags	NAMEINDEX_BASICREGEX: basic regular expression
+ *	@return		number of candidates,
+ *			-1: the regular expression has no literal trigram
+ *
+ * The candidates end with the literal at the end of the regular expression
+ * if it is end-anchored, otherwise they contain all trigrams of the literals
+ * in the regular expression. Case is ignored in both.
+ * The caller should read them by nameindex_next(), and check them by regexec().
+ */
+int
+nameindex_regex(NAMEINDEX *ni, const char *regex, int db, int flags)
+{
+	STRBUF *sb = strbuf_open(0);
+	const char *p, *end;
+	char suffix[IDENTLEN];
+	int len, ngram = 0;
+
+	if (required_literals(regex, flags & NAMEINDEX_BASICREGEX, sb) < 0) {
+		strbuf_close(sb);
+		return -1;
+	}
+	ni->db = db;
+	ni->prefix = NULL;
+	ni->prefixlen = 0;
+	ni->listed = 1;
+	ni->nmatch = 0;
+	ni->cur = -1;
+	if ((len = suffix_literal(regex, suffix, sizeof(suffix))) > 0) {
+		lookup_suffix(ni, suffix, len);
+		strbuf_close(sb);
+		return ni->nmatch;
+	}
+	end = strbuf_value(sb) + strbuf_getlen(sb);
+	for (p = strbuf_value(sb); p < end; p += strlen(p) + 1) {
+		const char *q;
+
+		for (q = p; q[0] && q[1] && q[2]; q++) {
+			const struct nameindex_list *g = lookup_gram(ni, GRAM(q));
+
+			if (g == NULL) {		/* no name has this trigram */
+				ni->nmatch = 0;
+				strbuf_close(sb);
+				return 0;
+			}
+			intersect(ni, ni->posting + g->offset, g->count, ngram++ == 0);
+		}
+	}
+	strbuf_close(sb);
+	if (ngram == 0)
+		return -1;
+	return ni->nmatch;
+}
+/**
+ * lookup_word: get the posting list of a subword.
+ *
+ *	@param[in]	ni	descripter
+ *	@param[in]	word	subword
+ *	@return		entry of the subword table or NULL
+ */
+static const struct nameindex_list *
+lookup_word(NAMEINDEX *ni, const char *word)
+{
+	int lo = 0, hi = ni->header->nwords;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (strcmp(ni->pool + ni->word[mid].key, word) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < (int)ni->header->nwords && !strcmp(ni->pool + ni->word[lo].key, word))
+		return &ni->word[lo];
+	return NULL;
+}
+/**
+ * nameindex_subword: select the names which have all subwords of the query.
+ *
+ *	@param[in]	ni	descripter
+ *	@param[in]	query	query
+ *	@param[in]	db	GTAGS, GRTAGS, GSYMS or GRTAGS+GSYMS
+ *	@return		number of candidates
+ *
+ * The caller should read them by nameindex_next(), and check the order
+ * of the subwords by subword_match().
+ */
+int
+nameindex_subword(NAMEINDEX *ni, const char *query, int db)
+{
+	STRBUF *sb = strbuf_open(0);
+	const char *p, *end;
+	int first = 1;
+
+	ni->db = db;
+	ni->prefix = NULL;
+	ni->prefixlen = 0;
+	ni->listed = 1;
+	ni->nmatch = 0;
+	ni->cur = -1;
+	subword_split(query, sb);
+	end = strbuf_value(sb) + strbuf_getlen(sb);
+	for (p = strbuf_value(sb); p < end; p += strlen(p) + 1) {
+		const struct nameindex_list *w = lookup_word(ni, p);
+
+		if (w == NULL) {
+			ni->nmatch = 0;
+			break;
+		}
+		intersect(ni, ni->posting + w->offset, w->count, first);
+		first = 0;
+	}
+	strbuf_close(sb);
+	return ni->nmatch;
+}
+/**
+ * nameindex_close: close GNAMES.
+ *
+ *	@param[in]	ni	descripter
+ */
+void
+nameindex_close(NAMEINDEX *ni)
+{
+#ifdef HAVE_MMAP
+	if (ni->mapped)
+		munmap(ni->map, ni->size);
+	else
+#endif
+		free(ni->map);
+	if (ni->match)
+		free(ni->match);
+	free(ni);
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _NAMEINDEX_H_
+#define _NAMEINDEX_H_
+
+#include <sys/types.h>
+
+#include "strbuf.h"
+#include "strhash.h"
+
+#define GNAMES_NAME	"GNAMES"
+
+/*
+ * Layout of GNAMES:
+ *
+ *	header
+ *	entry[count]		sorted by strcmp()
+ *	folded[count]		entry numbers sorted by strcasecmp()
+ *	reversed[count]		entry numbers sorted by reversed names ignoring case
+ *	gram[ngrams]		trigrams of names folded to lower case
+ *	word[nwords]		subwords of names (see subword.c)
+ *	posting[nposting]	entry numbers for each trigram and subword
+ *	string pool
+ */
+struct nameindex_header {
+	unsigned int magic;		/**< NAMEINDEX_MAGIC (also detects byte order) */
+	unsigned int version;		/**< format version */
+	unsigned int count;		/**< number of names */
+	unsigned int ngrams;		/**< number of trigrams */
+	unsigned int nwords;		/**< number of subwords */
+	unsigned int nposting;		/**< number of postings */
+	unsigned int poolsize;		/**< size of string pool */
+	unsigned int stamp[4];		/**< size and mtime of GTAGS and GRTAGS */
+};
+struct nameindex_entry {
+	unsigned int name;		/**< offset of the name in string pool */
+	unsigned int ndef;		/**< number of records in GTAGS */
+	unsigned int nref;		/**< number of records in GRTAGS */
+};
+struct nameindex_list {
+	unsigned int key;		/**< trigram (three bytes) or offset of subword */
+	unsigned int offset;		/**< first posting */
+	unsigned int count;		/**< number of postings */
+};
+
+typedef struct {
+	char *map;			/**< whole file image */
+	size_t size;			/**< size of the image */
+	int mapped;			/**< 1: mmapped, 0: malloced */
+	const struct nameindex_header *header;
+	const struct nameindex_entry *entry;
+	const unsigned int *folded;
+	const unsigned int *reversed;
+	const struct nameindex_list *gram;
+	const struct nameindex_list *word;
+	const unsigned int *posting;
+	const char *pool;
+	/*
+	 * iterator
+	 */
+	int db;				/**< GTAGS, GRTAGS, GSYMS or GRTAGS+GSYMS */
+	const char *prefix;		/**< prefix or NULL */
+	int prefixlen;
+	int listed;			/**< 1: read entries in match[] */
+	int cur;			/**< current position */
+	int *match;			/**< matched entries */
+	int nmatch;
+	int matchsize;
+	/*
+	 * counts of the name returned last
+	 */
+	int ndef;
+	int nref;
+} NAMEINDEX;
+
+/* flags for nameindex_first() and nameindex_regex() */
+#define NAMEINDEX_IGNORECASE	1
+#define NAMEINDEX_BASICREGEX	2
+
+void nameindex_create(const char *);
+void nameindex_update(const char *, NAMEINDEX *, STRHASH *);
+NAMEINDEX *nameindex_open(const char *);
+const char *nameindex_first(NAMEINDEX *, const char *, int, int);
+const char *nameindex_next(NAMEINDEX *);
+int nameindex_regex(NAMEINDEX *, const char *, int, int);
+int nameindex_subword(NAMEINDEX *, const char *, int);
+void nameindex_close(NAMEINDEX *);
+int required_literals(const char *, int, STRBUF *);
+
+#endif /* ! _NAMEINDEX_H_ */
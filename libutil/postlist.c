@@ -0,0 +1,410 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+
+#include "checkalloc.h"
+#include "dbop.h"
+#include "die.h"
+#include "idset.h"
+#include "postlist.h"
+#include "strbuf.h"
+#include "strhash.h"
+
+/*
+ * Posting list of a tag name.
+ *
+ * The compact records of a tag name are packed into blocks. Each block
+ * is stored as a record of the tag name instead of the compact records.
+ * A block is not larger than a quarter of the page size like a compact
+ * record, so that it is never put on overflow pages.
+ *
+ *	<file id>[+<span>] <tag name> [*<skip pointers> ]<entry>[;<entry>...]
+ *
+ *	entry:		[<file id delta> ]<line number>,...[ <byte offset>,...]
+ *	skip pointer:	<file id - the first file id>:<offset of the entry>
+ *
+ * - The file ids of the block are from <file id> to <file id> + <span>.
+ *   Blocks out of the range of file ids required are skipped without
+ *   reading the entries.
+ * - The file id of the first entry is the <file id> of the block. The file
+ *   id of each of the other entries is expressed as difference from the
+ *   previous entry. The entries are sorted by the file id.
+ * - Line numbers and byte offsets are the same as the compact record.
+ * - A skip pointer is put every POSTLIST_SKIP entries. The offset is
+ *   relative to the first entry. They are used to skip entries which
+ *   are not required.
+ *
+ *	[example]
+ *	+------------------------------------
+ *	|110+5 @n *5:40 10,3;2 7-1;...;3 24
+ *
+ *	It means 'func' (compressed as '@n') is used at line 10 and 13
+ *	in file 110, line 7 and 8 in file 112, ... and line 24 in file 115.
+ *
+ * A block which has only one entry is the same as the compact record.
+ */
+struct list {
+	char *name;			/**< tag name of the entries */
+	STRBUF *entries;		/**< entries */
+	STRBUF *skip;			/**< skip pointers or NULL */
+	int first;			/**< file id of the first entry */
+	int last;			/**< file id of the last entry */
+	int count;			/**< number of entries */
+};
+
+static void put_block(POSTLIST *, const char *, struct list *);
+static void skip_entries(POSTLIST *, IDSET *);
+
+/**
+ * postlist_open: open posting lists.
+ *
+ *	@param[in]	dbop	tag file to which blocks are written, or NULL
+ *	@param[in]	blocksize	max size of a block
+ *	@return		POSTLIST structure
+ */
+POSTLIST *
+postlist_open(DBOP *dbop, int blocksize)
+{
+	POSTLIST *pl = (POSTLIST *)check_calloc(sizeof(POSTLIST), 1);
+
+	pl->dbop = dbop;
+	pl->blocksize = blocksize;
+	if (dbop) {
+		pl->lists = strhash_open(1024);
+		pl->sb = strbuf_open(0);
+	}
+	pl->block = strbuf_open(0);
+	pl->tagline = strbuf_open(0);
+	return pl;
+}
+/**
+ * put_block: write a block and reset the list.
+ *
+ *	@param[in]	pl	POSTLIST structure
+ *	@param[in]	key	tag name
+ *	@param[in]	list	list
+ */
+static void
+put_block(POSTLIST *pl, const char *key, struct list *list)
+{
+	STRBUF *sb = pl->sb;
+
+	strbuf_reset(sb);
+	strbuf_putn(sb, list->first);
+	if (list->last > list->first) {
+		strbuf_putc(sb, '+');
+		strbuf_putn(sb, list->last - list->first);
+	}
+	strbuf_putc(sb, ' ');
+	strbuf_puts(sb, list->name);
+	strbuf_putc(sb, ' ');
+	if (list->skip && strbuf_getlen(list->skip) > 0) {
+		strbuf_putc(sb, '*');
+		strbuf_puts(sb, strbuf_value(list->skip));
+		strbuf_putc(sb, ' ');
+		strbuf_reset(list->skip);
+	}
+	strbuf_puts(sb, strbuf_value(list->entries));
+	dbop_put_tag(pl->dbop, key, strbuf_value(sb));
+	strbuf_reset(list->entries);
+	list->count = 0;
+}
+/**
+ * postlist_put: add a compact record to the posting list of the key.
+ *
+ *	@param[in]	pl	POSTLIST structure
+ *	@param[in]	key	tag name
+ *	@param[in]	tagline	compact record
+ *
+ * The entries are kept in memory until the block is full.
+ * Records should be added in the order of file id.
+ */
+void
+postlist_put(POSTLIST *pl, const char *key, const char *tagline)
+{
+	struct sh_entry *sh;
+	struct list *list;
+	const char *name, *body;
+	char *p;
+	int fid, namelen, bodylen;
+
+	fid = strtol(tagline, &p, 10);
+	if (p == tagline || *p != ' ')
+		die("invalid tag record. '%s'", tagline);
+	name = p + 1;
+	if ((body = strchr(name, ' ')) == NULL)
+		die("invalid tag record. '%s'", tagline);
+	namelen = body - name;
+	body++;
+	bodylen = strlen(body);
+
+	sh = strhash_assign(pl->lists, key, 1);
+	if (sh->value == NULL) {
+		list = pool_malloc(pl->lists->pool, sizeof(struct list));
+		memset(list, 0, sizeof(struct list));
+		list->entries = strbuf_open(0);
+		sh->value = list;
+		pl->size += sizeof(struct sh_entry) + sizeof(struct list) + strlen(key) + INITIALSIZE;
+	}
+	list = (struct list *)sh->value;
+	/*
+	 * Start a new block if the entry cannot be added to the current block.
+	 */
+	if (list->count > 0) {
+		int size = strlen(list->name) + strbuf_getlen(list->entries) + bodylen + 32;
+
+		if (list->skip)
+			size += strbuf_getlen(list->skip);
+		if (fid < list->last || size > pl->blocksize
+		   || strncmp(list->name, name, namelen) || list->name[namelen] != '\0')
+			put_block(pl, key, list);
+	}
+	if (list->count == 0) {
+		if (list->name == NULL || strncmp(list->name, name, namelen) || list->name[namelen] != '\0')
+			list->name = strhash_strdup(pl->lists, name, namelen);
+		list->first = fid;
+	} else {
+		if (list->count % POSTLIST_SKIP == 0) {
+			if (list->skip == NULL) {
+				list->skip = strbuf_open(0);
+				pl->size += INITIALSIZE;
+			}
+			if (strbuf_getlen(list->skip) > 0)
+				strbuf_putc(list->skip, ',');
+			strbuf_putn(list->skip, fid - list->first);
+			strbuf_putc(list->skip, ':');
+			strbuf_putn(list->skip, strbuf_getlen(list->entries) + 1);
+		}
+		strbuf_putc(list->entries, ';');
+		strbuf_putn(list->entries, fid - list->last);
+		strbuf_putc(list->entries, ' ');
+	}
+	strbuf_puts(list->entries, body);
+	list->last = fid;
+	list->count++;
+	pl->size += bodylen + 8;
+}
+/**
+ * postlist_size: memory used for the blocks not written yet.
+ *
+ *	@param[in]	pl	POSTLIST structure
+ *	@return		size in bytes
+ */
+unsigned long
+postlist_size(POSTLIST *pl)
+{
+	return pl->size;
+}
+/**
+ * postlist_flush: write all blocks in memory.
+ *
+ *	@param[in]	pl	POSTLIST structure
+ */
+void
+postlist_flush(POSTLIST *pl)
+{
+	struct sh_entry *sh;
+
+	for (sh = strhash_first(pl->lists); sh; sh = strhash_next(pl->lists)) {
+		struct list *list = (struct list *)sh->value;
+
+		if (list->count > 0)
+			put_block(pl, sh->name, list);
+		strbuf_close(list->entries);
+		if (list->skip)
+			strbuf_close(list->skip);
+	}
+	strhash_reset(pl->lists);
+	pl->size = 0;
+}
+/**
+ * postlist_first: start reading a block.
+ *
+ *	@param[in]	pl	POSTLIST structure
+ *	@param[in]	block	block
+ *	@param[in]	fidset	file ids required or NULL (all)
+ *	@return		compact record of the first entry required,
+ *			NULL: no entry required in the block
+ *
+ * The block is not read if no file id in its range is required.
+ */
+const char *
+postlist_first(POSTLIST *pl, const char *block, IDSET *fidset)
+{
+	const char *name;
+	char *p;
+
+	pl->first = pl->last = strtol(block, &p, 10);
+	if (*p == '+')
+		pl->last += strtol(p + 1, &p, 10);
+	if (p == block || *p != ' ')
+		die("invalid tag record. '%s'", block);
+	if (fidset && !idset_range(fidset, pl->first, pl->last))
+		return NULL;
+	strbuf_reset(pl->block);
+	strbuf_puts(pl->block, block);
+	name = strbuf_value(pl->block) + (p - block) + 1;
+	if ((p = strchr(name, ' ')) == NULL)
+		die("invalid tag record. '%s'", block);
+	pl->name = name;
+	pl->namelen = p - name;
+	p++;
+	pl->skip = NULL;
+	if (*p == '*') {
+		pl->skip = p + 1;
+		if ((p = strchr(p, ' ')) == NULL)
+			die("invalid tag record. '%s'", block);
+		p++;
+	}
+	pl->entries = pl->next = p;
+	pl->fid = pl->first;
+	pl->jump = 0;
+	return postlist_next(pl, fidset);
+}
+/**
+ * skip_entries: skip entries which are not required using skip pointers.
+ *
+ *	@param[in]	pl	POSTLIST structure
+ *	@param[in]	fidset	file ids required
+ *
+ * The file ids of the entries before a skip pointer are from the current
+ * file id to the file id of the skip pointer. If none of them is required,
+ * the entries are skipped.
+ */
+static void
+skip_entries(POSTLIST *pl, IDSET *fidset)
+{
+	const char *s = pl->skip;
+	int pos, offset = -1, fid = 0;
+
+	if (pl->next == NULL)
+		return;
+	if (!idset_range(fidset, pl->fid, pl->last)) {
+		pl->next = NULL;
+		return;
+	}
+	pos = pl->next - pl->entries;
+	while (s && *s) {
+		char *p;
+		int d, o;
+
+		d = strtol(s, &p, 10);
+		if (*p != ':')
+			die("invalid skip pointer. '%s'", pl->skip);
+		o = strtol(p + 1, &p, 10);
+		s = (*p == ',') ? p + 1 : NULL;
+		if (o < pos)
+			continue;
+		if (idset_range(fidset, pl->fid, pl->first + d))
+			break;
+		offset = o;
+		fid = pl->first + d;
+	}
+	if (offset >= pos) {
+		pl->next = pl->entries + offset;
+		pl->jump = fid;
+	}
+}
+/**
+ * postlist_next: read the next entry of the block.
+ *
+ *	@param[in]	pl	POSTLIST structure
+ *	@param[in]	fidset	file ids required or NULL (all)
+ *	@return		compact record of the next entry required,
+ *			NULL: end of block
+ */
+const char *
+postlist_next(POSTLIST *pl, IDSET *fidset)
+{
+	while (pl->next) {
+		const char *body = pl->next, *end;
+		int fid;
+
+		if (body == pl->entries) {
+			fid = pl->first;
+		} else {
+			char *p;
+			int delta = strtol(body, &p, 10);
+
+			if (*p != ' ')
+				die("invalid tag record. '%s'", strbuf_value(pl->block));
+			body = p + 1;
+			fid = pl->jump ? pl->jump : pl->fid + delta;
+		}
+		pl->jump = 0;
+		pl->fid = fid;
+		end = strchr(body, ';');
+		pl->next = end ? end + 1 : NULL;
+		if (fidset && !idset_contains(fidset, fid)) {
+			skip_entries(pl, fidset);
+			continue;
+		}
+		strbuf_reset(pl->tagline);
+		strbuf_putn(pl->tagline, fid);
+		strbuf_putc(pl->tagline, ' ');
+		strbuf_nputs(pl->tagline, pl->name, pl->namelen);
+		strbuf_putc(pl->tagline, ' ');
+		if (end)
+			strbuf_nputs(pl->tagline, body, end - body);
+		else
+			strbuf_puts(pl->tagline, body);
+		return strbuf_value(pl->tagline);
+	}
+	return NULL;
+}
+/**
+ * postlist_close: close posting lists.
+ *
+ *	@param[in]	pl	POSTLIST structure
+ *
+ * The blocks in memory are not written. Call postlist_flush() before.
+ */
+void
+postlist_close(POSTLIST *pl)
+{
+	if (pl->lists) {
+		struct sh_entry *sh;
+
+		for (sh = strhash_first(pl->lists); sh; sh = strhash_next(pl->lists)) {
+			struct list *list = (struct list *)sh->value;
+
+			strbuf_close(list->entries);
+			if (list->skip)
+				strbuf_close(list->skip);
+		}
+		strhash_close(pl->lists);
+	}
+	if (pl->sb)
+		strbuf_close(pl->sb);
+	strbuf_close(pl->block);
+	strbuf_close(pl->tagline);
+	free(pl);
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _POSTLIST_H_
+#define _POSTLIST_H_
+
+#include "dbop.h"
+#include "idset.h"
+#include "strbuf.h"
+#include "strhash.h"
+
+/*
+ * A skip pointer is put every POSTLIST_SKIP entries of a block.
+ */
+#define POSTLIST_SKIP	16
+
+typedef struct {
+	/*
+	 * writer
+	 */
+	DBOP *dbop;			/**< tag file */
+	int blocksize;			/**< max size of a block */
+	STRHASH *lists;			/**< open blocks by the key */
+	unsigned long size;		/**< memory used for the open blocks */
+	STRBUF *sb;			/**< working area */
+	/*
+	 * reader
+	 */
+	STRBUF *block;			/**< copy of the current block */
+	STRBUF *tagline;		/**< tag line made from an entry */
+	const char *name;		/**< name in the block */
+	int namelen;
+	const char *skip;		/**< skip pointers or NULL */
+	const char *entries;		/**< the first entry */
+	const char *next;		/**< the next entry, NULL: end of block */
+	int first;			/**< file id of the first entry */
+	int last;			/**< file id of the last entry */
+	int fid;			/**< file id of the current entry */
+	int jump;			/**< file id after a jump, 0: none */
+} POSTLIST;
+
+POSTLIST *postlist_open(DBOP *, int);
+void postlist_put(POSTLIST *, const char *, const char *);
+unsigned long postlist_size(POSTLIST *);
+void postlist_flush(POSTLIST *);
+const char *postlist_first(POSTLIST *, const char *, IDSET *);
+const char *postlist_next(POSTLIST *, IDSET *);
+void postlist_close(POSTLIST *);
+
+#endif /* ! _POSTLIST_H_ */
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+
+#include "strbuf.h"
+#include "subword.h"
+
+/*
+ * Subwords of a name.
+ *
+ * A name is split at non-alphanumeric characters like '_', at the
+ * boundaries between letters and digits, and at the camelCase boundaries.
+ * Subwords are folded to lower case.
+ *
+ *	getRxBufferSize		get rx buffer size
+ *	HTTPServer_init2	http server init 2
+ *
+ * Only ASCII characters are classified so that the result doesn't depend
+ * on the locale; other bytes are treated as separators.
+ */
+#define IS_UPPER(c)	((c) >= 'A' && (c) <= 'Z')
+#define IS_LOWER(c)	((c) >= 'a' && (c) <= 'z')
+#define IS_DIGIT(c)	((c) >= '0' && (c) <= '9')
+#define IS_ALNUM(c)	(IS_UPPER(c) || IS_LOWER(c) || IS_DIGIT(c))
+
+/**
+ * subword_split: split a name into subwords.
+ *
+ *	@param[in]	name	name
+ *	@param[out]	sb	subwords, each followed by '\0'
+ *	@return		number of subwords
+ */
+int
+subword_split(const char *name, STRBUF *sb)
+{
+	const unsigned char *p = (const unsigned char *)name;
+	int count = 0, len = 0;
+
+	for (; *p; p++) {
+		int c = *p;
+
+		if (!IS_ALNUM(c)) {
+			if (len > 0) {
+				strbuf_putc(sb, '\0');
+				count++;
+				len = 0;
+			}
+			continue;
+		}
+		if (len > 0) {
+			int prev = p[-1];
+
+			if (IS_DIGIT(prev) != IS_DIGIT(c)
+			    || (IS_LOWER(prev) && IS_UPPER(c))
+			    || (IS_UPPER(prev) && IS_UPPER(c) && IS_LOWER(p[1]))) {
+				strbuf_putc(sb, '\0');
+				count++;
+				len = 0;
+			}
+		}
+		strbuf_putc(sb, IS_UPPER(c) ? c - 'A' + 'a' : c);
+		len++;
+	}
+	if (len > 0) {
+		strbuf_putc(sb, '\0');
+		count++;
+	}
+	return count;
+}
+/**
+ * subword_match: whether the subwords of the query appear in the name in a row.
+ *
+ *	@param[in]	name	name
+ *	@param[in]	query	query
+ *	@return		1: match, 0: not match
+ *
+ * For example, 'buffer' and 'RxBuffer' match to 'getRxBufferSize',
+ * but 'Buf' and 'getSize' don't.
+ */
+int
+subword_match(const char *name, const char *query)
+{
+	STATIC_STRBUF(nb);
+	STATIC_STRBUF(qb);
+	const char *n, *nend, *q, *qend;
+	int ncount, qcount;
+
+	strbuf_clear(nb);
+	strbuf_clear(qb);
+	ncount = subword_split(name, nb);
+	qcount = subword_split(query, qb);
+	if (qcount == 0 || qcount > ncount)
+		return 0;
+	nend = strbuf_value(nb) + strbuf_getlen(nb);
+	qend = strbuf_value(qb) + strbuf_getlen(qb);
+	for (n = strbuf_value(nb); ncount >= qcount; n += strlen(n) + 1, ncount--) {
+		const char *s = n;
+
+		for (q = strbuf_value(qb); q < qend && s < nend; q += strlen(q) + 1, s += strlen(s) + 1)
+			if (strcmp(q, s))
+				break;
+		if (q >= qend)
+			return 1;
+	}
+	return 0;
+}